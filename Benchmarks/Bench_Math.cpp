@@ -0,0 +1,656 @@
+#include "Benchmark.h"
+
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Matrix.h"
+#include "Math_Transform.h"
+#include "Math_Affine.h"
+#include "Math_Quaternion.h"
+#include "Math_Packed.h"
+#include "Math_Ray.h"
+#include "Math_Arena.h"
+#include "Math_Primitives.h"
+#include "Math_Materials.h"
+#include "Math_TestHelpers.h"
+#include "Graphics.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+namespace
+{
+	const size_t TupleBatch = 4096;
+	const size_t MatrixBatch = 1024;
+	const size_t LargeMatrixBatch = 256;
+	const size_t TransformBatch = 1024;
+	const size_t PointCloudBatch = 1 << 16;
+	const size_t AnimationBatch = 4096;
+	const size_t SceneLoadBatch = 1 << 16;
+	const size_t RayBatch = 4096;
+	const size_t ShadingBatch = 4096;
+	const size_t CanvasSide = 256;
+
+	using Math::TestHelpers::NextRandom;
+
+	float NextSigned(unsigned int& state)
+	{
+		return NextRandom(state) * 2.0f - 1.0f;
+	}
+
+	Math::Vector4<float> NextDirection(unsigned int& state)
+	{
+		auto direction = H::MakeVector(NextSigned(state), NextSigned(state), NextSigned(state) + 2.0f);
+		direction.Normalize();
+		return direction;
+	}
+
+	struct TupleData
+	{
+		std::vector<Math::Vector4<float>> vectors;
+		std::vector<Math::Vector4<float>> otherVectors;
+		std::vector<Math::Point4<float>> points;
+		std::vector<Math::Point4<float>> otherPoints;
+		std::vector<Math::Color4<float>> colors;
+		std::vector<Math::Color4<float>> otherColors;
+		std::vector<Math::Vector4<float>> normalized;
+
+		TupleData()
+		{
+			unsigned int seed = 1u;
+			for (size_t i = 0; i < TupleBatch; ++i)
+			{
+				vectors.push_back(H::MakeVector(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				otherVectors.push_back(H::MakeVector(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				points.push_back(H::MakePoint(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				otherPoints.push_back(H::MakePoint(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				colors.push_back(H::MakeColor(NextRandom(seed), NextRandom(seed), NextRandom(seed)));
+				otherColors.push_back(H::MakeColor(NextRandom(seed), NextRandom(seed), NextRandom(seed)));
+			}
+
+			normalized.resize(TupleBatch);
+		}
+	};
+
+	/* Matrices keep their determinant and inverse once computed, so the timed kernels work on
+	copies restored from pristine ones before every call */
+	struct MatrixData
+	{
+		std::vector<Matrix4f> pristine;
+		std::vector<Math::CachedMatrix<float, 4>> cached;
+		std::vector<Matrix4f> others;
+		std::vector<Math::Affine3x4<float>> affines;
+		std::vector<Math::Affine3x4<float>> otherAffines;
+		std::vector<Math::Point4<float>> points;
+		std::vector<Math::Point4<float>> transformedPoints;
+
+		MatrixData()
+		{
+			unsigned int seed = 2u;
+			for (size_t i = 0; i < MatrixBatch; ++i)
+			{
+				Math::SquareMatrixContents<float, 4> contents;
+				Math::SquareMatrixContents<float, 4> otherContents;
+				for (size_t line = 0; line < 4; ++line)
+				{
+					for (size_t column = 0; column < 4; ++column)
+					{
+						//diagonally dominant, so always invertible
+						contents[line][column] = NextSigned(seed) + (line == column ? 4.0f : 0.0f);
+						otherContents[line][column] = NextSigned(seed);
+					}
+				}
+
+				pristine.push_back(Matrix4f(contents));
+				others.push_back(Matrix4f(otherContents));
+				affines.push_back(Math::Affine3x4<float>({ contents[0], contents[1], contents[2] }));
+				otherAffines.push_back(Math::Affine3x4<float>({ otherContents[0], otherContents[1], otherContents[2] }));
+				points.push_back(H::MakePoint(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+			}
+
+			cached.assign(pristine.begin(), pristine.end());
+			transformedPoints.resize(MatrixBatch);
+		}
+	};
+
+	/* 8x8 systems in double, the size and precision of the calibration fits */
+	struct LargeMatrixData
+	{
+		std::vector<Math::SquareMatrix<double, 8>> matrices;
+		std::vector<std::array<double, 8>> rightHandSides;
+
+		LargeMatrixData()
+		{
+			unsigned int seed = 4u;
+			for (size_t i = 0; i < LargeMatrixBatch; ++i)
+			{
+				Math::SquareMatrixContents<double, 8> contents;
+				std::array<double, 8> rhs;
+				for (size_t line = 0; line < 8; ++line)
+				{
+					rhs[line] = NextSigned(seed);
+					for (size_t column = 0; column < 8; ++column)
+						contents[line][column] = NextSigned(seed) + (line == column ? 8.0 : 0.0);
+				}
+
+				matrices.push_back(Math::SquareMatrix<double, 8>(contents));
+				rightHandSides.push_back(rhs);
+			}
+		}
+	};
+
+	struct TransformData
+	{
+		std::vector<float> values;
+
+		TransformData()
+		{
+			unsigned int seed = 3u;
+			for (size_t i = 0; i < TransformBatch * 6; ++i)
+				values.push_back(NextSigned(seed));
+		}
+	};
+
+	/* a mesh sized array of points and normals under one transform */
+	struct PointCloudData
+	{
+		Math::Transform<float> transform = Math::Transform<float>::MakeTranslation(1.0f, 2.0f, 3.0f) * Math::Transform<float>::MakeRotation(0.3f, 0.2f, 0.1f);
+		std::vector<Math::Point4<float>> points;
+		std::vector<Math::Vector4<float>> normals;
+		std::vector<Math::Point4<float>> transformedPoints;
+		std::vector<Math::Vector4<float>> transformedNormals;
+		std::vector<Math::Point3<float>> packedPoints;
+		std::vector<Math::Point3<float>> transformedPackedPoints;
+
+		PointCloudData()
+		{
+			unsigned int seed = 5u;
+			for (size_t i = 0; i < PointCloudBatch; ++i)
+			{
+				points.push_back(H::MakePoint(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				normals.push_back(H::MakeVector(NextSigned(seed), NextSigned(seed), NextSigned(seed) + 2.0f).GetNormalized());
+			}
+
+			transformedPoints.resize(PointCloudBatch);
+			transformedNormals.resize(PointCloudBatch);
+			packedPoints.resize(PointCloudBatch);
+			transformedPackedPoints.resize(PointCloudBatch);
+			Math::PackPoints<float>(points, packedPoints);
+		}
+	};
+
+	/* Object transforms of a large scene, inverted once at load */
+	struct SceneLoadData
+	{
+		std::vector<Math::Transform<float>> transforms;
+		Math::Matrix4Batch<float> matrices;
+		Math::Matrix4Batch<float> inverses;
+		std::vector<float> determinants;
+
+		SceneLoadData() : matrices(SceneLoadBatch)
+		{
+			unsigned int seed = 8u;
+			for (size_t i = 0; i < SceneLoadBatch; ++i)
+			{
+				transforms.push_back(
+					Math::Transform<float>::MakeTranslation(NextSigned(seed) * 10.0f, NextSigned(seed) * 10.0f, NextSigned(seed) * 10.0f) *
+					Math::Transform<float>::MakeRotation(NextSigned(seed), NextSigned(seed), NextSigned(seed)) *
+					Math::Transform<float>::MakeScaling(NextSigned(seed) + 2.0f, NextSigned(seed) + 2.0f, NextSigned(seed) + 2.0f));
+				matrices.SetMatrix(i, transforms.back());
+			}
+		}
+	};
+
+	/* Objects animated between two keyed poses, rebuilt every frame */
+	struct AnimationData
+	{
+		std::vector<Math::Vector4<float>> translations;
+		std::vector<Math::Vector4<float>> angles;
+		std::vector<Math::Quaternion<float>> fromRotations;
+		std::vector<Math::Quaternion<float>> toRotations;
+		std::vector<Math::Vector4<float>> scalings;
+		std::vector<Math::Transform<float>> transforms;
+		std::vector<Math::Affine3x4<float>> affines;
+
+		AnimationData()
+		{
+			unsigned int seed = 6u;
+			for (size_t i = 0; i < AnimationBatch; ++i)
+			{
+				translations.push_back(H::MakeVector(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				angles.push_back(H::MakeVector(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				fromRotations.push_back(Math::Quaternion<float>::MakeRotation(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				toRotations.push_back(Math::Quaternion<float>::MakeRotation(NextSigned(seed), NextSigned(seed), NextSigned(seed)));
+				scalings.push_back(H::MakeVector(NextSigned(seed) + 2.0f, NextSigned(seed) + 2.0f, NextSigned(seed) + 2.0f));
+			}
+
+			transforms.resize(AnimationBatch);
+			affines.resize(AnimationBatch);
+		}
+	};
+
+	struct SphereData
+	{
+		Math::Sphere<float> sphere{ 1.0f, H::MakePoint(0.0f, 0.0f, 5.0f) };
+		std::vector<Math::Ray<float>> rays;
+		std::vector<Math::Point4<float>> surfacePoints;
+		std::vector<Math::Vector4<float>> normals;
+		std::vector<Math::Vector4<float>> eyeDirections;
+
+		SphereData()
+		{
+			unsigned int seed = 4u;
+			auto origin = H::MakePoint(0.0f, 0.0f, 0.0f);
+			for (size_t i = 0; i < RayBatch; ++i)
+			{
+				//about half of the rays hit the sphere
+				auto direction = H::MakeVector(NextSigned(seed) * 0.28f, NextSigned(seed) * 0.28f, 1.0f);
+				direction.Normalize();
+				rays.push_back(Math::Ray<float>(origin, direction));
+
+				auto normal = NextDirection(seed);
+				normals.push_back(normal);
+				surfacePoints.push_back(sphere.GetPosition() + normal);
+				eyeDirections.push_back(NextDirection(seed));
+			}
+		}
+	};
+
+	struct ShadingData
+	{
+		std::unique_ptr<Math::PhongMaterial<float>> material{ Math::PhongMaterial<float>::GetDefaultMaterial() };
+		Math::LightOmni<float> light{ H::MakePoint(-10.0f, 10.0f, -10.0f), H::MakeColor(1.0f, 1.0f, 1.0f) };
+		SphereData surface;
+	};
+
+	struct CanvasData
+	{
+		Graphics::Canvas canvas{ CanvasSide, CanvasSide };
+		std::string encoded;
+
+		CanvasData()
+		{
+			unsigned int seed = 5u;
+			for (size_t line = 0; line < CanvasSide; ++line)
+				for (size_t column = 0; column < CanvasSide; ++column)
+					canvas.SetAt(line, column, H::MakeColor(NextRandom(seed), NextRandom(seed), NextRandom(seed)));
+
+			std::ostringstream stream;
+			canvas.WritePPM(stream);
+			encoded = stream.str();
+		}
+	};
+}
+
+namespace Benchmark
+{
+	void RegisterMathBenchmarks(Registry& registry)
+	{
+		auto tuples = std::make_shared<TupleData>();
+
+		registry.Add("Tuple4/Vector add", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i] + tuples->otherVectors[i]);
+		});
+
+		registry.Add("Tuple4/Vector scale", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i] * 1.5f);
+		});
+
+		registry.Add("Tuple4/Vector dot", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i].Dot(tuples->otherVectors[i]));
+		});
+
+		registry.Add("Tuple4/Vector cross", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i].Cross(tuples->otherVectors[i]));
+		});
+
+		registry.Add("Tuple4/Vector normalize", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i].GetNormalized());
+		});
+
+		registry.Add("Tuple4/Vector normalize fast", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->vectors[i].GetNormalizedFast());
+		});
+
+		registry.Add("Tuple4/Vector normalize batch loop", TupleBatch, [tuples]()
+		{
+			std::copy(tuples->vectors.begin(), tuples->vectors.end(), tuples->normalized.begin());
+			for (Math::Vector4<float>& vector : tuples->normalized)
+				vector.Normalize();
+			DoNotOptimize(tuples->normalized.data());
+		});
+
+		registry.Add("Tuple4/NormalizeVectorsFast", TupleBatch, [tuples]()
+		{
+			std::copy(tuples->vectors.begin(), tuples->vectors.end(), tuples->normalized.begin());
+			Math::NormalizeVectorsFast(tuples->normalized.data(), TupleBatch);
+			DoNotOptimize(tuples->normalized.data());
+		});
+
+		registry.Add("Tuple4/Point plus vector", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->points[i] + tuples->vectors[i]);
+		});
+
+		registry.Add("Tuple4/Point minus point", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->points[i] - tuples->otherPoints[i]);
+		});
+
+		registry.Add("Tuple4/Color hadamard", TupleBatch, [tuples]()
+		{
+			for (size_t i = 0; i < TupleBatch; ++i)
+				DoNotOptimize(tuples->colors[i] * tuples->otherColors[i]);
+		});
+
+		auto matrices = std::make_shared<MatrixData>();
+
+		registry.Add("SquareMatrix4/multiply", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->pristine[i] * matrices->others[i]);
+		});
+
+		registry.Add("SquareMatrix4/point multiply", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->points[i] * matrices->pristine[i]);
+		});
+
+		registry.Add("SquareMatrix4/batch point multiply", MatrixBatch, [matrices]()
+		{
+			std::vector<Math::Point4<float>>& points = matrices->transformedPoints;
+			Math::MultiplyPoints(matrices->pristine[0], matrices->points.data(), points.data(), MatrixBatch);
+			DoNotOptimize(points.data());
+		});
+
+		registry.Add("SquareMatrix4/determinant", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->pristine[i].GetDeterminant());
+		});
+
+		registry.Add("SquareMatrix4/inverse", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->pristine[i].GetInverse());
+		});
+
+		registry.Add("SquareMatrix4/inverse cached", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->cached[i].GetInverse());
+		});
+
+		registry.Add("Affine3x4/compose", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->affines[i] * matrices->otherAffines[i]);
+		});
+
+		registry.Add("Affine3x4/point transform", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->affines[i].TransformPoint(matrices->points[i]));
+		});
+
+		registry.Add("Affine3x4/inverse", MatrixBatch, [matrices]()
+		{
+			for (size_t i = 0; i < MatrixBatch; ++i)
+				DoNotOptimize(matrices->affines[i].GetInverse());
+		});
+
+		auto scene = std::make_shared<SceneLoadData>();
+
+		registry.Add("SceneLoad/GetInverse loop", SceneLoadBatch, [scene]()
+		{
+			for (size_t i = 0; i < SceneLoadBatch; ++i)
+				DoNotOptimize(scene->transforms[i].GetInverse());
+		});
+
+		registry.Add("SceneLoad/InvertMatrices4", SceneLoadBatch, [scene]()
+		{
+			Math::InvertMatrices4(scene->matrices, scene->inverses, scene->determinants);
+			DoNotOptimize(scene->determinants.data());
+		});
+
+		registry.Add("SceneLoad/InvertMatrices4 par", SceneLoadBatch, [scene]()
+		{
+			Math::InvertMatrices4(std::execution::par, scene->matrices, scene->inverses, scene->determinants);
+			DoNotOptimize(scene->determinants.data());
+		});
+
+		registry.Add("SceneLoad/CachedTransform loop", SceneLoadBatch, [scene]()
+		{
+			std::vector<Math::CachedTransform<float>> cached;
+			cached.reserve(SceneLoadBatch);
+			for (size_t i = 0; i < SceneLoadBatch; ++i)
+				cached.emplace_back(scene->transforms[i]);
+			DoNotOptimize(cached.data());
+		});
+
+		registry.Add("SceneLoad/CachedTransform MakeBatch par", SceneLoadBatch, [scene]()
+		{
+			auto cached = Math::CachedTransform<float>::MakeBatch(std::execution::par, scene->transforms);
+			DoNotOptimize(cached.data());
+		});
+
+		auto largeMatrices = std::make_shared<LargeMatrixData>();
+
+		registry.Add("SquareMatrix8/determinant", LargeMatrixBatch, [largeMatrices]()
+		{
+			for (size_t i = 0; i < LargeMatrixBatch; ++i)
+				DoNotOptimize(largeMatrices->matrices[i].GetDeterminant());
+		});
+
+		registry.Add("SquareMatrix8/solve", LargeMatrixBatch, [largeMatrices]()
+		{
+			std::array<double, 8> solution;
+			for (size_t i = 0; i < LargeMatrixBatch; ++i)
+			{
+				DoNotOptimize(largeMatrices->matrices[i].Solve(largeMatrices->rightHandSides[i], solution));
+				DoNotOptimize(solution);
+			}
+		});
+
+		registry.Add("SquareMatrix8/inverse", LargeMatrixBatch, [largeMatrices]()
+		{
+			for (size_t i = 0; i < LargeMatrixBatch; ++i)
+				DoNotOptimize(largeMatrices->matrices[i].GetInverse());
+		});
+
+		auto transforms = std::make_shared<TransformData>();
+
+		registry.Add("Transform/MakeTranslation", TransformBatch, [transforms]()
+		{
+			const float* values = transforms->values.data();
+			for (size_t i = 0; i < TransformBatch; ++i)
+				DoNotOptimize(Math::Transform<float>::MakeTranslation(values[i * 6], values[i * 6 + 1], values[i * 6 + 2]));
+		});
+
+		registry.Add("Transform/MakeScaling", TransformBatch, [transforms]()
+		{
+			const float* values = transforms->values.data();
+			for (size_t i = 0; i < TransformBatch; ++i)
+				DoNotOptimize(Math::Transform<float>::MakeScaling(values[i * 6], values[i * 6 + 1], values[i * 6 + 2]));
+		});
+
+		registry.Add("Transform/MakeRotation", TransformBatch, [transforms]()
+		{
+			const float* values = transforms->values.data();
+			for (size_t i = 0; i < TransformBatch; ++i)
+				DoNotOptimize(Math::Transform<float>::MakeRotation(values[i * 6], values[i * 6 + 1], values[i * 6 + 2]));
+		});
+
+		registry.Add("Transform/MakeShearing", TransformBatch, [transforms]()
+		{
+			const float* values = transforms->values.data();
+			for (size_t i = 0; i < TransformBatch; ++i)
+				DoNotOptimize(Math::Transform<float>::MakeShearing(values[i * 6], values[i * 6 + 1], values[i * 6 + 2], values[i * 6 + 3], values[i * 6 + 4], values[i * 6 + 5]));
+		});
+
+		auto cloud = std::make_shared<PointCloudData>();
+
+		registry.Add("Transform/point operator* loop", PointCloudBatch, [cloud]()
+		{
+			for (size_t i = 0; i < PointCloudBatch; ++i)
+				cloud->transformedPoints[i] = cloud->points[i] * cloud->transform;
+
+			DoNotOptimize(cloud->transformedPoints.data());
+		});
+
+		registry.Add("Transform/TransformPoints", PointCloudBatch, [cloud]()
+		{
+			cloud->transform.TransformPoints(cloud->points, cloud->transformedPoints);
+			DoNotOptimize(cloud->transformedPoints.data());
+		});
+
+		registry.Add("Transform/TransformPoints par", PointCloudBatch, [cloud]()
+		{
+			cloud->transform.TransformPoints(std::execution::par, cloud->points, cloud->transformedPoints);
+			DoNotOptimize(cloud->transformedPoints.data());
+		});
+
+		registry.Add("Transform/TransformNormals", PointCloudBatch, [cloud]()
+		{
+			cloud->transform.TransformNormals(cloud->normals, cloud->transformedNormals);
+			DoNotOptimize(cloud->transformedNormals.data());
+		});
+
+		registry.Add("Transform/TransformPackedPoints", PointCloudBatch, [cloud]()
+		{
+			Math::TransformPackedPoints<float>(cloud->transform, cloud->packedPoints, cloud->transformedPackedPoints);
+			DoNotOptimize(cloud->transformedPackedPoints.data());
+		});
+
+		registry.Add("Packed/PackPoints", PointCloudBatch, [cloud]()
+		{
+			Math::PackPoints<float>(cloud->points, cloud->transformedPackedPoints);
+			DoNotOptimize(cloud->transformedPackedPoints.data());
+		});
+
+		registry.Add("Packed/UnpackPoints", PointCloudBatch, [cloud]()
+		{
+			Math::UnpackPoints<float>(cloud->packedPoints, cloud->transformedPoints);
+			DoNotOptimize(cloud->transformedPoints.data());
+		});
+
+		registry.Add("Transform/compose TRS", TransformBatch, [transforms]()
+		{
+			const float* values = transforms->values.data();
+			for (size_t i = 0; i < TransformBatch; ++i)
+			{
+				auto translation = Math::Transform<float>::MakeTranslation(values[i * 6], values[i * 6 + 1], values[i * 6 + 2]);
+				auto rotation = Math::Transform<float>::MakeRotation(values[i * 6 + 3], values[i * 6 + 4], values[i * 6 + 5]);
+				auto scaling = Math::Transform<float>::MakeScaling(2.0f, 2.0f, 2.0f);
+				DoNotOptimize(translation * rotation * scaling);
+			}
+		});
+
+		auto animation = std::make_shared<AnimationData>();
+
+		registry.Add("Animation/TRS transforms", AnimationBatch, [animation]()
+		{
+			for (size_t i = 0; i < AnimationBatch; ++i)
+			{
+				const Math::Vector4<float>& translation = animation->translations[i];
+				const Math::Vector4<float>& angles = animation->angles[i];
+				const Math::Vector4<float>& scaling = animation->scalings[i];
+
+				animation->transforms[i] =
+					Math::Transform<float>::MakeTranslation(H::Get(translation, C::X), H::Get(translation, C::Y), H::Get(translation, C::Z)) *
+					Math::Transform<float>::MakeRotation(H::Get(angles, C::X), H::Get(angles, C::Y), H::Get(angles, C::Z)) *
+					Math::Transform<float>::MakeScaling(H::Get(scaling, C::X), H::Get(scaling, C::Y), H::Get(scaling, C::Z));
+			}
+			DoNotOptimize(animation->transforms.data());
+		});
+
+		registry.Add("Animation/slerp TRS affines", AnimationBatch, [animation]()
+		{
+			for (size_t i = 0; i < AnimationBatch; ++i)
+			{
+				auto rotation = Math::Quaternion<float>::Slerp(animation->fromRotations[i], animation->toRotations[i], 0.37f);
+				animation->affines[i] = Math::Affine3x4<float>::MakeTransform(animation->translations[i], rotation, animation->scalings[i]);
+			}
+			DoNotOptimize(animation->affines.data());
+		});
+
+		auto spheres = std::make_shared<SphereData>();
+
+		registry.Add("Ray/Intersect sphere", RayBatch, [spheres]()
+		{
+			for (size_t i = 0; i < RayBatch; ++i)
+				DoNotOptimize(spheres->rays[i].Intersect(&spheres->sphere));
+		});
+
+		registry.Add("Ray/Intersect sphere (arena)", RayBatch, [spheres]()
+		{
+			Math::ArenaScope scope;
+			for (size_t i = 0; i < RayBatch; ++i)
+				DoNotOptimize(spheres->rays[i].Intersect(&spheres->sphere, &scope.GetArena()));
+		});
+
+		registry.Add("Sphere/IntersectClosest", RayBatch, [spheres]()
+		{
+			for (size_t i = 0; i < RayBatch; ++i)
+			{
+				float distance = 0.0f;
+				DoNotOptimize(spheres->sphere.IntersectClosest(spheres->rays[i], 0.0f, std::numeric_limits<float>::max(), distance));
+				DoNotOptimize(distance);
+			}
+		});
+
+		registry.Add("Sphere/GetNormalAtPoint", RayBatch, [spheres]()
+		{
+			for (size_t i = 0; i < RayBatch; ++i)
+				DoNotOptimize(spheres->sphere.GetNormalAtPoint(spheres->surfacePoints[i]));
+		});
+
+		auto shading = std::make_shared<ShadingData>();
+
+		registry.Add("Phong/GetColorOnMaterialAtPoint", ShadingBatch, [shading]()
+		{
+			const SphereData& surface = shading->surface;
+			for (size_t i = 0; i < ShadingBatch; ++i)
+			{
+				DoNotOptimize(Math::GetColorOnMaterialAtPoint(
+					surface.surfacePoints[i], surface.normals[i], shading->material.get(), shading->light,
+					H::MakePoint(0.0f, 0.0f, 0.0f), surface.eyeDirections[i]));
+			}
+		});
+
+		auto canvas = std::make_shared<CanvasData>();
+
+		registry.Add("Canvas/PPM encode (per pixel)", CanvasSide * CanvasSide, [canvas]()
+		{
+			std::ostringstream stream;
+			canvas->canvas.WritePPM(stream);
+			DoNotOptimize(stream);
+		});
+
+		registry.Add("Canvas/PPM decode (per pixel)", CanvasSide * CanvasSide, [canvas]()
+		{
+			std::istringstream stream(canvas->encoded);
+			Graphics::Canvas decoded(CanvasSide, CanvasSide);
+			decoded.ReadPPM(stream);
+			DoNotOptimize(decoded);
+		});
+	}
+}
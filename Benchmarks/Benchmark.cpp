@@ -0,0 +1,201 @@
+#include "Benchmark.h"
+#include "Math_Allocation.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <malloc.h>
+#include <string>
+#endif
+
+namespace Benchmark
+{
+	uint64_t GetAllocationCount() { return Math::Allocations::GetCount(); }
+	uint64_t GetAllocatedBytes() { return Math::Allocations::GetBytes(); }
+
+	namespace
+	{
+#if defined(__linux__)
+		/* A "<key>: <value> kB" line of /proc/self/status, in bytes */
+		uint64_t ReadStatusBytes(const char* key)
+		{
+			std::ifstream status("/proc/self/status");
+			std::string line;
+			size_t keyLength = std::strlen(key);
+			while (std::getline(status, line))
+			{
+				if (line.compare(0, keyLength, key) == 0)
+					return uint64_t(std::strtoull(line.c_str() + keyLength, nullptr, 10)) * 1024;
+			}
+
+			return 0;
+		}
+#endif
+
+		uint64_t GetResidentBytes()
+		{
+#if defined(_WIN32)
+			PROCESS_MEMORY_COUNTERS counters;
+			if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+				return uint64_t(counters.WorkingSetSize);
+
+			return 0;
+#elif defined(__linux__)
+			return ReadStatusBytes("VmRSS:");
+#else
+			return 0;
+#endif
+		}
+
+		bool ResetPeakResidentBytes()
+		{
+#if defined(__linux__) && defined(__GLIBC__)
+			malloc_trim(0);
+#endif
+#if defined(__linux__)
+			//"5" restarts VmHWM at the current resident size, since Linux 4.0
+			std::ofstream clearRefs("/proc/self/clear_refs");
+			clearRefs << "5";
+			clearRefs.flush();
+			return bool(clearRefs);
+#else
+			return false;
+#endif
+		}
+	}
+
+	ResidentMemoryScope::ResidentMemoryScope()
+	{
+		isPeakReset = ResetPeakResidentBytes();
+		startBytes = GetResidentBytes();
+	}
+
+	uint64_t ResidentMemoryScope::GetPeakBytes() const
+	{
+#if defined(__linux__)
+		uint64_t peakBytes = isPeakReset ? ReadStatusBytes("VmHWM:") : GetResidentBytes();
+#else
+		uint64_t peakBytes = GetResidentBytes();
+#endif
+		return peakBytes > startBytes ? peakBytes - startBytes : 0;
+	}
+
+	Result Run(const Case& benchmarkCase, const Options& options)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		std::unique_ptr<HardwareCounters> counters;
+		if (options.hardwareCounters)
+			counters = std::make_unique<HardwareCounters>();
+
+		uint64_t timedCalls = 0;
+		auto timeOnce = [&]()
+		{
+			if (benchmarkCase.setup)
+				benchmarkCase.setup();
+
+			if (counters)
+				counters->Enable();
+
+			auto start = Clock::now();
+			benchmarkCase.body();
+			double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+			if (counters)
+				counters->Disable();
+
+			++timedCalls;
+			return elapsed;
+		};
+
+		//warm up caches and lazily built state, then count the allocations of one call
+		timeOnce();
+
+		if (benchmarkCase.setup)
+			benchmarkCase.setup();
+
+		uint64_t allocationsBefore = GetAllocationCount();
+		uint64_t bytesBefore = GetAllocatedBytes();
+		benchmarkCase.body();
+		double allocations = double(GetAllocationCount() - allocationsBefore);
+		double bytes = double(GetAllocatedBytes() - bytesBefore);
+
+		if (counters)
+			counters->Reset();
+		timedCalls = 0;
+
+		std::vector<double> samples;
+		double minTimeNs = options.minTimeSeconds * 1e9;
+		for (size_t repetition = 0; repetition < std::max<size_t>(options.repetitions, 1); ++repetition)
+		{
+			double elapsed = 0.0;
+			size_t calls = 0;
+			do
+			{
+				elapsed += timeOnce();
+				++calls;
+			} while (elapsed < minTimeNs);
+
+			samples.push_back(elapsed / double(calls * benchmarkCase.batchSize));
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		double batchSize = double(benchmarkCase.batchSize);
+		HardwareCounts counts = counters ? counters->Read() : HardwareCounts();
+		return Result{ benchmarkCase.name, benchmarkCase.batchSize, samples[samples.size() / 2], allocations / batchSize, bytes / batchSize, counts, timedCalls * benchmarkCase.batchSize };
+	}
+
+	void PrintHeader()
+	{
+		std::printf("%-44s %8s %12s %12s %12s", "benchmark", "batch", "ns/op", "allocs/op", "bytes/op");
+		std::printf(" %12s %8s %12s %12s\n", "cycles/op", "IPC", "cache-mis/op", "branch-mis/op");
+	}
+
+	/* The counter columns are always there, "-" where a counter is unavailable, so rows line up with the header */
+	void PrintResult(const Result& result)
+	{
+		std::printf("%-44s %8zu %12.2f %12.3f %12.1f", result.name.c_str(), result.batchSize, result.nsPerOp, result.allocationsPerOp, result.bytesPerOp);
+
+		const HardwareCounts& counts = result.counters;
+		double operations = double(std::max<uint64_t>(result.countedOperations, 1));
+		auto printPerOp = [&](HardwareEvent event, int width)
+		{
+			if (counts.IsAvailable(event))
+				std::printf(" %*.3f", width, double(counts.Get(event)) / operations);
+			else
+				std::printf(" %*s", width, "-");
+		};
+
+		printPerOp(HardwareEvent::Cycles, 12);
+		if (counts.IsAvailable(HardwareEvent::Cycles) && counts.IsAvailable(HardwareEvent::Instructions))
+			std::printf(" %8.2f", counts.GetIPC());
+		else
+			std::printf(" %8s", "-");
+		printPerOp(HardwareEvent::CacheMisses, 12);
+		printPerOp(HardwareEvent::BranchMisses, 12);
+
+		std::printf("\n");
+		std::fflush(stdout);
+	}
+
+	bool ReadOption(const char* argument, const char* name, const char*& value)
+	{
+		size_t length = std::strlen(name);
+		if (std::strncmp(argument, name, length) != 0 || argument[length] != '=')
+			return false;
+
+		value = argument + length + 1;
+		return true;
+	}
+}
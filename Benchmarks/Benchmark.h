@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "HardwareCounters.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace Benchmark
+{
+	/* Allocations counted by the allocation hook linked into the benchmarks, all threads included */
+	uint64_t GetAllocationCount();
+	uint64_t GetAllocatedBytes();
+
+	/* Peak resident memory added since construction. Free heap pages are handed back to the system
+	and the high-water mark is restarted (Linux), so memory of earlier work is not counted; where the
+	mark cannot be restarted, the resident memory when GetPeakBytes is called stands in for the
+	peak. 0 where the platform cannot tell. */
+	class ResidentMemoryScope
+	{
+	private:
+		uint64_t startBytes;
+		bool isPeakReset;
+
+	public:
+		ResidentMemoryScope();
+
+		uint64_t GetPeakBytes() const;
+	};
+
+	/* Keeps the compiler from discarding a value computed by a benchmark body */
+	template<typename T>
+	inline void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static const void* volatile sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#endif
+	}
+
+	struct Options
+	{
+		std::string filter;
+		double minTimeSeconds = 0.2;
+		size_t repetitions = 5;
+		bool hardwareCounters = true;
+	};
+
+	struct Result
+	{
+		std::string name;
+		size_t batchSize;
+		double nsPerOp;
+		double allocationsPerOp;
+		double bytesPerOp;
+		HardwareCounts counters; /*over all the timed calls*/
+		uint64_t countedOperations;
+	};
+
+	/* A body runs batchSize operations per call; results are reported per operation. setup, when
+	present, runs before every call and is neither timed nor counted, for kernels that consume
+	their input (e.g. matrices caching their determinant). */
+	struct Case
+	{
+		std::string name;
+		size_t batchSize;
+		std::function<void()> body;
+		std::function<void()> setup;
+	};
+
+	class Registry
+	{
+	private:
+		std::vector<Case> cases;
+
+	public:
+		void Add(const std::string& name, size_t batchSize, std::function<void()> body, std::function<void()> setup = nullptr)
+		{
+			cases.push_back(Case{ name, batchSize, std::move(body), std::move(setup) });
+		}
+
+		const std::vector<Case>& GetCases() const { return cases; }
+	};
+
+	/* Runs the body until minTimeSeconds is spent, repetitions times, and keeps the median per operation cost */
+	Result Run(const Case& benchmarkCase, const Options& options);
+
+	void PrintHeader();
+	void PrintResult(const Result& result);
+
+	/* Matches "<name>=<value>" and points value past the '=' */
+	bool ReadOption(const char* argument, const char* name, const char*& value);
+
+	void RegisterMathBenchmarks(Registry& registry);
+}
@@ -0,0 +1,151 @@
+#include "HardwareCounters.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Benchmark
+{
+	const char* HardwareCounts::GetName(HardwareEvent event)
+	{
+		switch (event)
+		{
+		case HardwareEvent::Cycles:
+			return "cycles";
+		case HardwareEvent::Instructions:
+			return "instructions";
+		case HardwareEvent::CacheMisses:
+			return "cacheMisses";
+		case HardwareEvent::BranchMisses:
+			return "branchMisses";
+		default:
+			return "unknown";
+		}
+	}
+
+#ifdef __linux__
+	namespace
+	{
+		const uint64_t EventConfigs[size_t(HardwareEvent::Count)] =
+		{
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_MISSES,
+			PERF_COUNT_HW_BRANCH_MISSES,
+		};
+
+		int OpenCounter(uint64_t config, bool followThreads)
+		{
+			perf_event_attr attributes;
+			std::memset(&attributes, 0, sizeof(attributes));
+			attributes.size = sizeof(attributes);
+			attributes.type = PERF_TYPE_HARDWARE;
+			attributes.config = config;
+			attributes.disabled = 1;
+			attributes.exclude_kernel = 1;
+			attributes.exclude_hv = 1;
+			attributes.inherit = followThreads ? 1 : 0;
+			attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+			return int(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+		}
+	}
+
+	HardwareCounters::HardwareCounters(bool followThreads)
+	{
+		int openError = 0;
+		for (size_t event = 0; event < descriptors.size(); ++event)
+		{
+			descriptors[event] = OpenCounter(EventConfigs[event], followThreads);
+			if (descriptors[event] < 0)
+				openError = errno;
+		}
+
+		if (!IsAvailable())
+			error = std::string("perf_event_open: ") + std::strerror(openError);
+	}
+
+	HardwareCounters::~HardwareCounters()
+	{
+		for (int descriptor : descriptors)
+		{
+			if (descriptor >= 0)
+				close(descriptor);
+		}
+	}
+
+	bool HardwareCounters::IsAvailable() const
+	{
+		for (int descriptor : descriptors)
+		{
+			if (descriptor >= 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	void HardwareCounters::Reset()
+	{
+		for (int descriptor : descriptors)
+		{
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		}
+	}
+
+	void HardwareCounters::Enable()
+	{
+		for (int descriptor : descriptors)
+		{
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+
+	void HardwareCounters::Disable()
+	{
+		for (int descriptor : descriptors)
+		{
+			if (descriptor >= 0)
+				ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	HardwareCounts HardwareCounters::Read() const
+	{
+		HardwareCounts counts;
+		for (size_t event = 0; event < descriptors.size(); ++event)
+		{
+			//value, time enabled, time running
+			uint64_t data[3] = {};
+			if (descriptors[event] < 0 || read(descriptors[event], data, sizeof(data)) != ssize_t(sizeof(data)))
+				continue;
+
+			counts.available[event] = true;
+			counts.values[event] = data[2] > 0 && data[2] < data[1] ? uint64_t(double(data[0]) * double(data[1]) / double(data[2])) : data[0];
+		}
+
+		return counts;
+	}
+#else
+	HardwareCounters::HardwareCounters(bool)
+	{
+		descriptors.fill(-1);
+		error = "hardware counters are only read on Linux";
+	}
+
+	HardwareCounters::~HardwareCounters() { }
+	bool HardwareCounters::IsAvailable() const { return false; }
+	void HardwareCounters::Reset() { }
+	void HardwareCounters::Enable() { }
+	void HardwareCounters::Disable() { }
+	HardwareCounts HardwareCounters::Read() const { return HardwareCounts(); }
+#endif
+}
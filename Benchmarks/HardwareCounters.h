@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Benchmark
+{
+	enum class HardwareEvent : int
+	{
+		Cycles = 0,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+		Count
+	};
+
+	/* Totals read from the counters; an event the machine or the kernel does not expose stays unavailable */
+	struct HardwareCounts
+	{
+		std::array<uint64_t, size_t(HardwareEvent::Count)> values{};
+		std::array<bool, size_t(HardwareEvent::Count)> available{};
+
+		bool IsAvailable(HardwareEvent event) const { return available[size_t(event)]; }
+		uint64_t Get(HardwareEvent event) const { return values[size_t(event)]; }
+
+		/* Instructions per cycle, 0 without both counters */
+		double GetIPC() const
+		{
+			if (!IsAvailable(HardwareEvent::Cycles) || !IsAvailable(HardwareEvent::Instructions) || Get(HardwareEvent::Cycles) == 0)
+				return 0.0;
+
+			return double(Get(HardwareEvent::Instructions)) / double(Get(HardwareEvent::Cycles));
+		}
+
+		/* Per event difference, available where both sides are; clamped at 0 as scaled counts are estimates */
+		HardwareCounts operator-(const HardwareCounts& other) const
+		{
+			HardwareCounts difference;
+			for (size_t event = 0; event < values.size(); ++event)
+			{
+				difference.available[event] = available[event] && other.available[event];
+				difference.values[event] = values[event] > other.values[event] ? values[event] - other.values[event] : 0;
+			}
+
+			return difference;
+		}
+
+		static const char* GetName(HardwareEvent event);
+	};
+
+	/* User space cycles, instructions, cache misses and branch misses through perf_event_open, on
+	Linux only. The counters follow the calling thread and, when followThreads is set, the threads
+	it starts while they are enabled; a child's counts are added when it exits, so read after
+	joining. Counting is paused by Disable, so setup work between measured calls stays out. */
+	class HardwareCounters
+	{
+	private:
+		std::array<int, size_t(HardwareEvent::Count)> descriptors;
+		std::string error;
+
+	public:
+		explicit HardwareCounters(bool followThreads = false);
+		~HardwareCounters();
+
+		HardwareCounters(const HardwareCounters&) = delete;
+		HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+		bool IsAvailable() const;
+
+		/* Why no counter could be opened, empty when at least one could */
+		const std::string& GetError() const { return error; }
+
+		void Reset();
+		void Enable();
+		void Disable();
+
+		/* Totals since the last Reset, scaled up when the kernel had to multiplex the counters */
+		HardwareCounts Read() const;
+	};
+}
@@ -0,0 +1,57 @@
+#include "Benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char** argv)
+{
+	Benchmark::Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if (Benchmark::ReadOption(argv[i], "--filter", value))
+			options.filter = value;
+		else if (Benchmark::ReadOption(argv[i], "--min-time", value))
+			options.minTimeSeconds = std::atof(value);
+		else if (Benchmark::ReadOption(argv[i], "--repetitions", value))
+			options.repetitions = size_t(std::atoi(value));
+		else if (std::strcmp(argv[i], "--no-counters") == 0)
+			options.hardwareCounters = false;
+		else if (std::strcmp(argv[i], "--quick") == 0)
+		{
+			options.minTimeSeconds = 0.0;
+			options.repetitions = 1;
+		}
+		else
+		{
+			std::fprintf(stderr, "usage: %s [--filter=<substring>] [--min-time=<seconds>] [--repetitions=<count>] [--no-counters] [--quick]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	Benchmark::Registry registry;
+	Benchmark::RegisterMathBenchmarks(registry);
+
+	if (options.hardwareCounters)
+	{
+		Benchmark::HardwareCounters probe;
+		if (!probe.IsAvailable())
+		{
+			std::printf("no hardware counters (%s)\n", probe.GetError().c_str());
+			options.hardwareCounters = false;
+		}
+	}
+
+	Benchmark::PrintHeader();
+	for (const Benchmark::Case& benchmarkCase : registry.GetCases())
+	{
+		if (!options.filter.empty() && benchmarkCase.name.find(options.filter) == std::string::npos)
+			continue;
+
+		Benchmark::PrintResult(Benchmark::Run(benchmarkCase, options));
+	}
+
+	return 0;
+}
@@ -0,0 +1,790 @@
+#include "Benchmark.h"
+#include "HardwareCounters.h"
+#include "Graphics.h"
+#include "Graphics_Renderer.h"
+#include "Math_Primitives.h"
+#include "Math_Allocation.h"
+#include "Math_Scene.h"
+#include "Math_Trace.h"
+#include "Math_TestHelpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+using H = Math::Helpers;
+
+namespace
+{
+	struct ReferenceScene
+	{
+		Math::TestHelpers::SphereStorage spheres;
+		std::vector<Math::LightOmni<float>> lights;
+		Graphics::Camera camera;
+		Math::Scenef scene;
+
+		Math::Sphere<float>* AddSphere(const Math::Point4f& position, float radius, const Color4f& color)
+		{
+			spheres.push_back(std::make_unique<Math::Sphere<float>>());
+			Math::Sphere<float>* sphere = spheres.back().get();
+			sphere->SetPosition(position);
+			sphere->SetRadius(radius);
+			sphere->SetMaterial(Math::PhongMaterial<float>::GetDefaultMaterial());
+			sphere->GetMaterial()->SetColor(color);
+			return sphere;
+		}
+
+		void BuildScene()
+		{
+			scene.AddGroup(Math::TestHelpers::GetPointers(spheres));
+		}
+	};
+
+	using Math::TestHelpers::NextRandom;
+
+	const float FieldOfView = 3.14159265f / 3.0f;
+
+	std::unique_ptr<ReferenceScene> MakeSingleSphere()
+	{
+		auto reference = std::make_unique<ReferenceScene>();
+		reference->AddSphere(H::MakePoint(0.0f, 0.0f, 0.0f), 1.0f, H::MakeColor(1.0f, 0.2f, 1.0f));
+		reference->lights.emplace_back(H::MakePoint(-10.0f, 10.0f, -10.0f), H::MakeColor(1.0f, 1.0f, 1.0f));
+		reference->camera = Graphics::Camera{ H::MakePoint(0.0f, 0.0f, -3.0f), H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 1.0f, 0.0f), FieldOfView };
+		return reference;
+	}
+
+	/* A cube of similar spheres, which the scene accelerates with a uniform grid */
+	std::unique_ptr<ReferenceScene> MakeSpheres10k()
+	{
+		auto reference = std::make_unique<ReferenceScene>();
+		unsigned int seed = 7u;
+		for (size_t i = 0; i < 10000; ++i)
+		{
+			auto position = H::MakePoint(NextRandom(seed) * 100.0f - 50.0f, NextRandom(seed) * 100.0f - 50.0f, NextRandom(seed) * 100.0f - 50.0f);
+			float radius = 0.4f + NextRandom(seed) * 0.3f;
+			reference->AddSphere(position, radius, H::MakeColor(NextRandom(seed), NextRandom(seed), NextRandom(seed)));
+		}
+
+		reference->lights.emplace_back(H::MakePoint(-100.0f, 100.0f, -100.0f), H::MakeColor(1.0f, 1.0f, 1.0f));
+		reference->camera = Graphics::Camera{ H::MakePoint(0.0f, 0.0f, -90.0f), H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 1.0f, 0.0f), FieldOfView };
+		return reference;
+	}
+
+	/* A ring of spheres on a floor lit by many lights, so shading and shadow rays dominate */
+	std::unique_ptr<ReferenceScene> MakeManyLights()
+	{
+		const size_t sphereCount = 48;
+		const size_t lightCount = 64;
+		const float tau = 2.0f * 3.14159265f;
+
+		auto reference = std::make_unique<ReferenceScene>();
+		reference->AddSphere(H::MakePoint(0.0f, -1001.0f, 0.0f), 1000.0f, H::MakeColor(0.8f, 0.8f, 0.8f));
+
+		for (size_t i = 0; i < sphereCount; ++i)
+		{
+			float angle = tau * float(i) / float(sphereCount);
+			reference->AddSphere(H::MakePoint(std::cos(angle) * 8.0f, 0.0f, std::sin(angle) * 8.0f), 0.8f, H::MakeColor(0.9f, 0.5f, 0.2f));
+		}
+
+		for (size_t i = 0; i < lightCount; ++i)
+		{
+			float angle = tau * float(i) / float(lightCount);
+			float intensity = 2.0f / float(lightCount);
+			reference->lights.emplace_back(H::MakePoint(std::cos(angle) * 20.0f, 10.0f + float(i % 4) * 5.0f, std::sin(angle) * 20.0f), H::MakeColor(intensity, intensity, intensity));
+		}
+
+		reference->camera = Graphics::Camera{ H::MakePoint(0.0f, 12.0f, -20.0f), H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 1.0f, 0.0f), FieldOfView };
+		return reference;
+	}
+
+	/* The scene makers only place objects; the acceleration structures are built by BuildScene, which
+	main counts as the build phase */
+	struct SceneEntry
+	{
+		const char* name;
+		std::unique_ptr<ReferenceScene>(*make)();
+	};
+
+	const SceneEntry Scenes[] =
+	{
+		{ "single_sphere", MakeSingleSphere },
+		{ "spheres_10k", MakeSpheres10k },
+		{ "many_lights", MakeManyLights },
+	};
+
+	struct Options
+	{
+		std::string sceneFilter;
+		size_t width = 320;
+		size_t height = 180;
+		size_t frames = 16;
+		std::vector<size_t> threadCounts;
+		std::string outputPath;
+		std::string baselinePath;
+		double tolerance = 0.10;
+		double memoryTolerance = 0.25;
+		double workTolerance = 0.02;
+		bool timingGate = true; /*off when the baseline comes from another machine*/
+		bool printStatistics = false;
+		std::string heatmapPrefix;
+		std::string tracePath;
+		bool hardwareCounters = true;
+		int64_t maxFrameAllocations = -1; /*gate, off when negative*/
+		Graphics::HeatmapMetric heatmapMetric = Graphics::HeatmapMetric::Work;
+	};
+
+	struct RenderResult
+	{
+		std::string name;
+		std::string scene;
+		size_t width;
+		size_t height;
+		size_t threads;
+		size_t frames;
+		uint64_t raysPerFrame;
+		Math::RenderStatistics statistics; /*of the last timed frame*/
+		uint64_t maxFrameAllocations; /*over the timed frames*/
+		uint64_t sceneLoadAllocations;
+		uint64_t sceneLoadBytes;
+		double raysPerSecond;
+		double frameTimeMs[5]; /*min, p50, p90, p99, max*/
+		uint64_t sceneResidentBytes; /*peak resident memory added by the scene, its load included*/
+		Benchmark::HardwareCounts counters; /*over the timed frames, every render thread*/
+
+		/* Render phases: building the acceleration structures once, and the timed frames split into
+		the traversal of the primary rays (measured by as many frames without shading) and the rest,
+		i.e. shading and its shadow rays. Counting around every traversal or shading call would cost
+		a system call each, so the split comes from whole frames. */
+		Benchmark::HardwareCounts buildCounters;
+		Benchmark::HardwareCounts traversalCounters;
+		Benchmark::HardwareCounts GetShadingCounters() const { return counters - traversalCounters; }
+	};
+
+	enum class Phase : int
+	{
+		Build = 0,
+		Traversal,
+		Shading,
+		Count
+	};
+
+	const char* PhaseKeys[size_t(Phase::Count)] = { "build", "traversal", "shading" };
+
+	Benchmark::HardwareCounts GetPhaseCounters(const RenderResult& result, Phase phase)
+	{
+		switch (phase)
+		{
+		case Phase::Build:
+			return result.buildCounters;
+		case Phase::Traversal:
+			return result.traversalCounters;
+		default:
+			return result.GetShadingCounters();
+		}
+	}
+
+	/* Counts of run on the calling thread and the threads it starts. Threads of a pool started
+	earlier, like the ones of the parallel algorithms, are not followed. */
+	template<typename Run>
+	Benchmark::HardwareCounts CountPhase(Run&& run)
+	{
+		Benchmark::HardwareCounters counters(true);
+		counters.Reset();
+		counters.Enable();
+		run();
+		counters.Disable();
+		return counters.Read();
+	}
+
+	const char* FrameTimeKeys[5] = { "min", "p50", "p90", "p99", "max" };
+
+	const char* CounterKeys[] = { "primaryRays", "shadowRays", "sphereTests", "bvhNodeVisits", "gridCellVisits", "shadingCalls", "matrixInversions", "allocations", "allocatedBytes" };
+	static_assert(sizeof(CounterKeys) / sizeof(CounterKeys[0]) == size_t(Math::Counter::Count), "one JSON key per render counter");
+
+	/* Nearest rank percentile of sorted samples */
+	double Percentile(const std::vector<double>& sorted, double percentile)
+	{
+		size_t rank = size_t(std::ceil(percentile / 100.0 * double(sorted.size())));
+		return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+	}
+
+	RenderResult RunScene(const SceneEntry& entry, ReferenceScene& reference, size_t threadCount, const Options& options)
+	{
+		Graphics::Renderer renderer(reference.scene, reference.camera);
+		for (const auto& light : reference.lights)
+			renderer.AddLight(light);
+
+		Graphics::Canvas canvas(options.width, options.height);
+		Graphics::RenderSettings settings;
+		settings.threadCount = threadCount;
+
+		//warm-up frame, not recorded
+		Math::RenderStatistics statistics = renderer.Render(canvas, settings);
+		uint64_t raysPerFrame = statistics.GetRayCount();
+
+		//render threads start within each frame, so the counters follow them and add their counts as they exit
+		std::unique_ptr<Benchmark::HardwareCounters> counters;
+		if (options.hardwareCounters)
+		{
+			counters = std::make_unique<Benchmark::HardwareCounters>(true);
+			counters->Reset();
+		}
+
+		std::vector<double> frameTimes;
+		double totalSeconds = 0.0;
+		uint64_t maxFrameAllocations = 0;
+		for (size_t frame = 0; frame < options.frames; ++frame)
+		{
+			if (counters)
+				counters->Enable();
+
+			auto start = std::chrono::steady_clock::now();
+			statistics = renderer.Render(canvas, settings);
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (counters)
+				counters->Disable();
+
+			frameTimes.push_back(seconds * 1e3);
+			totalSeconds += seconds;
+			maxFrameAllocations = std::max(maxFrameAllocations, statistics.Get(Math::Counter::Allocations));
+		}
+
+		std::sort(frameTimes.begin(), frameTimes.end());
+
+		Benchmark::HardwareCounts traversalCounters;
+		if (counters)
+		{
+			Graphics::RenderSettings traversal = settings;
+			traversal.shading = false;
+			traversalCounters = CountPhase([&]()
+			{
+				for (size_t frame = 0; frame < options.frames; ++frame)
+					renderer.Render(canvas, traversal);
+			});
+		}
+
+		//one more frame for the heatmap, outside of the timings
+		if (!options.heatmapPrefix.empty())
+		{
+			Graphics::Canvas heatmap(options.width, options.height);
+			settings.heatmap = &heatmap;
+			settings.heatmapMetric = options.heatmapMetric;
+			renderer.Render(canvas, settings);
+
+			heatmap.SetFilename(options.heatmapPrefix + entry.name + "_t" + std::to_string(threadCount) + ".ppm");
+			heatmap.WritePPMFile();
+		}
+
+		RenderResult result;
+		result.scene = entry.name;
+		result.name = result.scene + "/" + std::to_string(options.width) + "x" + std::to_string(options.height) + "/t" + std::to_string(threadCount);
+		result.width = options.width;
+		result.height = options.height;
+		result.threads = threadCount;
+		result.frames = options.frames;
+		result.raysPerFrame = raysPerFrame;
+		result.statistics = statistics;
+		result.maxFrameAllocations = maxFrameAllocations;
+		result.raysPerSecond = double(raysPerFrame) * double(options.frames) / totalSeconds;
+		result.frameTimeMs[0] = frameTimes.front();
+		result.frameTimeMs[1] = Percentile(frameTimes, 50.0);
+		result.frameTimeMs[2] = Percentile(frameTimes, 90.0);
+		result.frameTimeMs[3] = Percentile(frameTimes, 99.0);
+		result.frameTimeMs[4] = frameTimes.back();
+		result.counters = counters ? counters->Read() : Benchmark::HardwareCounts();
+		result.traversalCounters = traversalCounters;
+		return result;
+	}
+
+	bool HasHardwareCounters(const RenderResult& result)
+	{
+		for (size_t event = 0; event < size_t(Benchmark::HardwareEvent::Count); ++event)
+		{
+			if (result.counters.IsAvailable(Benchmark::HardwareEvent(event)))
+				return true;
+		}
+
+		return false;
+	}
+
+	double GetPerRay(const RenderResult& result, Benchmark::HardwareEvent event)
+	{
+		return double(result.counters.Get(event)) / double(std::max<uint64_t>(result.raysPerFrame * result.frames, 1));
+	}
+
+	void WriteJson(std::ostream& out, const std::vector<RenderResult>& results)
+	{
+		out << "{\n\t\"benchmark\": \"render\",\n\t\"results\": [";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const RenderResult& result = results[i];
+			out << (i == 0 ? "\n" : ",\n");
+			out << "\t\t{\n";
+			out << "\t\t\t\"name\": \"" << result.name << "\",\n";
+			out << "\t\t\t\"scene\": \"" << result.scene << "\",\n";
+			out << "\t\t\t\"width\": " << result.width << ",\n";
+			out << "\t\t\t\"height\": " << result.height << ",\n";
+			out << "\t\t\t\"threads\": " << result.threads << ",\n";
+			out << "\t\t\t\"frames\": " << result.frames << ",\n";
+			out << "\t\t\t\"raysPerFrame\": " << result.raysPerFrame << ",\n";
+			out << "\t\t\t\"raysPerSecond\": " << result.raysPerSecond << ",\n";
+			out << "\t\t\t\"frameTimeMs\": { ";
+			for (size_t key = 0; key < 5; ++key)
+				out << (key == 0 ? "" : ", ") << "\"" << FrameTimeKeys[key] << "\": " << result.frameTimeMs[key];
+			out << " },\n";
+			out << "\t\t\t\"counters\": { ";
+			for (size_t counter = 0; counter < size_t(Math::Counter::Count); ++counter)
+				out << (counter == 0 ? "" : ", ") << "\"" << CounterKeys[counter] << "\": " << result.statistics.Get(Math::Counter(counter));
+			out << " },\n";
+			if (HasHardwareCounters(result))
+			{
+				out << "\t\t\t\"hardwareCounters\": { \"ipc\": " << result.counters.GetIPC();
+				for (size_t event = 0; event < size_t(Benchmark::HardwareEvent::Count); ++event)
+				{
+					auto hardwareEvent = Benchmark::HardwareEvent(event);
+					if (!result.counters.IsAvailable(hardwareEvent))
+						continue;
+
+					const char* name = Benchmark::HardwareCounts::GetName(hardwareEvent);
+					out << ", \"" << name << "\": " << result.counters.Get(hardwareEvent);
+					out << ", \"" << name << "PerRay\": " << GetPerRay(result, hardwareEvent);
+				}
+				out << ", \"phases\": { ";
+				for (size_t phase = 0; phase < size_t(Phase::Count); ++phase)
+				{
+					Benchmark::HardwareCounts phaseCounters = GetPhaseCounters(result, Phase(phase));
+					out << (phase == 0 ? "" : ", ") << "\"" << PhaseKeys[phase] << "\": { \"ipc\": " << phaseCounters.GetIPC();
+					for (size_t event = 0; event < size_t(Benchmark::HardwareEvent::Count); ++event)
+					{
+						if (phaseCounters.IsAvailable(Benchmark::HardwareEvent(event)))
+							out << ", \"" << Benchmark::HardwareCounts::GetName(Benchmark::HardwareEvent(event)) << "\": " << phaseCounters.values[event];
+					}
+					out << " }";
+				}
+				out << " } },\n";
+			}
+			if (Math::Allocations::IsCounting())
+			{
+				out << "\t\t\t\"allocations\": { \"sceneLoad\": " << result.sceneLoadAllocations << ", \"sceneLoadBytes\": " << result.sceneLoadBytes;
+				out << ", \"maxPerFrame\": " << result.maxFrameAllocations << " },\n";
+			}
+			out << "\t\t\t\"sceneResidentBytes\": " << result.sceneResidentBytes << "\n";
+			out << "\t\t}";
+		}
+		out << "\n\t]\n}\n";
+	}
+
+	/* Reads the scalar leaves of a JSON document into a map keyed by their dotted path,
+	e.g. "results.0.frameTimeMs.p50"; enough to read back the files WriteJson produces. */
+	class JsonFlattener
+	{
+	private:
+		const std::string& text;
+		size_t position = 0;
+
+		void SkipSpaces()
+		{
+			while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position])))
+				++position;
+		}
+
+		void Expect(char character)
+		{
+			SkipSpaces();
+			if (position >= text.size() || text[position] != character)
+				throw std::runtime_error(std::string("malformed JSON, expected '") + character + "'");
+
+			++position;
+		}
+
+		std::string ReadString()
+		{
+			Expect('"');
+			std::string value;
+			while (position < text.size() && text[position] != '"')
+			{
+				if (text[position] == '\\' && position + 1 < text.size())
+					++position;
+
+				value += text[position++];
+			}
+
+			Expect('"');
+			return value;
+		}
+
+		void ReadValue(const std::string& path, std::map<std::string, std::string>& leaves)
+		{
+			SkipSpaces();
+			if (position >= text.size())
+				throw std::runtime_error("malformed JSON, unexpected end");
+
+			std::string prefix = path.empty() ? path : path + ".";
+			char character = text[position];
+			if (character == '{')
+			{
+				++position;
+				SkipSpaces();
+				if (text[position] == '}')
+				{
+					++position;
+					return;
+				}
+
+				do
+				{
+					std::string key = ReadString();
+					Expect(':');
+					ReadValue(prefix + key, leaves);
+					SkipSpaces();
+				} while (text[position++] == ',');
+			}
+			else if (character == '[')
+			{
+				++position;
+				SkipSpaces();
+				if (text[position] == ']')
+				{
+					++position;
+					return;
+				}
+
+				size_t index = 0;
+				do
+				{
+					ReadValue(prefix + std::to_string(index++), leaves);
+					SkipSpaces();
+				} while (text[position++] == ',');
+			}
+			else if (character == '"')
+			{
+				leaves[path] = ReadString();
+			}
+			else
+			{
+				size_t end = position;
+				while (end < text.size() && text[end] != ',' && text[end] != '}' && text[end] != ']' && !std::isspace(static_cast<unsigned char>(text[end])))
+					++end;
+
+				leaves[path] = text.substr(position, end - position);
+				position = end;
+			}
+		}
+
+	public:
+		JsonFlattener(const std::string& setText) : text{ setText } { }
+
+		std::map<std::string, std::string> Read()
+		{
+			std::map<std::string, std::string> leaves;
+			ReadValue("", leaves);
+			return leaves;
+		}
+	};
+
+	/* Baseline metrics by result name */
+	std::map<std::string, std::map<std::string, double>> ReadBaseline(const std::string& path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("cannot open baseline " + path);
+
+		std::stringstream contents;
+		contents << file.rdbuf();
+		std::string text = contents.str();
+		auto leaves = JsonFlattener(text).Read();
+
+		std::map<std::string, std::map<std::string, double>> baseline;
+		for (size_t index = 0; leaves.count("results." + std::to_string(index) + ".name") > 0; ++index)
+		{
+			std::string prefix = "results." + std::to_string(index) + ".";
+			auto& metrics = baseline[leaves[prefix + "name"]];
+			for (const auto& leaf : leaves)
+			{
+				if (leaf.first.compare(0, prefix.size(), prefix) == 0 && leaf.first != prefix + "name" && leaf.first != prefix + "scene")
+					metrics[leaf.first.substr(prefix.size())] = std::atof(leaf.second.c_str());
+			}
+		}
+
+		return baseline;
+	}
+
+	/* Prints one line per metric out of tolerance; returns the number of regressions. Timings and
+	instruction counts depend on the machine; the work counters only on the code and the scene, and
+	memory on the platform, so those can be gated against a baseline recorded elsewhere. */
+	size_t CompareToBaseline(const RenderResult& result, const std::map<std::string, double>& baseline, const Options& options)
+	{
+		//resident memory moves by whole pages and allocator chunks, smaller changes are not regressions
+		const double memorySlackBytes = 1024.0 * 1024.0;
+
+		size_t regressions = 0;
+		auto check = [&](const std::string& metric, double current, double tolerance, bool higherIsBetter, double slack = 0.0)
+		{
+			auto entry = baseline.find(metric);
+			if (entry == baseline.end() || entry->second <= 0.0)
+				return;
+
+			double ratio = current / entry->second;
+			bool regressed = higherIsBetter ? ratio < 1.0 - tolerance : ratio > 1.0 + tolerance;
+			if (!regressed || std::abs(current - entry->second) <= slack)
+				return;
+
+			std::printf("  REGRESSION %s %s: %.4g vs baseline %.4g (%+.1f%%, tolerance %.1f%%)\n", result.name.c_str(), metric.c_str(), current, entry->second, (ratio - 1.0) * 100.0, tolerance * 100.0);
+			++regressions;
+		};
+
+		if (options.timingGate)
+		{
+			check("raysPerSecond", result.raysPerSecond, options.tolerance, true);
+			check("frameTimeMs.p50", result.frameTimeMs[1], options.tolerance, false);
+			check("frameTimeMs.p99", result.frameTimeMs[3], options.tolerance, false);
+			if (result.counters.IsAvailable(Benchmark::HardwareEvent::Instructions))
+				check("hardwareCounters.instructionsPerRay", GetPerRay(result, Benchmark::HardwareEvent::Instructions), options.tolerance, false);
+		}
+
+		check("raysPerFrame", double(result.raysPerFrame), options.workTolerance, false);
+		for (Math::Counter counter : { Math::Counter::SphereTests, Math::Counter::BVHNodeVisits, Math::Counter::GridCellVisits })
+			check(std::string("counters.") + CounterKeys[size_t(counter)], double(result.statistics.Get(counter)), options.workTolerance, false);
+
+		check("sceneResidentBytes", double(result.sceneResidentBytes), options.memoryTolerance, false, memorySlackBytes);
+		return regressions;
+	}
+
+	std::vector<size_t> ParseThreadCounts(const char* value)
+	{
+		std::vector<size_t> threadCounts;
+		std::stringstream list(value);
+		std::string item;
+		while (std::getline(list, item, ','))
+			threadCounts.push_back(size_t(std::atoi(item.c_str())));
+
+		return threadCounts;
+	}
+
+	int PrintUsage(const char* program)
+	{
+		std::fprintf(stderr,
+			"usage: %s [--scene=<substring>] [--resolution=<width>x<height>] [--frames=<count>] [--threads=<n,n,...>]\n"
+			"          [--output=<results.json>] [--baseline=<baseline.json>] [--tolerance=<fraction>] [--memory-tolerance=<fraction>]\n"
+			"          [--work-tolerance=<fraction>] [--no-timing-gate]\n"
+			"          [--stats] [--heatmap=<path prefix>] [--heatmap-metric=work|time]\n"
+			"          [--trace=<trace.json>] [--max-frame-allocations=<count>] [--no-counters] [--quick]\n"
+			"exits with 2 when a result is out of tolerance of the baseline or a frame allocates more than allowed\n", program);
+		return 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* value = nullptr;
+		if (Benchmark::ReadOption(argv[i], "--scene", value))
+			options.sceneFilter = value;
+		else if (Benchmark::ReadOption(argv[i], "--resolution", value))
+		{
+			if (std::sscanf(value, "%zux%zu", &options.width, &options.height) != 2 || options.width == 0 || options.height == 0)
+				return PrintUsage(argv[0]);
+		}
+		else if (Benchmark::ReadOption(argv[i], "--frames", value))
+			options.frames = std::max<size_t>(size_t(std::atoi(value)), 1);
+		else if (Benchmark::ReadOption(argv[i], "--threads", value))
+			options.threadCounts = ParseThreadCounts(value);
+		else if (Benchmark::ReadOption(argv[i], "--output", value))
+			options.outputPath = value;
+		else if (Benchmark::ReadOption(argv[i], "--baseline", value))
+			options.baselinePath = value;
+		else if (Benchmark::ReadOption(argv[i], "--tolerance", value))
+			options.tolerance = std::atof(value);
+		else if (Benchmark::ReadOption(argv[i], "--memory-tolerance", value))
+			options.memoryTolerance = std::atof(value);
+		else if (Benchmark::ReadOption(argv[i], "--work-tolerance", value))
+			options.workTolerance = std::atof(value);
+		else if (std::strcmp(argv[i], "--no-timing-gate") == 0)
+			options.timingGate = false;
+		else if (Benchmark::ReadOption(argv[i], "--heatmap", value))
+			options.heatmapPrefix = value;
+		else if (Benchmark::ReadOption(argv[i], "--heatmap-metric", value))
+		{
+			if (std::strcmp(value, "work") == 0)
+				options.heatmapMetric = Graphics::HeatmapMetric::Work;
+			else if (std::strcmp(value, "time") == 0)
+				options.heatmapMetric = Graphics::HeatmapMetric::Time;
+			else
+				return PrintUsage(argv[0]);
+		}
+		else if (Benchmark::ReadOption(argv[i], "--trace", value))
+			options.tracePath = value;
+		else if (Benchmark::ReadOption(argv[i], "--max-frame-allocations", value))
+			options.maxFrameAllocations = std::atoll(value);
+		else if (std::strcmp(argv[i], "--no-counters") == 0)
+			options.hardwareCounters = false;
+		else if (std::strcmp(argv[i], "--stats") == 0)
+			options.printStatistics = true;
+		else if (std::strcmp(argv[i], "--quick") == 0)
+		{
+			options.width = 64;
+			options.height = 36;
+			options.frames = 3;
+		}
+		else
+			return PrintUsage(argv[0]);
+	}
+
+	if (options.threadCounts.empty())
+	{
+		options.threadCounts.push_back(1);
+		size_t hardwareThreads = std::thread::hardware_concurrency();
+		if (hardwareThreads > 1)
+			options.threadCounts.push_back(hardwareThreads);
+	}
+
+	std::map<std::string, std::map<std::string, double>> baseline;
+	try
+	{
+		if (!options.baselinePath.empty())
+			baseline = ReadBaseline(options.baselinePath);
+	}
+	catch (const std::exception& exception)
+	{
+		std::fprintf(stderr, "%s\n", exception.what());
+		return 1;
+	}
+
+	if (options.hardwareCounters)
+	{
+		Benchmark::HardwareCounters probe;
+		if (!probe.IsAvailable())
+		{
+			std::printf("no hardware counters (%s)\n", probe.GetError().c_str());
+			options.hardwareCounters = false;
+		}
+	}
+
+	std::printf("%-32s %12s %14s %10s %10s %10s %10s\n", "render", "rays/frame", "rays/s", "p50 ms", "p90 ms", "p99 ms", "scene MB");
+
+	if (!options.tracePath.empty())
+	{
+		Math::Trace::SetThreadName("main");
+		Math::Trace::Enable();
+	}
+
+	std::vector<RenderResult> results;
+	size_t regressions = 0;
+	for (const SceneEntry& entry : Scenes)
+	{
+		if (!options.sceneFilter.empty() && std::string(entry.name).find(options.sceneFilter) == std::string::npos)
+			continue;
+
+		//process wide, the scene builds run in parallel
+		Benchmark::ResidentMemoryScope residentMemory;
+		uint64_t allocationsBefore = Math::Allocations::GetCount();
+		uint64_t bytesBefore = Math::Allocations::GetBytes();
+		std::unique_ptr<ReferenceScene> reference;
+		Benchmark::HardwareCounts buildCounters;
+		{
+			TRACE_ZONE("scene load");
+			reference = entry.make();
+			if (options.hardwareCounters)
+				buildCounters = CountPhase([&]() { reference->BuildScene(); });
+			else
+				reference->BuildScene();
+		}
+		uint64_t sceneLoadAllocations = Math::Allocations::GetCount() - allocationsBefore;
+		uint64_t sceneLoadBytes = Math::Allocations::GetBytes() - bytesBefore;
+
+		for (size_t threadCount : options.threadCounts)
+		{
+			RenderResult result = RunScene(entry, *reference, threadCount, options);
+			result.sceneLoadAllocations = sceneLoadAllocations;
+			result.sceneLoadBytes = sceneLoadBytes;
+			result.buildCounters = buildCounters;
+			result.sceneResidentBytes = residentMemory.GetPeakBytes();
+			std::printf("%-32s %12llu %14.4g %10.3f %10.3f %10.3f %10.1f\n", result.name.c_str(), (unsigned long long)result.raysPerFrame, result.raysPerSecond,
+				result.frameTimeMs[1], result.frameTimeMs[2], result.frameTimeMs[3], double(result.sceneResidentBytes) / (1024.0 * 1024.0));
+			if (HasHardwareCounters(result))
+			{
+				std::printf("  %.1f cycles/ray, %.1f instructions/ray, IPC %.2f, %.3f cache misses/ray, %.3f branch misses/ray\n",
+					GetPerRay(result, Benchmark::HardwareEvent::Cycles), GetPerRay(result, Benchmark::HardwareEvent::Instructions), result.counters.GetIPC(),
+					GetPerRay(result, Benchmark::HardwareEvent::CacheMisses), GetPerRay(result, Benchmark::HardwareEvent::BranchMisses));
+
+				for (size_t phase = 0; phase < size_t(Phase::Count); ++phase)
+				{
+					Benchmark::HardwareCounts phaseCounters = GetPhaseCounters(result, Phase(phase));
+					double calls = Phase(phase) == Phase::Build ? 1.0 : double(result.frames);
+					std::printf("  %-10s %14.4g cycles%s, %14.4g instructions%s, IPC %.2f, %.4g cache misses, %.4g branch misses\n", PhaseKeys[phase],
+						double(phaseCounters.Get(Benchmark::HardwareEvent::Cycles)) / calls, calls > 1.0 ? "/frame" : "",
+						double(phaseCounters.Get(Benchmark::HardwareEvent::Instructions)) / calls, calls > 1.0 ? "/frame" : "", phaseCounters.GetIPC(),
+						double(phaseCounters.Get(Benchmark::HardwareEvent::CacheMisses)) / calls, double(phaseCounters.Get(Benchmark::HardwareEvent::BranchMisses)) / calls);
+				}
+			}
+
+			if (Math::Allocations::IsCounting())
+			{
+				std::printf("  scene load %llu allocations (%llu bytes), at most %llu allocations per frame\n", (unsigned long long)result.sceneLoadAllocations,
+					(unsigned long long)result.sceneLoadBytes, (unsigned long long)result.maxFrameAllocations);
+			}
+
+			if (options.maxFrameAllocations >= 0 && result.maxFrameAllocations > uint64_t(options.maxFrameAllocations))
+			{
+				std::printf("  REGRESSION %s allocates %llu times per frame, %lld allowed\n", result.name.c_str(), (unsigned long long)result.maxFrameAllocations, (long long)options.maxFrameAllocations);
+				++regressions;
+			}
+
+			if (options.printStatistics)
+				std::printf("%s", result.statistics.ToString().c_str());
+
+			std::fflush(stdout);
+
+			auto baselineEntry = baseline.find(result.name);
+			if (baselineEntry != baseline.end())
+				regressions += CompareToBaseline(result, baselineEntry->second, options);
+			else if (!options.baselinePath.empty())
+				std::printf("  no baseline for %s\n", result.name.c_str());
+
+			results.push_back(result);
+		}
+	}
+
+	if (!options.tracePath.empty())
+	{
+		Math::Trace::Disable();
+		std::ofstream trace(options.tracePath);
+		Math::Trace::WriteChromeTrace(trace);
+		if (!trace)
+		{
+			std::fprintf(stderr, "cannot write %s\n", options.tracePath.c_str());
+			return 1;
+		}
+	}
+
+	if (!options.outputPath.empty())
+	{
+		std::ofstream output(options.outputPath);
+		WriteJson(output, results);
+		if (!output)
+		{
+			std::fprintf(stderr, "cannot write %s\n", options.outputPath.c_str());
+			return 1;
+		}
+	}
+
+	if (regressions > 0)
+	{
+		std::printf("%zu regression(s)\n", regressions);
+		return 2;
+	}
+
+	return 0;
+}
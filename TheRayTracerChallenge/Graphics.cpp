@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "Graphics.h"
 #include "Math_Tuple.h"
+#include "Math_Trace.h"
 
 #include <sstream>
 #include <array>
@@ -240,16 +241,26 @@ namespace Graphics
 
 	void Canvas::WritePPMFile()
 	{
-		std::ofstream ofs(filename.c_str(), std::ofstream::out);
+		TRACE_ZONE("Canvas::WritePPMFile");
 
-		WritePPMHeader(ofs);
-		WritePPMBody(ofs);
+		std::ofstream ofs(filename.c_str(), std::ofstream::out);
+		WritePPM(ofs);
 	}
 
 	void Canvas::ReadPPMFile()
 	{
 		std::ifstream ifs(filename.c_str(), std::ifstream::in);
+		ReadPPM(ifs);
+	}
 
+	void Canvas::WritePPM(std::ostream& ofs)
+	{
+		WritePPMHeader(ofs);
+		WritePPMBody(ofs);
+	}
+
+	void Canvas::ReadPPM(std::istream& ifs)
+	{
 		GetPPMHeaderInfo(ifs);
 		GetPPMBodyData(ifs);
 	}
@@ -424,7 +435,7 @@ namespace Graphics
 			newCanvas.GetPPMBodyData(stream);
 			
 			//when converting and storing values to integers, precision is lost
-			auto& first = newCanvas.GetAt(2, 1);
+			auto first = newCanvas.GetAt(2, 1);
 			auto second = H::MakeColor(0.0f, 0.498039f, 0.0f, 0.5f);
 			Assert::IsTrue(first == second);
 		}
@@ -446,7 +457,7 @@ namespace Graphics
 			Canvas newCanvas{ width, height };
 			newCanvas.GetPPMBodyData(stream);
 			
-			auto& first = newCanvas.GetAt(0, 0);
+			auto first = newCanvas.GetAt(0, 0);
 			auto second = H::MakeColor(1.0f, 0.0f, 0.0f, 0.5f);
 			Assert::IsTrue(first == second);
 
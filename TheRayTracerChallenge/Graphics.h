@@ -47,12 +47,17 @@ namespace Graphics
 
 	public:
 		Canvas(size_t setWidth, size_t setHeight);
+		size_t GetWidth() const { return width; }
+		size_t GetHeight() const { return height; }
 		Color4f GetAt(size_t line, size_t column);
 		void SetAt(size_t line, size_t column, Color4f value);
 		void SetFilename(std::string setFilename);
 
 		void WritePPMFile();
 		void ReadPPMFile();
+
+		void WritePPM(std::ostream& ofs);
+		void ReadPPM(std::istream& ifs);
 	};
 }
 
@@ -0,0 +1,415 @@
+#include "stdafx.h"
+#include "Graphics_Renderer.h"
+#include "Math_Primitives.h"
+#include "Math_Arena.h"
+#include "Math_Trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <cmath>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define RENDERER_HAS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RENDERER_HAS_RDTSC
+#endif
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+using CI = Math::Helpers::ColorInput;
+
+namespace
+{
+	uint64_t ReadCycleCounter()
+	{
+#ifdef RENDERER_HAS_RDTSC
+		return __rdtsc();
+#else
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	uint64_t GetWork(const Math::RenderStatistics& statistics)
+	{
+		return statistics.Get(Math::Counter::SphereTests) + statistics.Get(Math::Counter::BVHNodeVisits) + statistics.Get(Math::Counter::GridCellVisits);
+	}
+
+	void WriteHeatmap(Graphics::Canvas& heatmap, const std::pmr::vector<float>& costs)
+	{
+		std::pmr::vector<float> sorted(costs, costs.get_allocator());
+		size_t percentileIndex = size_t(float(sorted.size() - 1) * Graphics::Renderer::HeatmapPercentile);
+		std::nth_element(sorted.begin(), sorted.begin() + percentileIndex, sorted.end());
+		float scale = sorted[percentileIndex] > 0.0f ? sorted[percentileIndex] : *std::max_element(costs.begin(), costs.end());
+
+		for (size_t line = 0; line < heatmap.GetHeight(); ++line)
+		{
+			for (size_t column = 0; column < heatmap.GetWidth(); ++column)
+			{
+				float cost = costs[line * heatmap.GetWidth() + column];
+				heatmap.SetAt(line, column, Graphics::Renderer::GetHeatmapColor(scale > 0.0f ? cost / scale : 0.0f));
+			}
+		}
+	}
+}
+
+namespace Graphics
+{
+	Color4f Renderer::GetHeatmapColor(float cost)
+	{
+		static const std::array<std::array<float, 3>, 5> ramp = { {
+			{ 0.0f, 0.0f, 0.0f },
+			{ 0.0f, 0.0f, 1.0f },
+			{ 0.0f, 1.0f, 0.0f },
+			{ 1.0f, 1.0f, 0.0f },
+			{ 1.0f, 0.0f, 0.0f } } };
+
+		float position = std::min(std::max(cost, 0.0f), 1.0f) * float(ramp.size() - 1);
+		size_t stop = std::min(size_t(position), ramp.size() - 2);
+		float blend = position - float(stop);
+
+		const auto& from = ramp[stop];
+		const auto& to = ramp[stop + 1];
+		return H::MakeColor(
+			from[0] + (to[0] - from[0]) * blend,
+			from[1] + (to[1] - from[1]) * blend,
+			from[2] + (to[2] - from[2]) * blend);
+	}
+
+	bool Renderer::IsInShadow(const Math::Point4f& point, const Math::LightOmni<float>& light) const
+	{
+		//unnormalized, so the light sits at distance 1
+		Math::Ray<float> shadowRay{ point, light.GetPosition() - point };
+		Math::Statistics::Increment(Math::Counter::ShadowRays);
+
+		float distance = 1.0f;
+		Math::Object* object = nullptr;
+		return scene.IntersectClosest(shadowRay, distance, object);
+	}
+
+	Color4f Renderer::Shade(const Math::Ray<float>& ray, float distance, Math::Object* object) const
+	{
+		TRACE_ZONE("shading");
+
+		//the scene only holds spheres
+		Math::Sphere<float>* sphere = static_cast<Math::Sphere<float>*>(object);
+
+		auto point = ray.GetPosition(distance);
+		auto normal = sphere->GetNormalAtPoint(point);
+		auto overPoint = point + normal * ShadowBias;
+
+		auto color = H::MakeColor(0.0f, 0.0f, 0.0f);
+		for (const Math::LightOmni<float>& light : lights)
+		{
+			bool inShadow = IsInShadow(overPoint, light);
+			color = color + Math::GetColorOnMaterialAtPoint(point, normal, sphere->GetMaterial().get(), light, camera.position, ray.GetDirection(), inShadow);
+		}
+
+		return color;
+	}
+
+	Math::RenderStatistics Renderer::Render(Canvas& canvas, const RenderSettings& settings) const
+	{
+		const size_t width = canvas.GetWidth();
+		const size_t height = canvas.GetHeight();
+		const size_t tileSize = std::max<size_t>(settings.tileSize, 1);
+		const size_t tilesX = (width + tileSize - 1) / tileSize;
+		const size_t tilesY = (height + tileSize - 1) / tileSize;
+		const size_t tileCount = tilesX * tilesY;
+
+		Canvas* heatmap = settings.heatmap;
+		if (heatmap != nullptr && (heatmap->GetWidth() != width || heatmap->GetHeight() != height))
+			throw std::runtime_error("the heatmap canvas must have the size of the image");
+
+		//frame scratch lives in the calling thread's arena and is given back when Render returns
+		Math::ArenaScope frameScope;
+		std::pmr::vector<float> pixelCosts(heatmap != nullptr ? width * height : 0, &frameScope.GetArena());
+
+		auto forward = camera.target - camera.position;
+		forward.Normalize();
+		auto right = camera.up.Cross(forward);
+		right.Normalize();
+		auto up = forward.Cross(right);
+
+		const float halfHeight = std::tan(camera.fieldOfView / 2.0f);
+		const float halfWidth = halfHeight * float(width) / float(height);
+
+		//the calling thread renders too, so only what this frame adds to its counters is merged
+		Math::StatisticsPhase callerPhase;
+		std::atomic<size_t> nextTile{ 0 };
+		std::mutex statisticsMutex;
+		Math::RenderStatistics frameStatistics;
+
+		auto renderTiles = [&](size_t worker)
+		{
+			//workers are new threads every frame; naming them by index keeps one trace track per worker
+			if (worker > 0 && Math::Trace::IsEnabled())
+				Math::Trace::SetThreadName("render worker " + std::to_string(worker));
+
+			Math::StatisticsPhase workerPhase;
+
+			for (size_t tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1))
+			{
+				TRACE_ZONE("tile render");
+				Math::ArenaScope tileScope;
+
+				size_t lineStart = (tile / tilesX) * tileSize;
+				size_t columnStart = (tile % tilesX) * tileSize;
+				size_t lineEnd = std::min(lineStart + tileSize, height);
+				size_t columnEnd = std::min(columnStart + tileSize, width);
+
+				for (size_t line = lineStart; line < lineEnd; ++line)
+				{
+					float v = (1.0f - 2.0f * (float(line) + 0.5f) / float(height)) * halfHeight;
+					for (size_t column = columnStart; column < columnEnd; ++column)
+					{
+						float u = (2.0f * (float(column) + 0.5f) / float(width) - 1.0f) * halfWidth;
+
+						uint64_t costStart = 0;
+						if (heatmap != nullptr)
+							costStart = settings.heatmapMetric == HeatmapMetric::Work ? GetWork(Math::Statistics::GetThreadStatistics()) : ReadCycleCounter();
+
+						auto direction = forward + right * u + up * v;
+						direction.Normalize();
+						Math::Ray<float> ray{ camera.position, direction };
+						Math::Statistics::Increment(Math::Counter::PrimaryRays);
+
+						float distance = std::numeric_limits<float>::max();
+						Math::Object* object = nullptr;
+						if (scene.IntersectClosest(ray, distance, object))
+							canvas.SetAt(line, column, settings.shading ? Shade(ray, distance, object) : H::MakeColor(1.0f, 1.0f, 1.0f));
+						else
+							canvas.SetAt(line, column, H::MakeColor(0.0f, 0.0f, 0.0f));
+
+						if (heatmap != nullptr)
+						{
+							uint64_t costEnd = settings.heatmapMetric == HeatmapMetric::Work ? GetWork(Math::Statistics::GetThreadStatistics()) : ReadCycleCounter();
+							pixelCosts[line * width + column] = float(costEnd - costStart);
+						}
+					}
+				}
+			}
+
+			if (worker == 0)
+				return;
+
+			Math::RenderStatistics workerFrame = workerPhase.Get();
+			std::lock_guard<std::mutex> lock(statisticsMutex);
+			frameStatistics += workerFrame;
+		};
+
+		size_t threadCount = settings.threadCount > 0 ? settings.threadCount : std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		threadCount = std::min(threadCount, std::max<size_t>(tileCount, 1));
+
+		std::pmr::vector<std::thread> threads(&frameScope.GetArena());
+		threads.reserve(threadCount - 1);
+		for (size_t worker = 1; worker < threadCount; ++worker)
+			threads.emplace_back(renderTiles, worker);
+
+		renderTiles(0);
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		if (heatmap != nullptr && !pixelCosts.empty())
+			WriteHeatmap(*heatmap, pixelCosts);
+
+		frameStatistics += callerPhase.Get();
+		return frameStatistics;
+	}
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Graphics
+{
+	TEST_CLASS(TestGraphicsRenderer)
+	{
+		static Camera MakeCamera()
+		{
+			return Camera{ H::MakePoint(0.0f, 0.0f, -5.0f), H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 1.0f, 0.0f), 3.14159265f / 3.0f };
+		}
+
+	public:
+		TEST_METHOD(Renderer_SingleSphere)
+		{
+			Math::Sphere<float> sphere;
+			sphere.SetPosition(H::MakePoint(0.0f, 0.0f, 0.0f));
+			sphere.SetRadius(1.0f);
+			sphere.SetMaterial(Math::PhongMaterial<float>::GetDefaultMaterial());
+
+			Math::Scenef scene;
+			scene.AddGroup({ &sphere });
+
+			Renderer renderer(scene, MakeCamera());
+			renderer.AddLight(Math::LightOmni<float>(H::MakePoint(-10.0f, 10.0f, -10.0f), H::MakeColor(1.0f, 1.0f, 1.0f)));
+
+			Canvas canvas(33, 21);
+			Math::RenderStatistics statistics = renderer.Render(canvas, RenderSettings{ 1, 8 });
+
+			//every pixel casts a primary ray, every hit one shadow ray and one shading call
+			Assert::IsTrue(statistics.Get(Math::Counter::PrimaryRays) == 33 * 21);
+			Assert::IsTrue(statistics.Get(Math::Counter::ShadowRays) > 0);
+			Assert::IsTrue(statistics.Get(Math::Counter::ShadowRays) < 33 * 21);
+			Assert::IsTrue(statistics.Get(Math::Counter::ShadingCalls) == statistics.Get(Math::Counter::ShadowRays));
+			Assert::IsTrue(statistics.Get(Math::Counter::SphereTests) > 0);
+			Assert::IsTrue(statistics.Get(Math::Counter::BVHNodeVisits) > 0);
+
+			Assert::IsTrue(H::Get(canvas.GetAt(10, 16), CI::R) > 0.1f);
+			Assert::IsTrue(canvas.GetAt(0, 0) == H::MakeColor(0.0f, 0.0f, 0.0f));
+
+			//primary traversal only: the same primary rays and tests, no shading or shadow rays
+			RenderSettings traversal{ 1, 8 };
+			traversal.shading = false;
+			Math::RenderStatistics traversalStatistics = renderer.Render(canvas, traversal);
+			Assert::IsTrue(traversalStatistics.Get(Math::Counter::PrimaryRays) == 33 * 21);
+			Assert::IsTrue(traversalStatistics.Get(Math::Counter::ShadowRays) == 0);
+			Assert::IsTrue(traversalStatistics.Get(Math::Counter::ShadingCalls) == 0);
+			Assert::IsTrue(canvas.GetAt(10, 16) == H::MakeColor(1.0f, 1.0f, 1.0f));
+		}
+
+		TEST_METHOD(Renderer_ShadowsAndThreads)
+		{
+			Math::Sphere<float> front;
+			front.SetPosition(H::MakePoint(0.0f, 0.0f, 0.0f));
+			front.SetRadius(1.0f);
+			front.SetMaterial(Math::PhongMaterial<float>::GetDefaultMaterial());
+
+			Math::Sphere<float> floor;
+			floor.SetPosition(H::MakePoint(0.0f, -101.0f, 0.0f));
+			floor.SetRadius(100.0f);
+			floor.SetMaterial(Math::PhongMaterial<float>::GetDefaultMaterial());
+
+			Math::Scenef scene;
+			scene.AddGroup({ &front, &floor });
+
+			Renderer renderer(scene, MakeCamera());
+			auto light = Math::LightOmni<float>(H::MakePoint(10.0f, 10.0f, 0.0f), H::MakeColor(1.0f, 1.0f, 1.0f));
+			renderer.AddLight(light);
+
+			Canvas single(40, 30);
+			Canvas threaded(40, 30);
+			Math::RenderStatistics singleStatistics = renderer.Render(single, RenderSettings{ 1, 16 });
+			Math::RenderStatistics threadedStatistics = renderer.Render(threaded, RenderSettings{ 4, 7 });
+
+			//starting the worker threads allocates, everything else is counted the same
+			for (size_t counter = 0; counter < size_t(Math::Counter::Allocations); ++counter)
+				Assert::IsTrue(singleStatistics.Get(Math::Counter(counter)) == threadedStatistics.Get(Math::Counter(counter)));
+
+			size_t shadowedPixels = 0;
+			for (size_t line = 0; line < 30; ++line)
+			{
+				for (size_t column = 0; column < 40; ++column)
+				{
+					Assert::IsTrue(single.GetAt(line, column) == threaded.GetAt(line, column));
+
+					//points of the floor that the front sphere hides from the light only get the ambient term
+					float u = (2.0f * (float(column) + 0.5f) / 40.0f - 1.0f) * std::tan(3.14159265f / 6.0f) * 40.0f / 30.0f;
+					float v = (1.0f - 2.0f * (float(line) + 0.5f) / 30.0f) * std::tan(3.14159265f / 6.0f);
+					auto direction = H::MakeVector(u, v, 1.0f);
+					direction.Normalize();
+					Math::Ray<float> ray{ H::MakePoint(0.0f, 0.0f, -5.0f), direction };
+
+					float distance;
+					if (front.IntersectClosest(ray, 0.0f, std::numeric_limits<float>::max(), distance) || !floor.IntersectClosest(ray, 0.0f, std::numeric_limits<float>::max(), distance))
+						continue;
+
+					auto point = ray.GetPosition(distance);
+					Math::Ray<float> shadowRay{ point, light.GetPosition() - point };
+					if (!front.IntersectClosest(shadowRay, 0.0f, 1.0f, distance))
+						continue;
+
+					++shadowedPixels;
+					Assert::IsTrue(std::abs(H::Get(single.GetAt(line, column), CI::R) - 0.1f) < 1e-4f);
+				}
+			}
+
+			Assert::IsTrue(shadowedPixels > 0);
+		}
+
+		TEST_METHOD(Renderer_Heatmap)
+		{
+			Math::Sphere<float> sphere;
+			sphere.SetPosition(H::MakePoint(0.0f, 0.0f, 0.0f));
+			sphere.SetRadius(1.0f);
+			sphere.SetMaterial(Math::PhongMaterial<float>::GetDefaultMaterial());
+
+			Math::Scenef scene;
+			scene.AddGroup({ &sphere });
+
+			Renderer renderer(scene, MakeCamera());
+			renderer.AddLight(Math::LightOmni<float>(H::MakePoint(-10.0f, 10.0f, -10.0f), H::MakeColor(1.0f, 1.0f, 1.0f)));
+
+			Canvas canvas(33, 21);
+			Canvas heatmap(33, 21);
+			RenderSettings settings{ 2, 8 };
+			settings.heatmap = &heatmap;
+			renderer.Render(canvas, settings);
+
+			//rays that miss the bounds of the scene do no work, hits test the sphere and cast a shadow ray
+			Assert::IsTrue(heatmap.GetAt(0, 0) == Renderer::GetHeatmapColor(0.0f));
+			Assert::IsTrue(!(heatmap.GetAt(10, 16) == Renderer::GetHeatmapColor(0.0f)));
+
+			Assert::IsTrue(Renderer::GetHeatmapColor(1.0f) == H::MakeColor(1.0f, 0.0f, 0.0f));
+			Assert::IsTrue(Renderer::GetHeatmapColor(0.25f) == H::MakeColor(0.0f, 0.0f, 1.0f));
+
+			Canvas wrongSize(10, 10);
+			settings.heatmap = &wrongSize;
+			bool thrown = false;
+			try
+			{
+				renderer.Render(canvas, settings);
+			}
+			catch (const std::runtime_error&)
+			{
+				thrown = true;
+			}
+
+			Assert::IsTrue(thrown);
+		}
+
+		TEST_METHOD(Renderer_TraceTiles)
+		{
+			Math::Sphere<float> sphere;
+			sphere.SetPosition(H::MakePoint(0.0f, 0.0f, 0.0f));
+			sphere.SetRadius(1.0f);
+
+			Math::Scenef scene;
+			scene.AddGroup({ &sphere });
+			Renderer renderer(scene, MakeCamera());
+
+			Math::Trace::Clear();
+			Math::Trace::Enable();
+			Canvas canvas(32, 24);
+			renderer.Render(canvas, RenderSettings{ 3, 8 });
+			Math::Trace::Disable();
+
+			std::stringstream json;
+			Math::Trace::WriteChromeTrace(json);
+			std::string text = json.str();
+			Math::Trace::Clear();
+
+			//one zone per tile, 4 x 3 tiles
+			size_t tiles = 0;
+			for (size_t position = text.find("\"tile render\""); position != std::string::npos; position = text.find("\"tile render\"", position + 1))
+				++tiles;
+
+			Assert::IsTrue(tiles == 12);
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Graphics.h"
+#include "Math_Tuple.h"
+#include "Math_Ray.h"
+#include "Math_Materials.h"
+#include "Math_Scene.h"
+#include "Math_Statistics.h"
+#include <vector>
+#include <cstdint>
+
+namespace Graphics
+{
+	/* Pinhole camera; fieldOfView is the vertical angle in radians */
+	struct Camera
+	{
+		Math::Point4f position;
+		Math::Point4f target;
+		Math::Vector4f up;
+		float fieldOfView;
+	};
+
+	/* What a pixel of the heatmap measures. Work counts the sphere tests, BVH node visits and grid
+	cell visits of the pixel, shadow rays included; Time reads the CPU cycle counter (steady clock
+	nanoseconds where there is none) around the pixel, so it also shows shading costs. */
+	enum class HeatmapMetric : int
+	{
+		Work = 0,
+		Time
+	};
+
+	struct RenderSettings
+	{
+		size_t threadCount = 0; /*0 uses every hardware thread*/
+		size_t tileSize = 16;
+		Canvas* heatmap = nullptr; /*when set, receives the false colour cost of every pixel; same size as the image*/
+		HeatmapMetric heatmapMetric = HeatmapMetric::Work;
+		bool shading = true; /*false only traces the primary rays and writes hits white, to measure traversal on its own*/
+	};
+
+	/* Renders a scene of spheres into a canvas, one primary ray per pixel, Phong shading and one
+	shadow ray per light. The canvas is split in square tiles that the render threads pick up in
+	order, so any thread count produces the same image and the same counters. */
+	class Renderer
+	{
+	private:
+		const Math::Scenef& scene;
+		Camera camera;
+		std::vector<Math::LightOmni<float>> lights;
+
+		Color4f Shade(const Math::Ray<float>& ray, float distance, Math::Object* object) const;
+		bool IsInShadow(const Math::Point4f& point, const Math::LightOmni<float>& light) const;
+
+	public:
+		static constexpr float ShadowBias = 1e-3f;
+
+		/* Cost values are scaled so that the 99th percentile reaches the top of the ramp, which keeps a
+		few very expensive pixels from flattening the rest of the map */
+		static constexpr float HeatmapPercentile = 0.99f;
+
+		/* Black through blue, green and yellow to red for a cost in [0, 1] */
+		static Color4f GetHeatmapColor(float cost);
+
+		Renderer(const Math::Scenef& setScene, const Camera& setCamera) : scene{ setScene }, camera{ setCamera } { }
+
+		void SetCamera(const Camera& setCamera) { camera = setCamera; }
+		void AddLight(const Math::LightOmni<float>& light) { lights.push_back(light); }
+		size_t GetLightCount() const { return lights.size(); }
+
+		/* Renders a full frame; returns the counters of every render thread for this frame, merged.
+		The calling thread's share covers the whole call, starting the workers included. */
+		Math::RenderStatistics Render(Canvas& canvas, const RenderSettings& settings = RenderSettings()) const;
+	};
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_BoundingBox.h"
+#include "Math_Ray.h"
+
+namespace Math
+{
+	class Object;
+
+	/* Common interface of the structures that answer "what does this ray hit first" over a group of objects.
+	Intersect returns the same RayHit that Ray<T>::Intersect would return for the closest object,
+	allocated from the given memory resource. */
+	template<typename T>
+	class IAccelerationStructure
+	{
+	public:
+		virtual ~IAccelerationStructure() = default;
+
+		/* tClosest is both the upper bound of the search and the distance of the hit found, if any */
+		virtual bool IntersectClosest(const Ray<T>& ray, T& tClosest, Object*& closestObject) const = 0;
+		virtual BoundingBox<T> GetBounds() const = 0;
+
+		virtual RayHit<T> Intersect(const Ray<T>& ray, std::pmr::memory_resource* resource) const
+		{
+			T tClosest = std::numeric_limits<T>::max();
+			Object* closestObject = nullptr;
+
+			if (!IntersectClosest(ray, tClosest, closestObject))
+				return RayHit<T>(resource);
+
+			return ray.Intersect(closestObject, resource);
+		}
+	};
+}
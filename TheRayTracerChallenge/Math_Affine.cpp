@@ -0,0 +1,231 @@
+#include "stdafx.h"
+#include "Math_Affine.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define AFFINE_USE_SSE
+#endif
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+namespace Math
+{
+	template<typename T>
+	Affine3x4<T>::Affine3x4(const Transform<T>& transform)
+	{
+		for (size_t line = 0; line < 3; ++line)
+			for (size_t column = 0; column < 4; ++column)
+				lines[line][column] = transform.GetValueAt(line, column);
+	}
+
+	template<typename T>
+	Affine3x4<T> Affine3x4<T>::MakeRotation(const T angleX, const T angleY, const T angleZ)
+	{
+		return MakeTransform(H::MakeVector(T(0), T(0), T(0)), Quaternion<T>::MakeRotation(angleX, angleY, angleZ), H::MakeVector(T(1), T(1), T(1)));
+	}
+
+	template<typename T>
+	Affine3x4<T> Affine3x4<T>::MakeTransform(const Vector4<T>& translation, const Quaternion<T>& rotation, const Vector4<T>& scaling)
+	{
+		//scaling is applied first, so it scales the columns of the rotation
+		std::array<std::array<T, 3>, 3> rotationLines = rotation.GetRotationLines();
+		std::array<T, 3> scales = { H::Get(scaling, C::X), H::Get(scaling, C::Y), H::Get(scaling, C::Z) };
+		std::array<T, 3> offsets = { H::Get(translation, C::X), H::Get(translation, C::Y), H::Get(translation, C::Z) };
+
+		std::array<std::array<T, 4>, 3> lines;
+		for (size_t line = 0; line < 3; ++line)
+		{
+			for (size_t column = 0; column < 3; ++column)
+				lines[line][column] = rotationLines[line][column] * scales[column];
+
+			lines[line][3] = offsets[line];
+		}
+
+		return Affine3x4<T>(lines);
+	}
+
+	template<typename T>
+	T Affine3x4<T>::GetDeterminant() const
+	{
+		return
+			lines[0][0] * (lines[1][1] * lines[2][2] - lines[1][2] * lines[2][1]) -
+			lines[0][1] * (lines[1][0] * lines[2][2] - lines[1][2] * lines[2][0]) +
+			lines[0][2] * (lines[1][0] * lines[2][1] - lines[1][1] * lines[2][0]);
+	}
+
+	template<typename T>
+	Affine3x4<T> Affine3x4<T>::GetInverse() const
+	{
+		//judged against the scale of the linear part, so that small uniform scalings stay invertible
+		SquareMatrixContents<T, 3> linear;
+		for (size_t line = 0; line < 3; ++line)
+			for (size_t column = 0; column < 3; ++column)
+				linear[line][column] = lines[line][column];
+
+		T determinant = GetDeterminant();
+		if (IsSingularDeterminant(determinant, SquareMatrix<T, 3>(linear)))
+			return Affine3x4<T>();
+
+		Statistics::Increment(Counter::MatrixInversions);
+
+		//the inverse of the linear part is its adjugate over the determinant; the translation is moved back through it
+		T inverseDeterminant = T(1) / determinant;
+		Affine3x4<T> inverse;
+		auto& result = inverse.lines;
+
+		result[0][0] = (lines[1][1] * lines[2][2] - lines[1][2] * lines[2][1]) * inverseDeterminant;
+		result[0][1] = (lines[0][2] * lines[2][1] - lines[0][1] * lines[2][2]) * inverseDeterminant;
+		result[0][2] = (lines[0][1] * lines[1][2] - lines[0][2] * lines[1][1]) * inverseDeterminant;
+		result[1][0] = (lines[1][2] * lines[2][0] - lines[1][0] * lines[2][2]) * inverseDeterminant;
+		result[1][1] = (lines[0][0] * lines[2][2] - lines[0][2] * lines[2][0]) * inverseDeterminant;
+		result[1][2] = (lines[0][2] * lines[1][0] - lines[0][0] * lines[1][2]) * inverseDeterminant;
+		result[2][0] = (lines[1][0] * lines[2][1] - lines[1][1] * lines[2][0]) * inverseDeterminant;
+		result[2][1] = (lines[0][1] * lines[2][0] - lines[0][0] * lines[2][1]) * inverseDeterminant;
+		result[2][2] = (lines[0][0] * lines[1][1] - lines[0][1] * lines[1][0]) * inverseDeterminant;
+
+		for (size_t line = 0; line < 3; ++line)
+			result[line][3] = -(result[line][0] * lines[0][3] + result[line][1] * lines[1][3] + result[line][2] * lines[2][3]);
+
+		return inverse;
+	}
+
+	template<typename T>
+	Transform<T> Affine3x4<T>::ToTransform() const
+	{
+		Transform<T> transform = Transform<T>::Identity();
+		for (size_t line = 0; line < 3; ++line)
+			for (size_t column = 0; column < 4; ++column)
+				transform.SetOriginalValueAt(line, column, lines[line][column]);
+
+		return transform;
+	}
+
+	template<typename T>
+	Affine3x4<T> operator*(const Affine3x4<T>& first, const Affine3x4<T>& second)
+	{
+		//each line is a combination of whole lines of second, plus the translation of first through the implied 0 0 0 1
+		std::array<std::array<T, 4>, 3> lines;
+
+#ifdef AFFINE_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			const __m128 secondLines[4] =
+			{
+				_mm_loadu_ps(&second.GetValueAt(0, 0)),
+				_mm_loadu_ps(&second.GetValueAt(1, 0)),
+				_mm_loadu_ps(&second.GetValueAt(2, 0)),
+				_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f)
+			};
+
+			for (size_t line = 0; line < 3; ++line)
+			{
+				__m128 weights = _mm_loadu_ps(&first.GetValueAt(line, 0));
+				__m128 result = _mm_mul_ps(secondLines[0], _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(0, 0, 0, 0)));
+				result = _mm_add_ps(result, _mm_mul_ps(secondLines[1], _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(1, 1, 1, 1))));
+				result = _mm_add_ps(result, _mm_mul_ps(secondLines[2], _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(2, 2, 2, 2))));
+				result = _mm_add_ps(result, _mm_mul_ps(secondLines[3], _mm_shuffle_ps(weights, weights, _MM_SHUFFLE(3, 3, 3, 3))));
+				_mm_storeu_ps(lines[line].data(), result);
+			}
+
+			return Affine3x4<T>(lines);
+		}
+#endif
+
+		for (size_t line = 0; line < 3; ++line)
+		{
+			T a = first.GetValueAt(line, 0);
+			T b = first.GetValueAt(line, 1);
+			T c = first.GetValueAt(line, 2);
+
+			for (size_t column = 0; column < 4; ++column)
+				lines[line][column] = a * second.GetValueAt(0, column) + b * second.GetValueAt(1, column) + c * second.GetValueAt(2, column) + (column == 3 ? first.GetValueAt(line, 3) : T(0));
+		}
+
+		return Affine3x4<T>(lines);
+	}
+
+	template<typename T>
+	bool operator==(const Affine3x4<T>& first, const Affine3x4<T>& second)
+	{
+		for (size_t line = 0; line < 3; ++line)
+			for (size_t column = 0; column < 4; ++column)
+				if (!Equals<T>(first.GetValueAt(line, column), second.GetValueAt(line, column)))
+					return false;
+
+		return true;
+	}
+
+#pragma region explicit instantiations
+	template class Affine3x4<float>;
+	template class Affine3x4<double>;
+	template Affine3x4<float> operator*(const Affine3x4<float>&, const Affine3x4<float>&);
+	template Affine3x4<double> operator*(const Affine3x4<double>&, const Affine3x4<double>&);
+	template bool operator==(const Affine3x4<float>&, const Affine3x4<float>&);
+	template bool operator==(const Affine3x4<double>&, const Affine3x4<double>&);
+#pragma endregion
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathAffine)
+	{
+	public:
+		TEST_METHOD(Affine_MatchesTransform)
+		{
+			auto transform =
+				Transform<float>::MakeTranslation(10.0f, 5.0f, 7.0f) *
+				Transform<float>::MakeScaling(2.0f, 1.0f, 0.5f) *
+				Transform<float>::MakeRotation(0.3f, 0.0f, 0.7f) *
+				Transform<float>::MakeShearing(0.1f, 0.0f, 0.0f, 0.2f, 0.0f, 0.0f);
+
+			auto affine =
+				Affine3x4<float>::MakeTranslation(10.0f, 5.0f, 7.0f) *
+				Affine3x4<float>::MakeScaling(2.0f, 1.0f, 0.5f) *
+				Affine3x4<float>::MakeRotation(0.3f, 0.0f, 0.7f) *
+				Affine3x4<float>::MakeShearing(0.1f, 0.0f, 0.0f, 0.2f, 0.0f, 0.0f);
+
+			Assert::IsTrue(affine == Affine3x4<float>(transform));
+			Assert::IsTrue(affine.ToTransform() == transform);
+			Assert::IsTrue(sizeof(affine) == 12 * sizeof(float));
+
+			auto trs = Affine3x4<float>::MakeTransform(H::MakeVector(10.0f, 5.0f, 7.0f), Quaternion<float>::MakeRotation(0.3f, 0.0f, 0.7f), H::MakeVector(2.0f, 1.0f, 0.5f));
+			Assert::IsTrue(trs.ToTransform() == Transform<float>::MakeTranslation(10.0f, 5.0f, 7.0f) * Transform<float>::MakeRotation(0.3f, 0.0f, 0.7f) * Transform<float>::MakeScaling(2.0f, 1.0f, 0.5f));
+
+			auto point = H::MakePoint(1.0f, -2.0f, 3.0f);
+			auto vector = H::MakeVector(0.5f, 0.25f, -1.0f);
+			Assert::IsTrue(affine.TransformPoint(point) == point * transform);
+			Assert::IsTrue(affine.TransformVector(vector) == vector * transform);
+			Assert::IsTrue(affine.GetTranslation() == H::MakeVector(10.0f, 5.0f, 7.0f));
+
+			constexpr auto placed = Affine3x4<float>::MakeTranslation(1.0f, 2.0f, 3.0f).TransformPoint(H::MakePoint(1.0f, 1.0f, 1.0f));
+			static_assert(H::Get(placed, C::Z) == 4.0f);
+		}
+
+		TEST_METHOD(Affine_Inverse)
+		{
+			auto affine = Affine3x4<double>::MakeTranslation(1.0, 2.0, 3.0) * Affine3x4<double>::MakeRotation(0.2, 0.4, 0.6) * Affine3x4<double>::MakeScaling(2.0, 4.0, 8.0);
+			auto inverse = affine.GetInverse();
+
+			Assert::IsTrue(std::abs(affine.GetDeterminant() - 64.0) < 1e-12);
+			Assert::IsTrue(Affine3x4<double>(Transform<double>(affine.ToTransform().GetInverse().GetContents())) == inverse);
+			Assert::IsTrue(affine * inverse == Affine3x4<double>());
+
+			auto point = H::MakePoint(4.0, -5.0, 6.0);
+			auto roundTrip = inverse.TransformPoint(affine.TransformPoint(point));
+			Assert::IsTrue(std::abs(H::Get(roundTrip, C::X) - 4.0) < 1e-12);
+
+			//singular linear part
+			Assert::IsTrue(Affine3x4<double>::MakeScaling(1.0, 0.0, 1.0).GetInverse() == Affine3x4<double>());
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Transform.h"
+#include "Math_Quaternion.h"
+
+namespace Math
+{
+	/* An affine transform stored as the three lines that matter of its 4x4 matrix: the linear part in
+	the first three columns and the translation in the fourth, the implied last line being 0 0 0 1.
+	Same convention as Transform (vectors are columns, translation in column 3), a quarter less
+	memory, and composing, inverting and transforming skip the work the constant line would cost. */
+	template<typename T>
+	class Affine3x4
+	{
+	private:
+		std::array<std::array<T, 4>, 3> lines;
+
+	public:
+		/* The identity */
+		constexpr Affine3x4() : lines{ { { T(1), T(0), T(0), T(0) }, { T(0), T(1), T(0), T(0) }, { T(0), T(0), T(1), T(0) } } } { }
+		constexpr Affine3x4(const std::array<std::array<T, 4>, 3>& setLines) : lines(setLines) { }
+
+		/* Keeps the first three lines; the last line of an affine transform is 0 0 0 1 */
+		explicit Affine3x4(const Transform<T>& transform);
+
+		static constexpr Affine3x4<T> MakeTranslation(const T x, const T y, const T z);
+		static constexpr Affine3x4<T> MakeScaling(const T x, const T y, const T z);
+		static Affine3x4<T> MakeRotation(const T angleX, const T angleY, const T angleZ);
+		static constexpr Affine3x4<T> MakeShearing
+		(
+			const T xOverY, const T xOverZ,
+			const T yOverX, const T yOverZ,
+			const T zOverX, const T zOverY
+		);
+
+		/* Translation * rotation * scaling, straight from its parts without any matrix product */
+		static Affine3x4<T> MakeTransform(const Vector4<T>& translation, const Quaternion<T>& rotation, const Vector4<T>& scaling);
+
+		constexpr const T& GetValueAt(size_t line, size_t column) const { return lines[line][column]; }
+		constexpr void SetValueAt(size_t line, size_t column, const T& value) { lines[line][column] = value; }
+
+		constexpr Vector4<T> GetTranslation() const { return Helpers::MakeVector(lines[0][3], lines[1][3], lines[2][3]); }
+		constexpr void SetTranslation(const T x, const T y, const T z) { lines[0][3] = x; lines[1][3] = y; lines[2][3] = z; }
+
+		/* Determinant of the linear part, which is the determinant of the whole transform */
+		T GetDeterminant() const;
+
+		/* The identity when the linear part is singular, as SquareMatrix::GetInverse */
+		Affine3x4<T> GetInverse() const;
+
+		Transform<T> ToTransform() const;
+
+		constexpr Point4<T> TransformPoint(const Point4<T>& point) const
+		{
+			T x = Helpers::Get(point, Helpers::Coordinate::X);
+			T y = Helpers::Get(point, Helpers::Coordinate::Y);
+			T z = Helpers::Get(point, Helpers::Coordinate::Z);
+
+			return Helpers::MakePoint(
+				lines[0][0] * x + lines[0][1] * y + lines[0][2] * z + lines[0][3],
+				lines[1][0] * x + lines[1][1] * y + lines[1][2] * z + lines[1][3],
+				lines[2][0] * x + lines[2][1] * y + lines[2][2] * z + lines[2][3]);
+		}
+
+		constexpr Vector4<T> TransformVector(const Vector4<T>& vector) const
+		{
+			T x = Helpers::Get(vector, Helpers::Coordinate::X);
+			T y = Helpers::Get(vector, Helpers::Coordinate::Y);
+			T z = Helpers::Get(vector, Helpers::Coordinate::Z);
+
+			return Helpers::MakeVector(
+				lines[0][0] * x + lines[0][1] * y + lines[0][2] * z,
+				lines[1][0] * x + lines[1][1] * y + lines[1][2] * z,
+				lines[2][0] * x + lines[2][1] * y + lines[2][2] * z);
+		}
+	};
+
+#pragma region constexpr builders
+	template<typename T>
+	constexpr Affine3x4<T> Affine3x4<T>::MakeTranslation(const T x, const T y, const T z)
+	{
+		return Affine3x4<T>({ {
+			{ T(1), T(0), T(0), x },
+			{ T(0), T(1), T(0), y },
+			{ T(0), T(0), T(1), z } } });
+	}
+
+	template<typename T>
+	constexpr Affine3x4<T> Affine3x4<T>::MakeScaling(const T x, const T y, const T z)
+	{
+		return Affine3x4<T>({ {
+			{ x, T(0), T(0), T(0) },
+			{ T(0), y, T(0), T(0) },
+			{ T(0), T(0), z, T(0) } } });
+	}
+
+	template<typename T>
+	constexpr Affine3x4<T> Affine3x4<T>::MakeShearing(
+		const T xOverY, const T xOverZ,
+		const T yOverX, const T yOverZ,
+		const T zOverX, const T zOverY)
+	{
+		return Affine3x4<T>({ {
+			{ T(1), xOverY, xOverZ, T(0) },
+			{ yOverX, T(1), yOverZ, T(0) },
+			{ zOverX, zOverY, T(1), T(0) } } });
+	}
+#pragma endregion
+
+#pragma region operators
+	/* first applied after second, as for Transform */
+	template<typename T>
+	Affine3x4<T> operator*(const Affine3x4<T>& first, const Affine3x4<T>& second);
+
+	template<typename T>
+	bool operator==(const Affine3x4<T>& first, const Affine3x4<T>& second);
+#pragma endregion
+}
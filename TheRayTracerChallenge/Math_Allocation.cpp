@@ -0,0 +1,38 @@
+#include "stdafx.h"
+#include "Math_Allocation.h"
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+namespace Math
+{
+	std::atomic<uint64_t> Allocations::count{ 0 };
+	std::atomic<uint64_t> Allocations::bytes{ 0 };
+	std::atomic<bool> Allocations::counting{ false };
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathAllocation)
+	{
+	public:
+		TEST_METHOD(Allocations_Record)
+		{
+			StatisticsPhase phase;
+			uint64_t processCount = Allocations::GetCount();
+
+			Allocations::Record(48);
+			Allocations::Record(16);
+
+			Assert::IsTrue(phase.Get().Get(Counter::Allocations) >= 2);
+			Assert::IsTrue(phase.Get().Get(Counter::AllocatedBytes) >= 64);
+			Assert::IsTrue(Allocations::GetCount() >= processCount + 2);
+		}
+	};
+}
+#endif
+#pragma endregion
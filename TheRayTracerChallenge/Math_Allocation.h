@@ -0,0 +1,39 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Statistics.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Math
+{
+	/* Heap allocation counts. They are only collected when the executable links the counting hook,
+	Math_AllocationHook.cpp, which replaces the global operator new; without it every count stays 0
+	and IsCounting says so. Process wide totals are kept here, and the calling thread's counts go
+	to the Allocations and AllocatedBytes render counters, so they are merged per frame with the
+	other statistics and a phase can be measured with StatisticsPhase. */
+	class Allocations
+	{
+	private:
+		static std::atomic<uint64_t> count;
+		static std::atomic<uint64_t> bytes;
+		static std::atomic<bool> counting;
+
+	public:
+		static void Record(size_t size)
+		{
+			count.fetch_add(1, std::memory_order_relaxed);
+			bytes.fetch_add(size, std::memory_order_relaxed);
+			Statistics::Increment(Counter::Allocations);
+			Statistics::Increment(Counter::AllocatedBytes, size);
+		}
+
+		/* Called by the hook during static initialisation */
+		static void SetCounting() { counting.store(true, std::memory_order_relaxed); }
+		static bool IsCounting() { return counting.load(std::memory_order_relaxed); }
+
+		static uint64_t GetCount() { return count.load(std::memory_order_relaxed); }
+		static uint64_t GetBytes() { return bytes.load(std::memory_order_relaxed); }
+	};
+}
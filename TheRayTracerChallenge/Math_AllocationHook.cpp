@@ -0,0 +1,69 @@
+#include "stdafx.h"
+#include "Math_Allocation.h"
+
+#include <cstdlib>
+#include <algorithm>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+/* Opt-in counting allocator hook: replaces the global operator new and delete of the executable
+that links this file, and reports every allocation to Math::Allocations. It is deliberately not
+part of the core library sources; the benchmarks link it, the unit test DLL does not. */
+
+namespace
+{
+	const bool hookInstalled = (Math::Allocations::SetCounting(), true);
+
+	void* Allocate(std::size_t size)
+	{
+		Math::Allocations::Record(size);
+		void* pointer = std::malloc(size > 0 ? size : 1);
+		if (pointer == nullptr)
+			throw std::bad_alloc();
+
+		return pointer;
+	}
+
+	void* AllocateAligned(std::size_t size, std::align_val_t alignment)
+	{
+		Math::Allocations::Record(size);
+		std::size_t alignmentValue = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+		void* pointer = _aligned_malloc(size > 0 ? size : 1, alignmentValue);
+#else
+		//aligned_alloc wants a size that is a multiple of the alignment
+		std::size_t roundedSize = (std::max<std::size_t>(size, 1) + alignmentValue - 1) / alignmentValue * alignmentValue;
+		void* pointer = std::aligned_alloc(alignmentValue, roundedSize);
+#endif
+		if (pointer == nullptr)
+			throw std::bad_alloc();
+
+		return pointer;
+	}
+
+	void FreeAligned(void* pointer)
+	{
+#ifdef _MSC_VER
+		_aligned_free(pointer);
+#else
+		std::free(pointer);
+#endif
+	}
+}
+
+void* operator new(std::size_t size) { return Allocate(size); }
+void* operator new[](std::size_t size) { return Allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return AllocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { FreeAligned(pointer); }
@@ -0,0 +1,172 @@
+#include "stdafx.h"
+#include "Math_Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+namespace
+{
+	//block data is aligned for any scalar type; stricter requests are padded inside the block
+	const size_t BlockAlignment = alignof(std::max_align_t);
+}
+
+namespace Math
+{
+	Arena::Arena(size_t setBlockSize, std::pmr::memory_resource* setUpstream) :
+		blockSize{ std::max<size_t>(setBlockSize, BlockAlignment) },
+		upstream{ setUpstream }
+	{
+	}
+
+	Arena::~Arena()
+	{
+		ReleaseBlocks();
+	}
+
+	void Arena::AddBlock(size_t size)
+	{
+		std::byte* data = static_cast<std::byte*>(upstream->allocate(size, BlockAlignment));
+		blocks.push_back(Block{ data, size });
+	}
+
+	void Arena::ReleaseBlocks()
+	{
+		for (const Block& block : blocks)
+			upstream->deallocate(block.data, block.size, BlockAlignment);
+
+		blocks.clear();
+	}
+
+	void* Arena::do_allocate(size_t bytes, size_t alignment)
+	{
+		while (true)
+		{
+			if (currentBlock < blocks.size())
+			{
+				const Block& block = blocks[currentBlock];
+				uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + offset;
+				size_t padding = (alignment - address % alignment) % alignment;
+
+				if (offset + padding + bytes <= block.size)
+				{
+					offset += padding + bytes;
+					return block.data + offset - bytes;
+				}
+
+				//the rest of this block is wasted until the next rewind
+				if (currentBlock + 1 < blocks.size() || offset > 0)
+				{
+					++currentBlock;
+					offset = 0;
+					continue;
+				}
+			}
+
+			//no block left, or an empty one too small for this request
+			AddBlock(std::max(blockSize, bytes + alignment));
+			currentBlock = blocks.size() - 1;
+			offset = 0;
+		}
+	}
+
+	void Arena::Rewind(const Marker& marker)
+	{
+		currentBlock = marker.block;
+		offset = marker.offset;
+	}
+
+	void Arena::Reset()
+	{
+		if (blocks.size() > 1)
+		{
+			size_t capacity = GetCapacity();
+			ReleaseBlocks();
+			AddBlock(capacity);
+		}
+
+		currentBlock = 0;
+		offset = 0;
+	}
+
+	size_t Arena::GetCapacity() const
+	{
+		size_t capacity = 0;
+		for (const Block& block : blocks)
+			capacity += block.size;
+
+		return capacity;
+	}
+
+	Arena& Arena::GetThreadArena()
+	{
+		thread_local Arena arena;
+		return arena;
+	}
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathArena)
+	{
+	public:
+		TEST_METHOD(Arena_BumpAndAlignment)
+		{
+			Arena arena(256);
+
+			void* first = arena.allocate(3, 1);
+			void* second = arena.allocate(16, 16);
+			Assert::IsTrue(static_cast<std::byte*>(second) > static_cast<std::byte*>(first));
+			Assert::IsTrue(reinterpret_cast<uintptr_t>(second) % 16 == 0);
+			Assert::IsTrue(arena.GetBlockCount() == 1);
+
+			//larger than a block gets a block of its own
+			void* large = arena.allocate(1000, 8);
+			Assert::IsTrue(large != nullptr);
+			Assert::IsTrue(arena.GetBlockCount() == 2);
+
+			//merged into one block on reset, which then serves the same pattern without growing
+			arena.Reset();
+			Assert::IsTrue(arena.GetBlockCount() == 1);
+			size_t capacity = arena.GetCapacity();
+
+			arena.allocate(3, 1);
+			arena.allocate(16, 16);
+			arena.allocate(1000, 8);
+			Assert::IsTrue(arena.GetBlockCount() == 1);
+			Assert::IsTrue(arena.GetCapacity() == capacity);
+		}
+
+		TEST_METHOD(Arena_ScopeAndPmr)
+		{
+			Arena arena(1024);
+			void* before;
+			{
+				ArenaScope scope(arena);
+				std::pmr::vector<int> values(&arena);
+				for (int i = 0; i < 100; ++i)
+					values.push_back(i);
+
+				Assert::IsTrue(values[99] == 99);
+				before = values.data();
+			}
+
+			//the scope gave its memory back, the next user starts where it started
+			ArenaScope scope(arena);
+			std::pmr::vector<int> values(&arena);
+			values.reserve(1);
+			Assert::IsTrue(static_cast<void*>(values.data()) <= before);
+
+			Arena& threadArena = Arena::GetThreadArena();
+			Assert::IsTrue(&threadArena == &Arena::GetThreadArena());
+		}
+	};
+}
+#endif
+#pragma endregion
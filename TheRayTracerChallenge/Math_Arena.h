@@ -0,0 +1,86 @@
+#pragma once
+
+#include "stdafx.h"
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace Math
+{
+	/* Bump allocator for transient render data: allocating moves a pointer, deallocating does
+	nothing and the memory comes back all at once through Rewind or Reset. It is a
+	std::pmr::memory_resource, so pmr containers (RayHit among them) can live in it. Blocks are
+	kept across resets and merged into one, so a warmed up arena stops asking its upstream for
+	memory. Not thread safe; each thread has its own through GetThreadArena. */
+	class Arena : public std::pmr::memory_resource
+	{
+	public:
+		static const size_t DefaultBlockSize = 64 * 1024;
+
+		struct Marker
+		{
+			size_t block;
+			size_t offset;
+		};
+
+	private:
+		struct Block
+		{
+			std::byte* data;
+			size_t size;
+		};
+
+		std::vector<Block> blocks;
+		size_t currentBlock = 0;
+		size_t offset = 0;
+		size_t blockSize;
+		std::pmr::memory_resource* upstream;
+
+		void AddBlock(size_t size);
+		void ReleaseBlocks();
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void*, size_t, size_t) override { }
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+	public:
+		explicit Arena(size_t setBlockSize = DefaultBlockSize, std::pmr::memory_resource* setUpstream = std::pmr::new_delete_resource());
+		~Arena();
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		Marker GetMarker() const { return Marker{ currentBlock, offset }; }
+
+		/* Frees everything allocated since the marker was taken */
+		void Rewind(const Marker& marker);
+
+		/* Frees everything; when the last use needed several blocks they are replaced by a single
+		one as large as all of them */
+		void Reset();
+
+		size_t GetCapacity() const;
+		size_t GetBlockCount() const { return blocks.size(); }
+
+		/* The calling thread's arena, created on first use and released when the thread exits */
+		static Arena& GetThreadArena();
+	};
+
+	/* Rewinds an arena to where it was when the scope opened, e.g. around a tile */
+	class ArenaScope
+	{
+	private:
+		Arena& arena;
+		Arena::Marker marker;
+
+	public:
+		explicit ArenaScope(Arena& setArena = Arena::GetThreadArena()) : arena{ setArena }, marker{ setArena.GetMarker() } { }
+		~ArenaScope() { arena.Rewind(marker); }
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+		Arena& GetArena() { return arena; }
+	};
+}
@@ -0,0 +1,171 @@
+#include "stdafx.h"
+#include "Math_BVH.h"
+#include "Math_Primitives.h"
+#include "Math_TestHelpers.h"
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathBVH)
+	{
+		template<size_t Width>
+		static void CheckAgainstBruteForce(size_t sphereCount)
+		{
+			auto spheres = TestHelpers::MakeSpheres(sphereCount, 7u, 0.5f, 2.5f);
+			BVHAccelerator<float, Width> bvh(TestHelpers::GetPointers(spheres));
+			CheckAgainstBruteForce(spheres, bvh);
+		}
+
+		static void CheckAgainstBruteForce(const TestHelpers::SphereStorage& spheres, const IAccelerationStructure<float>& bvh)
+		{
+			Assert::IsTrue(TestHelpers::CountBruteForceMismatches(bvh, spheres, H::MakePoint(0.0f, 0.0f, -80.0f), 50.0f, 50.0f, 500, 11u) == 0);
+		}
+
+	public:
+		TEST_METHOD(BVH_NodeLayout)
+		{
+			Assert::IsTrue(alignof(BVHNode<float, 4>) == 64);
+			Assert::IsTrue(alignof(BVHNode<float, 8>) == 64);
+			Assert::IsTrue(sizeof(BVHNode<float, 4>) % 64 == 0);
+
+			auto spheres = TestHelpers::MakeSpheres(100, 3u, 0.5f, 2.5f);
+			BVH4f bvh(TestHelpers::GetPointers(spheres));
+			Assert::IsTrue(size_t(&bvh.GetTree().GetNode(0)) % 64 == 0);
+		}
+
+		TEST_METHOD(BVH_NodeLanes)
+		{
+			BVHNode<float, 4> node;
+			node.SetLaneBounds(0, BoundingBox<float>(H::MakePoint(-1.0f, -1.0f, 4.0f), H::MakePoint(1.0f, 1.0f, 6.0f)));
+			node.SetLaneBounds(1, BoundingBox<float>(H::MakePoint(-1.0f, -1.0f, 1.0f), H::MakePoint(1.0f, 1.0f, 2.0f)));
+			node.SetLaneBounds(2, BoundingBox<float>(H::MakePoint(5.0f, 5.0f, 1.0f), H::MakePoint(6.0f, 6.0f, 2.0f)));
+			node.children[0] = 0;
+			node.children[1] = 1;
+			node.children[2] = 2;
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			float tEntry[4];
+
+			uint32_t mask = IntersectNodeLanes(ray, node, 100.0f, tEntry);
+			Assert::IsTrue(mask == 3u);
+			Assert::IsTrue(Equalsf(tEntry[0], 4.0f));
+			Assert::IsTrue(Equalsf(tEntry[1], 1.0f));
+
+			mask = IntersectNodeLanes(ray, node, 3.0f, tEntry);
+			Assert::IsTrue(mask == 2u);
+
+			BVHNode<double, 8> nodeWide;
+			nodeWide.SetLaneBounds(5, BoundingBox<double>(H::MakePoint(-1.0, -1.0, 1.0), H::MakePoint(1.0, 1.0, 2.0)));
+			nodeWide.children[5] = 0;
+
+			Ray<double> rayDouble{ H::MakePoint(0.0, 0.0, 0.0), H::MakeVector(0.0, 0.0, 1.0) };
+			double tEntryWide[8];
+			Assert::IsTrue(IntersectNodeLanes(rayDouble, nodeWide, 100.0, tEntryWide) == (1u << 5));
+		}
+
+		TEST_METHOD(BVH_Empty)
+		{
+			BVH4f bvh;
+			bvh.Build(std::vector<Sphere<float>*>());
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			float distance = std::numeric_limits<float>::max();
+			Object* object = nullptr;
+
+			Assert::IsFalse(bvh.IntersectClosest(ray, distance, object));
+			Assert::IsTrue(bvh.GetTree().GetNodeCount() == 0);
+			Assert::IsTrue(ray.Intersect(bvh).objectHits.empty());
+		}
+
+		TEST_METHOD(BVH_SingleLeaf)
+		{
+			Sphere<float> sphere(1.0f, H::MakePoint(0.0f, 0.0f, 5.0f));
+			BVH8f bvh(std::vector<Sphere<float>*>{ &sphere });
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			auto hit = ray.Intersect(bvh);
+
+			Assert::IsTrue(hit.objectId == sphere.GetObjectId());
+			Assert::IsTrue(hit.objectHits.size() == 2);
+			Assert::IsTrue(hit.objectHits.at(0) == H::MakePoint(0.0f, 0.0f, 4.0f));
+		}
+
+		TEST_METHOD(BVH4_MatchesBruteForce)
+		{
+			CheckAgainstBruteForce<4>(1000);
+		}
+
+		TEST_METHOD(BVH8_MatchesBruteForce)
+		{
+			CheckAgainstBruteForce<8>(1000);
+		}
+
+		TEST_METHOD(BVH_CoincidentCentroids)
+		{
+			TestHelpers::SphereStorage spheres;
+			for (size_t i = 0; i < 50; ++i)
+				spheres.push_back(std::make_unique<Sphere<float>>(1.0f + float(i) * 0.1f, H::MakePoint(0.0f, 0.0f, 0.0f)));
+
+			BVH4f bvh(TestHelpers::GetPointers(spheres));
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, -20.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			auto hit = ray.Intersect(bvh);
+			Assert::IsTrue(hit.objectId == spheres.back()->GetObjectId());
+		}
+
+		TEST_METHOD(BVH_RefitMovedObjects)
+		{
+			auto spheres = TestHelpers::MakeSpheres(500, 5u, 0.5f, 2.5f);
+			BVH4f bvh(TestHelpers::GetPointers(spheres));
+			Assert::IsFalse(spheres[0]->IsDirty());
+
+			unsigned int seed = 17u;
+			for (size_t i = 0; i < spheres.size(); i += 10)
+			{
+				auto offset = H::MakeVector(TestHelpers::NextRandom(seed) - 0.5f, TestHelpers::NextRandom(seed) - 0.5f, TestHelpers::NextRandom(seed) - 0.5f);
+				spheres[i]->SetPosition(spheres[i]->GetPosition() + offset);
+			}
+			Assert::IsTrue(spheres[0]->IsDirty());
+
+			Assert::IsFalse(bvh.Update());
+			Assert::IsFalse(spheres[0]->IsDirty());
+			CheckAgainstBruteForce(spheres, bvh);
+
+			//refitted boxes must still enclose every object
+			const auto& tree = bvh.GetTree();
+			for (const auto& sphere : spheres)
+				Assert::IsTrue(tree.GetBounds().Contains(sphere->GetPosition()));
+		}
+
+		TEST_METHOD(BVH_RebuildWhenDegraded)
+		{
+			auto spheres = TestHelpers::MakeSpheres(500, 9u, 0.5f, 2.5f);
+			BVH8f bvh(TestHelpers::GetPointers(spheres));
+			float buildCost = bvh.GetTree().GetBuildCost();
+			Assert::IsTrue(Equalsf(bvh.GetTree().GetCost(), buildCost));
+
+			//swapping positions across the scene leaves every refitted box spanning half of it
+			for (size_t i = 0; i < spheres.size() / 2; ++i)
+			{
+				auto position = spheres[i]->GetPosition();
+				spheres[i]->SetPosition(spheres[spheres.size() - 1 - i]->GetPosition());
+				spheres[spheres.size() - 1 - i]->SetPosition(position);
+			}
+
+			Assert::IsTrue(bvh.Update());
+			Assert::IsTrue(bvh.GetTree().GetCost() < buildCost * BVH8f::DefaultRebuildThreshold);
+			CheckAgainstBruteForce(spheres, bvh);
+		}
+	};
+}
+#endif
+#pragma endregion
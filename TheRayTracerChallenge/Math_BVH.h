@@ -0,0 +1,649 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Statistics.h"
+#include "Math_Trace.h"
+#include "Math_BoundingBox.h"
+#include "Math_Ray.h"
+#include "Math_Primitives.h"
+#include "Math_Acceleration.h"
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define BVH_USE_SSE
+#endif
+
+#if defined(__AVX__)
+#define BVH_USE_AVX
+#endif
+
+namespace Math
+{
+	/* Wide BVH node. Child boxes are stored SoA as bounds[side][axis][lane] so that one ray is
+	tested against every lane of the node at once. A lane with a count is a leaf and its child is
+	the first entry of the primitive index list; a lane with no count is an inner node; unused lanes
+	have child -1 and an inverted box that never passes the slab test. */
+	template<typename T, size_t Width>
+	struct alignas(64) BVHNode
+	{
+		T bounds[2][3][Width];
+		int32_t children[Width];
+		uint32_t counts[Width];
+
+		BVHNode()
+		{
+			for (size_t lane = 0; lane < Width; ++lane)
+				ClearLane(lane);
+		}
+
+		void ClearLane(size_t lane)
+		{
+			SetLaneBounds(lane, BoundingBox<T>());
+			children[lane] = -1;
+			counts[lane] = 0;
+		}
+
+		void SetLaneBounds(size_t lane, const BoundingBox<T>& box)
+		{
+			for (size_t side = 0; side < 2; ++side)
+				for (size_t axis = 0; axis < 3; ++axis)
+					bounds[side][axis][lane] = box.GetBound(side, axis);
+		}
+
+		BoundingBox<T> GetLaneBounds(size_t lane) const
+		{
+			BoundingBox<T> box;
+			for (size_t side = 0; side < 2; ++side)
+				for (size_t axis = 0; axis < 3; ++axis)
+					box.SetBound(side, axis, bounds[side][axis][lane]);
+
+			return box;
+		}
+
+		BoundingBox<T> GetBounds() const
+		{
+			BoundingBox<T> box;
+			for (size_t lane = 0; lane < Width; ++lane)
+			{
+				if (IsLaneUsed(lane))
+					box.Merge(GetLaneBounds(lane));
+			}
+
+			return box;
+		}
+
+		bool IsLaneUsed(size_t lane) const { return children[lane] >= 0; }
+		bool IsLaneLeaf(size_t lane) const { return counts[lane] > 0; }
+	};
+
+	/* Slab test of one ray against all lanes of a node. Returns a bit mask of the lanes hit within
+	[0, tMax] and their entry distances. The loops are branchless so they vectorise; SSE/AVX
+	versions are provided for float nodes where the instruction set is available. */
+	template<typename T, size_t Width>
+	uint32_t IntersectNodeLanes(const Ray<T>& ray, const BVHNode<T, Width>& node, T tMax, T(&tEntry)[Width])
+	{
+		const auto& sign = ray.GetDirectionSign();
+		const auto& inverse = ray.GetInverseDirection();
+		const auto& origin = ray.GetOriginCoordinates();
+
+		T tNear[Width];
+		T tFar[Width];
+		for (size_t lane = 0; lane < Width; ++lane)
+		{
+			tNear[lane] = T(0);
+			tFar[lane] = tMax;
+		}
+
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			const T* nearBounds = node.bounds[sign[axis]][axis];
+			const T* farBounds = node.bounds[1 - sign[axis]][axis];
+
+			for (size_t lane = 0; lane < Width; ++lane)
+			{
+				T tNearAxis = (nearBounds[lane] - origin[axis]) * inverse[axis];
+				T tFarAxis = (farBounds[lane] - origin[axis]) * inverse[axis];
+				tNear[lane] = tNearAxis > tNear[lane] ? tNearAxis : tNear[lane];
+				tFar[lane] = tFarAxis < tFar[lane] ? tFarAxis : tFar[lane];
+			}
+		}
+
+		uint32_t mask = 0;
+		for (size_t lane = 0; lane < Width; ++lane)
+		{
+			tEntry[lane] = tNear[lane];
+			mask |= uint32_t(tNear[lane] <= tFar[lane]) << lane;
+		}
+
+		return mask;
+	}
+
+#ifdef BVH_USE_SSE
+	inline uint32_t IntersectNodeLanes(const Ray<float>& ray, const BVHNode<float, 4>& node, float tMax, float(&tEntry)[4])
+	{
+		const auto& sign = ray.GetDirectionSign();
+		const auto& inverse = ray.GetInverseDirection();
+		const auto& origin = ray.GetOriginCoordinates();
+
+		__m128 tNear = _mm_setzero_ps();
+		__m128 tFar = _mm_set1_ps(tMax);
+
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			__m128 originAxis = _mm_set1_ps(origin[axis]);
+			__m128 inverseAxis = _mm_set1_ps(inverse[axis]);
+			__m128 tNearAxis = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[sign[axis]][axis]), originAxis), inverseAxis);
+			__m128 tFarAxis = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(node.bounds[1 - sign[axis]][axis]), originAxis), inverseAxis);
+
+			//max/min return the second operand on NaN, which keeps the running interval
+			tNear = _mm_max_ps(tNearAxis, tNear);
+			tFar = _mm_min_ps(tFarAxis, tFar);
+		}
+
+		_mm_storeu_ps(tEntry, tNear);
+		return uint32_t(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+	}
+#endif
+
+#ifdef BVH_USE_AVX
+	inline uint32_t IntersectNodeLanes(const Ray<float>& ray, const BVHNode<float, 8>& node, float tMax, float(&tEntry)[8])
+	{
+		const auto& sign = ray.GetDirectionSign();
+		const auto& inverse = ray.GetInverseDirection();
+		const auto& origin = ray.GetOriginCoordinates();
+
+		__m256 tNear = _mm256_setzero_ps();
+		__m256 tFar = _mm256_set1_ps(tMax);
+
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			__m256 originAxis = _mm256_set1_ps(origin[axis]);
+			__m256 inverseAxis = _mm256_set1_ps(inverse[axis]);
+			__m256 tNearAxis = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.bounds[sign[axis]][axis]), originAxis), inverseAxis);
+			__m256 tFarAxis = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(node.bounds[1 - sign[axis]][axis]), originAxis), inverseAxis);
+
+			tNear = _mm256_max_ps(tNearAxis, tNear);
+			tFar = _mm256_min_ps(tFarAxis, tFar);
+		}
+
+		_mm256_storeu_ps(tEntry, tNear);
+		return uint32_t(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+	}
+#endif
+
+	/* Bounding volume hierarchy over a list of primitive boxes. It is built as a binned SAH binary
+	tree which is then collapsed into Width-wide nodes by repeatedly opening the largest inner child.
+	Moving primitives are handled by refitting the boxes bottom-up; GetCost() against GetBuildCost()
+	tells how much the tree degraded since it was built. */
+	template<typename T, size_t Width>
+	class WideBVH
+	{
+		static_assert(Width == 4 || Width == 8, "WideBVH nodes are either 4 or 8 lanes wide.");
+
+	public:
+		static const size_t MaxLeafSize = 4;
+		static const size_t MaxDepth = 64;
+		static const size_t BinCount = 16;
+
+		/* relative SAH costs of visiting a node lane and of testing a primitive */
+		static constexpr T TraversalCost = T(1);
+		static constexpr T IntersectionCost = T(1);
+
+	protected:
+		struct BuildNode
+		{
+			BoundingBox<T> bounds;
+			int32_t left;
+			int32_t right;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		struct StackEntry
+		{
+			int32_t child;
+			uint32_t count;
+			T tEntry;
+		};
+
+		std::vector<BVHNode<T, Width>> nodes;
+		std::vector<uint32_t> primitiveIndices;
+		BoundingBox<T> bounds;
+		T buildCost = T(0);
+
+		/* refit data: where each node hangs in its parent and which node holds each primitive */
+		std::vector<int32_t> parents;
+		std::vector<uint8_t> parentLanes;
+		std::vector<int32_t> leafNodes;
+		std::vector<uint8_t> dirtyNodes;
+
+		static size_t GetBinIndex(T centroid, T centroidMin, T binScale)
+		{
+			size_t bin = size_t((centroid - centroidMin) * binScale);
+			return bin < BinCount ? bin : BinCount - 1;
+		}
+
+		int32_t BuildRecursive(std::vector<BuildNode>& buildNodes, const std::vector<BoundingBox<T>>& primitiveBounds, uint32_t first, uint32_t count, size_t depth)
+		{
+			int32_t index = int32_t(buildNodes.size());
+			buildNodes.push_back(BuildNode{ BoundingBox<T>(), -1, -1, first, count });
+
+			BoundingBox<T> nodeBounds;
+			BoundingBox<T> centroidBounds;
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const auto& box = primitiveBounds[primitiveIndices[i]];
+				nodeBounds.Merge(box);
+				centroidBounds.Expand(box.GetCentroid());
+			}
+
+			buildNodes[index].bounds = nodeBounds;
+			if (count <= MaxLeafSize || depth + 1 >= MaxDepth)
+				return index;
+
+			size_t bestAxis = 0;
+			size_t bestBin = 0;
+			T bestCost = std::numeric_limits<T>::max();
+
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T extent = centroidBounds.GetExtent(axis);
+				if (!(extent > T(0)))
+					continue;
+
+				T centroidMin = centroidBounds.GetBound(0, axis);
+				T binScale = T(BinCount) / extent;
+
+				std::array<BoundingBox<T>, BinCount> binBounds;
+				std::array<uint32_t, BinCount> binCounts{};
+				for (uint32_t i = first; i < first + count; ++i)
+				{
+					const auto& box = primitiveBounds[primitiveIndices[i]];
+					size_t bin = GetBinIndex(box.GetCentroid(axis), centroidMin, binScale);
+					++binCounts[bin];
+					binBounds[bin].Merge(box);
+				}
+
+				std::array<T, BinCount> rightAreas{};
+				std::array<uint32_t, BinCount> rightCounts{};
+				BoundingBox<T> accumulated;
+				uint32_t accumulatedCount = 0;
+				for (size_t bin = BinCount - 1; bin > 0; --bin)
+				{
+					accumulated.Merge(binBounds[bin]);
+					accumulatedCount += binCounts[bin];
+					rightAreas[bin] = accumulated.GetSurfaceArea();
+					rightCounts[bin] = accumulatedCount;
+				}
+
+				accumulated = BoundingBox<T>();
+				accumulatedCount = 0;
+				for (size_t bin = 0; bin + 1 < BinCount; ++bin)
+				{
+					accumulated.Merge(binBounds[bin]);
+					accumulatedCount += binCounts[bin];
+					if (accumulatedCount == 0 || rightCounts[bin + 1] == 0)
+						continue;
+
+					T cost = accumulated.GetSurfaceArea() * T(accumulatedCount) + rightAreas[bin + 1] * T(rightCounts[bin + 1]);
+					if (cost < bestCost)
+					{
+						bestCost = cost;
+						bestAxis = axis;
+						bestBin = bin;
+					}
+				}
+			}
+
+			uint32_t leftCount = 0;
+			if (bestCost < std::numeric_limits<T>::max())
+			{
+				T centroidMin = centroidBounds.GetBound(0, bestAxis);
+				T binScale = T(BinCount) / centroidBounds.GetExtent(bestAxis);
+				auto middle = std::partition(primitiveIndices.begin() + first, primitiveIndices.begin() + first + count,
+					[&](uint32_t primitive)
+					{
+						return GetBinIndex(primitiveBounds[primitive].GetCentroid(bestAxis), centroidMin, binScale) <= bestBin;
+					});
+
+				leftCount = uint32_t(middle - (primitiveIndices.begin() + first));
+			}
+
+			//all centroids in one spot: any split is as good as another, halve the range
+			if (leftCount == 0 || leftCount == count)
+				leftCount = count / 2;
+
+			int32_t left = BuildRecursive(buildNodes, primitiveBounds, first, leftCount, depth + 1);
+			int32_t right = BuildRecursive(buildNodes, primitiveBounds, first + leftCount, count - leftCount, depth + 1);
+
+			buildNodes[index].left = left;
+			buildNodes[index].right = right;
+			return index;
+		}
+
+		int32_t Collapse(const std::vector<BuildNode>& buildNodes, int32_t buildIndex)
+		{
+			int32_t wideIndex = int32_t(nodes.size());
+			nodes.emplace_back();
+			parents.push_back(-1);
+			parentLanes.push_back(0);
+
+			std::array<int32_t, Width> lanes;
+			size_t laneCount = 0;
+
+			const BuildNode& buildNode = buildNodes[buildIndex];
+			if (buildNode.left < 0)
+			{
+				lanes[laneCount++] = buildIndex;
+			}
+			else
+			{
+				lanes[laneCount++] = buildNode.left;
+				lanes[laneCount++] = buildNode.right;
+			}
+
+			while (laneCount < Width)
+			{
+				size_t laneToOpen = Width;
+				T largestArea = T(-1);
+				for (size_t lane = 0; lane < laneCount; ++lane)
+				{
+					const BuildNode& candidate = buildNodes[lanes[lane]];
+					T area = candidate.bounds.GetSurfaceArea();
+					if (candidate.left >= 0 && area > largestArea)
+					{
+						largestArea = area;
+						laneToOpen = lane;
+					}
+				}
+
+				if (laneToOpen == Width)
+					break;
+
+				const BuildNode& opened = buildNodes[lanes[laneToOpen]];
+				lanes[laneToOpen] = opened.left;
+				lanes[laneCount++] = opened.right;
+			}
+
+			for (size_t lane = 0; lane < laneCount; ++lane)
+			{
+				const BuildNode& child = buildNodes[lanes[lane]];
+				nodes[wideIndex].SetLaneBounds(lane, child.bounds);
+
+				if (child.left < 0)
+				{
+					nodes[wideIndex].children[lane] = int32_t(child.first);
+					nodes[wideIndex].counts[lane] = child.count;
+
+					for (uint32_t i = child.first; i < child.first + child.count; ++i)
+					{
+						leafNodes[primitiveIndices[i]] = wideIndex;
+					}
+				}
+				else
+				{
+					int32_t childIndex = Collapse(buildNodes, lanes[lane]);
+					nodes[wideIndex].children[lane] = childIndex;
+					nodes[wideIndex].counts[lane] = 0;
+					parents[childIndex] = wideIndex;
+					parentLanes[childIndex] = uint8_t(lane);
+				}
+			}
+
+			return wideIndex;
+		}
+
+	public:
+		void Build(const std::vector<BoundingBox<T>>& primitiveBounds)
+		{
+			TRACE_ZONE("BVH build");
+
+			nodes.clear();
+			parents.clear();
+			parentLanes.clear();
+			bounds = BoundingBox<T>();
+			buildCost = T(0);
+			primitiveIndices.resize(primitiveBounds.size());
+			std::iota(primitiveIndices.begin(), primitiveIndices.end(), uint32_t(0));
+			leafNodes.assign(primitiveBounds.size(), -1);
+
+			if (primitiveBounds.empty())
+				return;
+
+			std::vector<BuildNode> buildNodes;
+			buildNodes.reserve(2 * primitiveBounds.size());
+			BuildRecursive(buildNodes, primitiveBounds, 0, uint32_t(primitiveBounds.size()), 0);
+
+			bounds = buildNodes[0].bounds;
+			nodes.reserve(buildNodes.size() / 2 + 1);
+			Collapse(buildNodes, 0);
+
+			dirtyNodes.assign(nodes.size(), 0);
+			buildCost = GetCost();
+		}
+
+		/* Recomputes the boxes of the leaves holding the given primitives and of their ancestors.
+		Nodes are stored parents first, so walking the dirty flags backwards refits every child
+		before its parent and each node is touched once however many of its primitives moved. */
+		void Refit(const std::vector<BoundingBox<T>>& primitiveBounds, const std::vector<uint32_t>& movedPrimitives)
+		{
+			if (nodes.empty() || movedPrimitives.empty())
+				return;
+
+			int32_t lastDirty = 0;
+			for (uint32_t primitive : movedPrimitives)
+			{
+				int32_t leafNode = leafNodes[primitive];
+				dirtyNodes[leafNode] = 1;
+				lastDirty = leafNode > lastDirty ? leafNode : lastDirty;
+			}
+
+			for (int32_t index = lastDirty; index >= 0; --index)
+			{
+				if (dirtyNodes[index] == 0)
+					continue;
+
+				dirtyNodes[index] = 0;
+				BVHNode<T, Width>& node = nodes[index];
+
+				for (size_t lane = 0; lane < Width; ++lane)
+				{
+					if (!node.IsLaneUsed(lane) || !node.IsLaneLeaf(lane))
+						continue;
+
+					BoundingBox<T> leafBounds;
+					for (uint32_t i = uint32_t(node.children[lane]); i < uint32_t(node.children[lane]) + node.counts[lane]; ++i)
+						leafBounds.Merge(primitiveBounds[primitiveIndices[i]]);
+
+					node.SetLaneBounds(lane, leafBounds);
+				}
+
+				if (parents[index] >= 0)
+				{
+					nodes[parents[index]].SetLaneBounds(parentLanes[index], node.GetBounds());
+					dirtyNodes[parents[index]] = 1;
+				}
+			}
+
+			bounds = nodes[0].GetBounds();
+		}
+
+		/* SAH cost of the tree relative to its root box */
+		T GetCost() const
+		{
+			T rootArea = bounds.GetSurfaceArea();
+			if (nodes.empty() || !(rootArea > T(0)))
+				return T(0);
+
+			T cost = T(0);
+			for (const BVHNode<T, Width>& node : nodes)
+			{
+				for (size_t lane = 0; lane < Width; ++lane)
+				{
+					if (!node.IsLaneUsed(lane))
+						continue;
+
+					T area = node.GetLaneBounds(lane).GetSurfaceArea();
+					cost += node.IsLaneLeaf(lane)
+						? area * T(node.counts[lane]) * IntersectionCost
+						: area * TraversalCost;
+				}
+			}
+
+			return cost / rootArea;
+		}
+
+		T GetBuildCost() const { return buildCost; }
+
+		/* Visits the primitives whose boxes the ray crosses, nearest lanes first, skipping anything
+		further than tClosest. intersectPrimitive(primitiveIndex, tClosest) returns true and
+		shortens tClosest when it finds a closer hit. */
+		template<typename IntersectPrimitive>
+		bool Traverse(const Ray<T>& ray, T& tClosest, IntersectPrimitive&& intersectPrimitive) const
+		{
+			if (nodes.empty())
+				return false;
+
+			std::array<StackEntry, MaxDepth * Width> stack;
+			size_t stackSize = 0;
+			stack[stackSize++] = StackEntry{ 0, 0, T(0) };
+
+			bool hit = false;
+			T tEntry[Width];
+			uint64_t nodeVisits = 0;
+
+			while (stackSize > 0)
+			{
+				StackEntry entry = stack[--stackSize];
+				if (entry.tEntry > tClosest)
+					continue;
+
+				if (entry.count > 0)
+				{
+					for (uint32_t i = uint32_t(entry.child); i < uint32_t(entry.child) + entry.count; ++i)
+						hit |= intersectPrimitive(primitiveIndices[i], tClosest);
+
+					continue;
+				}
+
+				const BVHNode<T, Width>& node = nodes[entry.child];
+				uint32_t mask = IntersectNodeLanes(ray, node, tClosest, tEntry);
+				++nodeVisits;
+
+				//pushed far to near so that the nearest lane is popped first
+				size_t firstPushed = stackSize;
+				for (size_t lane = 0; lane < Width; ++lane)
+				{
+					if ((mask & (uint32_t(1) << lane)) == 0 || !node.IsLaneUsed(lane))
+						continue;
+
+					StackEntry pushed{ node.children[lane], node.counts[lane], tEntry[lane] };
+					size_t position = stackSize++;
+					while (position > firstPushed && stack[position - 1].tEntry < pushed.tEntry)
+					{
+						stack[position] = stack[position - 1];
+						--position;
+					}
+
+					stack[position] = pushed;
+				}
+			}
+
+			Statistics::Increment(Counter::BVHNodeVisits, nodeVisits);
+			return hit;
+		}
+
+		BoundingBox<T> GetBounds() const { return bounds; }
+		size_t GetNodeCount() const { return nodes.size(); }
+		const BVHNode<T, Width>& GetNode(size_t index) const { return nodes[index]; }
+		const std::vector<uint32_t>& GetPrimitiveIndices() const { return primitiveIndices; }
+	};
+
+	/* Scene intersection through a wide BVH over spheres */
+	template<typename T, size_t Width = 4>
+	class BVHAccelerator : public IAccelerationStructure<T>
+	{
+	public:
+		static constexpr T DefaultRebuildThreshold = T(1.5);
+
+	protected:
+		std::vector<Sphere<T>*> objects;
+		std::vector<BoundingBox<T>> objectBounds;
+		WideBVH<T, Width> tree;
+
+	public:
+		BVHAccelerator() {}
+
+		BVHAccelerator(const std::vector<Sphere<T>*>& setObjects)
+		{
+			Build(setObjects);
+		}
+
+		void Build(const std::vector<Sphere<T>*>& setObjects)
+		{
+			objects = setObjects;
+
+			objectBounds.clear();
+			objectBounds.reserve(objects.size());
+			for (Sphere<T>* object : objects)
+			{
+				objectBounds.push_back(object->GetBounds());
+				object->ClearDirty();
+			}
+
+			tree.Build(objectBounds);
+		}
+
+		/* Brings the tree up to date with the objects flagged dirty since the last update. Boxes are
+		refitted, unless that leaves the tree costlier than rebuildThreshold times its cost when it was
+		built, in which case it is rebuilt from scratch. Returns true when a rebuild happened. */
+		bool Update(T rebuildThreshold = DefaultRebuildThreshold)
+		{
+			TRACE_ZONE("BVH update");
+
+			std::vector<uint32_t> movedObjects;
+			for (size_t index = 0; index < objects.size(); ++index)
+			{
+				if (!objects[index]->IsDirty())
+					continue;
+
+				objectBounds[index] = objects[index]->GetBounds();
+				objects[index]->ClearDirty();
+				movedObjects.push_back(uint32_t(index));
+			}
+
+			tree.Refit(objectBounds, movedObjects);
+			if (tree.GetCost() <= tree.GetBuildCost() * rebuildThreshold)
+				return false;
+
+			tree.Build(objectBounds);
+			return true;
+		}
+
+		bool IntersectClosest(const Ray<T>& ray, T& tClosest, Object*& closestObject) const override
+		{
+			return tree.Traverse(ray, tClosest, [&](uint32_t index, T& tMax)
+			{
+				T distance;
+				if (!objects[index]->IntersectClosest(ray, T(0), tMax, distance))
+					return false;
+
+				tMax = distance;
+				closestObject = objects[index];
+				return true;
+			});
+		}
+
+		BoundingBox<T> GetBounds() const override { return tree.GetBounds(); }
+		const WideBVH<T, Width>& GetTree() const { return tree; }
+		const std::vector<Sphere<T>*>& GetObjects() const { return objects; }
+	};
+
+	using BVH4f = Math::BVHAccelerator<float, 4>;
+	using BVH8f = Math::BVHAccelerator<float, 8>;
+}
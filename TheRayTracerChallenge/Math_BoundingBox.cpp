@@ -0,0 +1,51 @@
+#include "stdafx.h"
+#include "Math_BoundingBox.h"
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathBoundingBox)
+	{
+	public:
+		TEST_METHOD(BoundingBox_Empty)
+		{
+			BoundingBox<float> box;
+			Assert::IsTrue(box.IsEmpty());
+			Assert::IsTrue(box.GetSurfaceArea() == 0.0f);
+
+			box.Expand(H::MakePoint(1.0f, 2.0f, 3.0f));
+			Assert::IsFalse(box.IsEmpty());
+			Assert::IsTrue(box.GetMin() == H::MakePoint(1.0f, 2.0f, 3.0f));
+			Assert::IsTrue(box.GetMax() == H::MakePoint(1.0f, 2.0f, 3.0f));
+		}
+
+		TEST_METHOD(BoundingBox_ExpandAndMerge)
+		{
+			BoundingBox<float> box(H::MakePoint(1.0f, 1.0f, 1.0f), H::MakePoint(-1.0f, -1.0f, -1.0f));
+			Assert::IsTrue(box.GetMin() == H::MakePoint(-1.0f, -1.0f, -1.0f));
+			Assert::IsTrue(box.GetMax() == H::MakePoint(1.0f, 1.0f, 1.0f));
+			Assert::IsTrue(Equalsf(box.GetSurfaceArea(), 24.0f));
+
+			auto sphereBox = BoundingBox<float>::FromCenterAndRadius(H::MakePoint(5.0f, 0.0f, 0.0f), 1.0f);
+			box.Merge(sphereBox);
+			Assert::IsTrue(box.GetMin() == H::MakePoint(-1.0f, -1.0f, -1.0f));
+			Assert::IsTrue(box.GetMax() == H::MakePoint(6.0f, 1.0f, 1.0f));
+			Assert::IsTrue(box.GetLargestAxis() == 0);
+			Assert::IsTrue(box.GetCentroid() == H::MakePoint(2.5f, 0.0f, 0.0f));
+
+			Assert::IsTrue(box.Contains(H::MakePoint(5.5f, 0.5f, -0.5f)));
+			Assert::IsFalse(box.Contains(H::MakePoint(6.5f, 0.5f, -0.5f)));
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+
+namespace Math
+{
+	/* Axis aligned box; bounds[0] is the minimum corner and bounds[1] the maximum corner,
+	so that a ray can pick its near and far slab planes by indexing with its direction sign. */
+	template<typename T>
+	class BoundingBox
+	{
+	protected:
+		std::array<std::array<T, 3>, 2> bounds;
+
+	public:
+		BoundingBox()
+		{
+			bounds[0].fill(std::numeric_limits<T>::max());
+			bounds[1].fill(std::numeric_limits<T>::lowest());
+		}
+
+		BoundingBox(const Point4<T>& setMin, const Point4<T>& setMax) : BoundingBox()
+		{
+			Expand(setMin);
+			Expand(setMax);
+		}
+
+		static BoundingBox FromCenterAndRadius(const Point4<T>& center, const T radius)
+		{
+			BoundingBox<T> box;
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T value = Helpers::Get(center, Helpers::Coordinate(axis));
+				box.bounds[0][axis] = value - radius;
+				box.bounds[1][axis] = value + radius;
+			}
+
+			return box;
+		}
+
+		const T& GetBound(size_t side, size_t axis) const { return bounds[side][axis]; }
+		void SetBound(size_t side, size_t axis, const T& value) { bounds[side][axis] = value; }
+
+		Point4<T> GetMin() const { return Helpers::MakePoint(bounds[0][0], bounds[0][1], bounds[0][2]); }
+		Point4<T> GetMax() const { return Helpers::MakePoint(bounds[1][0], bounds[1][1], bounds[1][2]); }
+
+		T GetCentroid(size_t axis) const { return (bounds[0][axis] + bounds[1][axis]) * T(0.5); }
+		Point4<T> GetCentroid() const { return Helpers::MakePoint(GetCentroid(0), GetCentroid(1), GetCentroid(2)); }
+
+		T GetExtent(size_t axis) const { return bounds[1][axis] - bounds[0][axis]; }
+
+		bool IsEmpty() const
+		{
+			return bounds[0][0] > bounds[1][0] || bounds[0][1] > bounds[1][1] || bounds[0][2] > bounds[1][2];
+		}
+
+		T GetSurfaceArea() const
+		{
+			if (IsEmpty())
+				return T(0);
+
+			T x = GetExtent(0);
+			T y = GetExtent(1);
+			T z = GetExtent(2);
+			return T(2) * (x * y + y * z + z * x);
+		}
+
+		size_t GetLargestAxis() const
+		{
+			T x = GetExtent(0);
+			T y = GetExtent(1);
+			T z = GetExtent(2);
+
+			if (x >= y && x >= z)
+				return 0;
+
+			return y >= z ? 1 : 2;
+		}
+
+		void Expand(const Point4<T>& point)
+		{
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T value = Helpers::Get(point, Helpers::Coordinate(axis));
+				bounds[0][axis] = value < bounds[0][axis] ? value : bounds[0][axis];
+				bounds[1][axis] = value > bounds[1][axis] ? value : bounds[1][axis];
+			}
+		}
+
+		void Merge(const BoundingBox<T>& other)
+		{
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				bounds[0][axis] = other.bounds[0][axis] < bounds[0][axis] ? other.bounds[0][axis] : bounds[0][axis];
+				bounds[1][axis] = other.bounds[1][axis] > bounds[1][axis] ? other.bounds[1][axis] : bounds[1][axis];
+			}
+		}
+
+		bool Contains(const Point4<T>& point) const
+		{
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T value = Helpers::Get(point, Helpers::Coordinate(axis));
+				if (value < bounds[0][axis] || value > bounds[1][axis])
+					return false;
+			}
+
+			return true;
+		}
+	};
+
+	using BoundingBoxf = Math::BoundingBox<float>;
+}
@@ -1,12 +1,21 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <execution>
 #include <limits>
 #include <variant>
 #include <ctype.h>
 #include <array>
 #include <cassert>
 #include <functional>
+#include <string>
+#include <sstream>
+#include <stdexcept>
+#include <memory>
+#include <cmath>
+#include <vector>
 
 #define IsA(T, Y) std::is_convertible_v<T, Y>
 #define Equalsf Math::Equals<float>
@@ -45,8 +54,7 @@ namespace Math
 	template<typename T> 
 	constexpr auto GetPi() -> std::enable_if_t<std::is_floating_point_v<T>, T>
 	{
-		static const T pi = T(3.141592653589793238462643383279502884197169399375105820974944592307816406286);
-		return pi;
+		return T(3.141592653589793238462643383279502884197169399375105820974944592307816406286);
 	}
 
 	template<typename T>
@@ -90,12 +98,69 @@ namespace Math
 			: first == second;
 	}
 
-	template<template<typename> typename T, typename U> constexpr auto operator== (const T<U>& first, const T<U>& second)
-		->std::enable_if_t<IsComparable<T<U>>::value, bool>
+	/* At most two roots, in increasing order, kept in place so that testing a sphere does not allocate */
+	template<typename T>
+	struct QuadraticRoots
+	{
+		std::array<T, 2> values;
+		size_t count = 0;
+
+		const T* begin() const { return values.data(); }
+		const T* end() const { return values.data() + count; }
+	};
+
+	/* Real roots of a x^2 + b x + c. The larger one in magnitude comes from q = -(b +- sqrt(discr)) / 2
+	with the sign of b and the other one from c / q, so that neither subtracts nearly equal values. */
+	template<typename T>
+	QuadraticRoots<T> SolveQuadratic(const T& a, const T& b, const T& c)
 	{
-		return
-			Equals<U>(Math::Helpers::Get(first, Math::Helpers::Coordinate::X), Math::Helpers::Get(second, Math::Helpers::Coordinate::X)) &&
-			Equals<U>(Math::Helpers::Get(first, Math::Helpers::Coordinate::Y), Math::Helpers::Get(second, Math::Helpers::Coordinate::Y)) &&
-			Equals<U>(Math::Helpers::Get(first, Math::Helpers::Coordinate::Z), Math::Helpers::Get(second, Math::Helpers::Coordinate::Z));
+		QuadraticRoots<T> solutions;
+
+		T discr = (b * b) - (T(4) * a * c);
+		if (discr < 0)
+			return solutions;
+
+		else if (discr == 0)
+		{
+			solutions.values[0] = T(-0.5) * b / a;
+			solutions.count = 1;
+		}
+
+		else
+		{
+			T q = (b > 0)
+				? T(-0.5) * (b + std::sqrt(discr))
+				: T(-0.5) * (b - std::sqrt(discr));
+
+			auto x0 = q / a;
+			auto x1 = c / q;
+			if (x0 > x1)
+				std::swap(x0, x1);
+
+			solutions.values[0] = x0;
+			solutions.values[1] = x1;
+			solutions.count = 2;
+		}
+
+		return solutions;
 	}
+
+	/* The batch operations taking an execution policy, e.g. std::execution::par, hand it the batch in
+	chunks of this many elements */
+	inline constexpr size_t BatchChunkSize = 4096;
+
+	/* Runs function(start, count) over the chunks of BatchChunkSize in [0, size) with the given execution policy */
+	template<typename ExecutionPolicy, typename Function>
+	void ForEachBatchChunk(ExecutionPolicy&& policy, size_t size, Function&& function)
+	{
+		std::vector<size_t> chunkStarts;
+		for (size_t start = 0; start < size; start += BatchChunkSize)
+			chunkStarts.push_back(start);
+
+		std::for_each(policy, chunkStarts.begin(), chunkStarts.end(), [&](size_t start)
+		{
+			function(start, std::min(BatchChunkSize, size - start));
+		});
+	}
+
 }
\ No newline at end of file
@@ -0,0 +1,112 @@
+#include "stdafx.h"
+#include "Math_Grid.h"
+#include "Math_Primitives.h"
+#include "Gameplay.h"
+#include "Math_TestHelpers.h"
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathGrid)
+	{
+		static void CheckAgainstBruteForce(const TestHelpers::SphereStorage& spheres, const UniformGridf& grid, const Point4<float>& origin)
+		{
+			Assert::IsTrue(TestHelpers::CountBruteForceMismatches(grid, spheres, origin, 50.0f, 50.0f, 500, 31u) == 0);
+		}
+
+	public:
+		TEST_METHOD(Grid_Empty)
+		{
+			UniformGridf grid(std::vector<Sphere<float>*>{});
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			float distance = std::numeric_limits<float>::max();
+			Object* object = nullptr;
+
+			Assert::IsFalse(grid.IntersectClosest(ray, distance, object));
+			Assert::IsTrue(grid.GetCellCount() == 0);
+		}
+
+		TEST_METHOD(Grid_Binning)
+		{
+			TestHelpers::SphereStorage spheres;
+			for (size_t i = 0; i < 8; ++i)
+				spheres.push_back(std::make_unique<Sphere<float>>(0.5f, H::MakePoint(float(i) * 2.0f, 0.0f, 0.0f)));
+
+			UniformGridf grid(TestHelpers::GetPointers(spheres));
+			const auto& resolution = grid.GetResolution();
+			Assert::IsTrue(resolution[0] > resolution[1] && resolution[0] > resolution[2]);
+
+			//every object lands in at least one cell, the ones straddling cell borders in several
+			size_t binned = 0;
+			for (size_t z = 0; z < resolution[2]; ++z)
+				for (size_t y = 0; y < resolution[1]; ++y)
+					for (size_t x = 0; x < resolution[0]; ++x)
+						binned += grid.GetObjectCountInCell(x, y, z);
+
+			Assert::IsTrue(binned >= spheres.size());
+
+			Ray<float> ray{ H::MakePoint(-5.0f, 0.0f, 0.0f), H::MakeVector(1.0f, 0.0f, 0.0f) };
+			auto hit = ray.Intersect(grid);
+			Assert::IsTrue(hit.objectId == spheres.front()->GetObjectId());
+			Assert::IsTrue(hit.objectHits.at(0) == H::MakePoint(-0.5f, 0.0f, 0.0f));
+
+			ray = Ray<float>{ H::MakePoint(20.0f, 0.0f, 0.0f), H::MakeVector(-1.0f, 0.0f, 0.0f) };
+			hit = ray.Intersect(grid);
+			Assert::IsTrue(hit.objectId == spheres.back()->GetObjectId());
+		}
+
+		TEST_METHOD(Grid_MatchesBruteForce)
+		{
+			auto spheres = TestHelpers::MakeSpheres(2000, 13u, 0.8f, 1.2f);
+			UniformGridf grid(TestHelpers::GetPointers(spheres));
+
+			//from outside the grid and from inside it
+			CheckAgainstBruteForce(spheres, grid, H::MakePoint(0.0f, 0.0f, -80.0f));
+			CheckAgainstBruteForce(spheres, grid, H::MakePoint(1.0f, 2.0f, 3.0f));
+		}
+
+		TEST_METHOD(Grid_ProjectileSwarmRebuild)
+		{
+			Gameplay::Environment env;
+			env.gravity = H::MakeVector(0.0f, -0.1f, 0.0f);
+			env.wind = H::MakeVector(0.05f, 0.0f, 0.0f);
+
+			std::vector<Gameplay::Projectile> swarm(500);
+			TestHelpers::SphereStorage spheres;
+			unsigned int seed = 19u;
+			for (auto& projectile : swarm)
+			{
+				projectile.position = H::MakePoint(TestHelpers::NextRandom(seed) * 40.0f - 20.0f, TestHelpers::NextRandom(seed) * 40.0f - 20.0f, TestHelpers::NextRandom(seed) * 40.0f - 20.0f);
+				projectile.velocity = H::MakeVector(TestHelpers::NextRandom(seed) - 0.5f, TestHelpers::NextRandom(seed) - 0.5f, TestHelpers::NextRandom(seed) - 0.5f);
+				spheres.push_back(std::make_unique<Sphere<float>>(0.5f, projectile.position));
+			}
+
+			UniformGridf grid;
+			for (size_t frame = 0; frame < 5; ++frame)
+			{
+				for (size_t i = 0; i < swarm.size(); ++i)
+				{
+					swarm[i].Tick(env, swarm[i].velocity);
+					spheres[i]->SetPosition(swarm[i].position);
+				}
+
+				grid.Build(TestHelpers::GetPointers(spheres));
+				Assert::IsFalse(spheres.front()->IsDirty());
+			}
+
+			CheckAgainstBruteForce(spheres, grid, H::MakePoint(0.0f, 0.0f, -80.0f));
+		}
+	};
+}
+#endif
+#pragma endregion
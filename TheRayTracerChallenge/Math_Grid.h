@@ -0,0 +1,257 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Statistics.h"
+#include "Math_Trace.h"
+#include "Math_BoundingBox.h"
+#include "Math_Ray.h"
+#include "Math_Primitives.h"
+#include "Math_Acceleration.h"
+#include <vector>
+#include <array>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <execution>
+#include <cmath>
+
+namespace Math
+{
+	/* Uniform grid over spheres of similar size, traversed with a 3D-DDA. Objects are binned into
+	every cell their box overlaps with a counting sort, so the build is O(n), runs in parallel and
+	is cheap enough to redo every frame for particle-like scenes. The resolution follows the object
+	count (about Density cells per object), which bounds the memory of the dense cell array. */
+	template<typename T>
+	class UniformGrid : public IAccelerationStructure<T>
+	{
+	public:
+		static constexpr T DefaultDensity = T(2);
+		static const size_t MaxResolution = 512;
+
+	protected:
+		std::vector<Sphere<T>*> objects;
+		BoundingBox<T> bounds;
+		std::array<size_t, 3> resolution = { 0, 0, 0 };
+		std::array<T, 3> cellSize = { T(0), T(0), T(0) };
+		std::array<T, 3> inverseCellSize = { T(0), T(0), T(0) };
+
+		/* cellObjects[cellStarts[cell] .. cellStarts[cell + 1]) are the objects overlapping the cell */
+		std::vector<uint32_t> cellStarts;
+		std::vector<uint32_t> cellObjects;
+
+		size_t GetCellCoordinate(T value, size_t axis) const
+		{
+			T cell = std::floor((value - bounds.GetBound(0, axis)) * inverseCellSize[axis]);
+			if (!(cell > T(0)))
+				return 0;
+
+			return cell < T(resolution[axis] - 1) ? size_t(cell) : resolution[axis] - 1;
+		}
+
+		size_t GetCellIndex(size_t x, size_t y, size_t z) const
+		{
+			return (z * resolution[1] + y) * resolution[0] + x;
+		}
+
+		template<typename Visit>
+		void ForEachOverlappedCell(const BoundingBox<T>& box, Visit&& visit) const
+		{
+			std::array<size_t, 3> first;
+			std::array<size_t, 3> last;
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				first[axis] = GetCellCoordinate(box.GetBound(0, axis), axis);
+				last[axis] = GetCellCoordinate(box.GetBound(1, axis), axis);
+			}
+
+			for (size_t z = first[2]; z <= last[2]; ++z)
+				for (size_t y = first[1]; y <= last[1]; ++y)
+					for (size_t x = first[0]; x <= last[0]; ++x)
+						visit(GetCellIndex(x, y, z));
+		}
+
+		void SetResolution(size_t objectCount, T density)
+		{
+			//flat or degenerate sets still get cells of non zero size
+			T minExtent = bounds.GetExtent(bounds.GetLargestAxis()) * T(1e-3);
+			minExtent = minExtent > std::numeric_limits<T>::min() ? minExtent : T(1);
+
+			std::array<T, 3> extent;
+			T volume = T(1);
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				extent[axis] = bounds.GetExtent(axis) > minExtent ? bounds.GetExtent(axis) : minExtent;
+				bounds.SetBound(1, axis, bounds.GetBound(0, axis) + extent[axis]);
+				volume *= extent[axis];
+			}
+
+			T cellsPerUnit = std::cbrt(density * T(objectCount) / volume);
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T cells = std::ceil(extent[axis] * cellsPerUnit);
+				resolution[axis] = cells < T(1) ? 1 : (cells > T(MaxResolution) ? MaxResolution : size_t(cells));
+				cellSize[axis] = extent[axis] / T(resolution[axis]);
+				inverseCellSize[axis] = T(1) / cellSize[axis];
+			}
+		}
+
+	public:
+		UniformGrid() {}
+
+		UniformGrid(const std::vector<Sphere<T>*>& setObjects, T density = DefaultDensity)
+		{
+			Build(setObjects, density);
+		}
+
+		void Build(const std::vector<Sphere<T>*>& setObjects, T density = DefaultDensity)
+		{
+			TRACE_ZONE("grid build");
+
+			objects = setObjects;
+			bounds = BoundingBox<T>();
+			resolution = { 0, 0, 0 };
+			cellStarts.clear();
+			cellObjects.clear();
+
+			if (objects.empty())
+				return;
+
+			std::vector<BoundingBox<T>> objectBounds(objects.size());
+			std::transform(std::execution::par, objects.begin(), objects.end(), objectBounds.begin(),
+				[](Sphere<T>* object) { object->ClearDirty(); return object->GetBounds(); });
+
+			bounds = std::reduce(std::execution::par, objectBounds.begin(), objectBounds.end(), BoundingBox<T>(),
+				[](BoundingBox<T> first, const BoundingBox<T>& second) { first.Merge(second); return first; });
+
+			SetResolution(objects.size(), density);
+			size_t cellCount = resolution[0] * resolution[1] * resolution[2];
+
+			//counting sort: count the objects per cell, scan into offsets, then scatter
+			//the parallel loops run over index vectors: an algorithm may hand its callable a copy of
+			//an element, so positions must not be taken from element addresses
+			std::vector<uint32_t> objectIndices(objects.size());
+			std::iota(objectIndices.begin(), objectIndices.end(), uint32_t(0));
+
+			std::vector<std::atomic<uint32_t>> cursors(cellCount + 1);
+			std::for_each(std::execution::par, objectIndices.begin(), objectIndices.end(), [&](uint32_t index)
+			{
+				ForEachOverlappedCell(objectBounds[index], [&](size_t cell) { cursors[cell].fetch_add(1, std::memory_order_relaxed); });
+			});
+
+			cellStarts.resize(cellCount + 1);
+			std::transform(cursors.begin(), cursors.end(), cellStarts.begin(),
+				[](const std::atomic<uint32_t>& count) { return count.load(std::memory_order_relaxed); });
+			std::exclusive_scan(cellStarts.begin(), cellStarts.end(), cellStarts.begin(), uint32_t(0)); //in place, so sequential
+
+			for (size_t cell = 0; cell < cellCount; ++cell)
+				cursors[cell].store(cellStarts[cell], std::memory_order_relaxed);
+
+			cellObjects.resize(cellStarts.back());
+			std::for_each(std::execution::par, objectIndices.begin(), objectIndices.end(), [&](uint32_t index)
+			{
+				ForEachOverlappedCell(objectBounds[index], [&](size_t cell) { cellObjects[cursors[cell].fetch_add(1, std::memory_order_relaxed)] = index; });
+			});
+
+			//the scatter order depends on scheduling; sorting keeps hits on equal distances deterministic
+			std::vector<size_t> cellIndices(cellCount);
+			std::iota(cellIndices.begin(), cellIndices.end(), size_t(0));
+			std::for_each(std::execution::par, cellIndices.begin(), cellIndices.end(), [&](size_t cell)
+			{
+				std::sort(cellObjects.begin() + cellStarts[cell], cellObjects.begin() + cellStarts[cell + 1]);
+			});
+		}
+
+		/* Amanatides-Woo walk from the cell where the ray enters the grid. An object may straddle
+		cells, so a hit only ends the walk once it lies before the exit of the current cell. */
+		bool IntersectClosest(const Ray<T>& ray, T& tClosest, Object*& closestObject) const override
+		{
+			if (cellStarts.empty())
+				return false;
+
+			T tEntry;
+			if (!ray.IntersectBounds(bounds, T(0), tClosest, tEntry))
+				return false;
+
+			const auto& origin = ray.GetOriginCoordinates();
+			const auto& inverse = ray.GetInverseDirection();
+			const auto& sign = ray.GetDirectionSign();
+
+			std::array<ptrdiff_t, 3> cell;
+			std::array<ptrdiff_t, 3> step;
+			std::array<ptrdiff_t, 3> end;
+			std::array<T, 3> tNext;
+			std::array<T, 3> tDelta;
+
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T entryCoordinate = origin[axis] + Helpers::Get(ray.GetDirection(), Helpers::Coordinate(axis)) * tEntry;
+				cell[axis] = ptrdiff_t(GetCellCoordinate(entryCoordinate, axis));
+
+				if (std::isinf(inverse[axis]))
+				{
+					step[axis] = 0;
+					end[axis] = -1;
+					tNext[axis] = std::numeric_limits<T>::max();
+					tDelta[axis] = T(0);
+					continue;
+				}
+
+				step[axis] = sign[axis] == 0 ? 1 : -1;
+				end[axis] = sign[axis] == 0 ? ptrdiff_t(resolution[axis]) : -1;
+
+				T nextBound = bounds.GetBound(0, axis) + T(cell[axis] + (sign[axis] == 0 ? 1 : 0)) * cellSize[axis];
+				tNext[axis] = (nextBound - origin[axis]) * inverse[axis];
+				tDelta[axis] = cellSize[axis] * std::abs(inverse[axis]);
+			}
+
+			bool hit = false;
+			uint64_t cellVisits = 0;
+			while (true)
+			{
+				size_t index = GetCellIndex(size_t(cell[0]), size_t(cell[1]), size_t(cell[2]));
+				++cellVisits;
+				for (uint32_t i = cellStarts[index]; i < cellStarts[index + 1]; ++i)
+				{
+					T distance;
+					Sphere<T>* object = objects[cellObjects[i]];
+					if (!object->IntersectClosest(ray, T(0), tClosest, distance))
+						continue;
+
+					tClosest = distance;
+					closestObject = object;
+					hit = true;
+				}
+
+				size_t axis = tNext[0] < tNext[1]
+					? (tNext[0] < tNext[2] ? 0 : 2)
+					: (tNext[1] < tNext[2] ? 1 : 2);
+
+				if (tNext[axis] > tClosest)
+					break;
+
+				cell[axis] += step[axis];
+				if (cell[axis] == end[axis])
+					break;
+
+				tNext[axis] += tDelta[axis];
+			}
+
+			Statistics::Increment(Counter::GridCellVisits, cellVisits);
+			return hit;
+		}
+
+		BoundingBox<T> GetBounds() const override { return bounds; }
+		const std::array<size_t, 3>& GetResolution() const { return resolution; }
+		const std::vector<Sphere<T>*>& GetObjects() const { return objects; }
+		size_t GetCellCount() const { return cellStarts.empty() ? 0 : cellStarts.size() - 1; }
+
+		size_t GetObjectCountInCell(size_t x, size_t y, size_t z) const
+		{
+			size_t index = GetCellIndex(x, y, z);
+			return cellStarts[index + 1] - cellStarts[index];
+		}
+	};
+
+	using UniformGridf = Math::UniformGrid<float>;
+}
@@ -0,0 +1,187 @@
+#include "stdafx.h"
+#include "Math_Instancing.h"
+#include "Math_Primitives.h"
+#include "Math_TestHelpers.h"
+
+#include <memory>
+#include <cmath>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathInstancing)
+	{
+		struct Placement
+		{
+			float x;
+			float y;
+			float z;
+			float scale;
+		};
+
+		static Transform<float> MakePlacement(const Placement& placement)
+		{
+			auto translation = Transform<float>::MakeTranslation(placement.x, placement.y, placement.z);
+			auto scaling = Transform<float>::MakeScaling(placement.scale, placement.scale, placement.scale);
+			return translation * scaling;
+		}
+
+		/* world space copies of the shared spheres, used as the brute force reference */
+		static TestHelpers::SphereStorage Flatten(const TestHelpers::SphereStorage& shared, const std::vector<Placement>& placements)
+		{
+			TestHelpers::SphereStorage flattened;
+			for (const Placement& placement : placements)
+			{
+				for (const auto& sphere : shared)
+				{
+					auto position = sphere->GetPosition();
+					auto worldPosition = H::MakePoint(
+						H::Get(position, C::X) * placement.scale + placement.x,
+						H::Get(position, C::Y) * placement.scale + placement.y,
+						H::Get(position, C::Z) * placement.scale + placement.z);
+
+					flattened.push_back(std::make_unique<Sphere<float>>(sphere->GetRadius() * placement.scale, worldPosition));
+				}
+			}
+
+			return flattened;
+		}
+
+		/* flattened copies are different objects from the ones the instances hit, so only the distances are compared */
+		static void CheckAgainstBruteForce(const TestHelpers::SphereStorage& flattened, const InstancedBVH4f& instanced)
+		{
+			Assert::IsTrue(TestHelpers::CountBruteForceMismatches(instanced, flattened, H::MakePoint(0.0f, 0.0f, -200.0f), 80.0f, 0.0f, 300, 23u, 1e-4f, false) == 0);
+		}
+
+		static TestHelpers::SphereStorage MakeSharedSpheres()
+		{
+			return TestHelpers::MakeSpheres(200, 5u, 0.2f, 1.2f, 10.0f);
+		}
+
+		static std::shared_ptr<BVH4f> MakeShared(const TestHelpers::SphereStorage& spheres)
+		{
+			return std::make_shared<BVH4f>(TestHelpers::GetPointers(spheres));
+		}
+
+	public:
+		TEST_METHOD(Instancing_InstanceSpaceRay)
+		{
+			auto sphere = std::make_unique<Sphere<float>>(1.0f, H::MakePoint(0.0f, 0.0f, 0.0f));
+			auto shared = std::make_shared<BVH4f>(std::vector<Sphere<float>*>{ sphere.get() });
+
+			Instance<float> instance(shared, MakePlacement(Placement{ 0.0f, 0.0f, 10.0f, 2.0f }));
+			Assert::IsTrue(instance.GetBounds().Contains(H::MakePoint(0.0f, 0.0f, 8.0f)));
+			Assert::IsTrue(instance.GetBounds().Contains(H::MakePoint(0.0f, 0.0f, 12.0f)));
+			Assert::IsFalse(instance.GetBounds().Contains(H::MakePoint(0.0f, 0.0f, 7.0f)));
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			auto localRay = instance.ToInstanceSpace(ray);
+			Assert::IsTrue(localRay.GetOrigin() == H::MakePoint(0.0f, 0.0f, -5.0f));
+			Assert::IsTrue(localRay.GetDirection() == H::MakeVector(0.0f, 0.0f, 0.5f));
+
+			//same parameter, same point
+			Assert::IsTrue(instance.ToWorldSpace(localRay.GetPosition(8.0f)) == ray.GetPosition(8.0f));
+		}
+
+		TEST_METHOD(Instancing_WorldSpaceHits)
+		{
+			auto sphere = std::make_unique<Sphere<float>>(1.0f, H::MakePoint(0.0f, 0.0f, 0.0f));
+			auto shared = std::make_shared<BVH4f>(std::vector<Sphere<float>*>{ sphere.get() });
+
+			InstancedBVH4f instanced;
+			instanced.AddInstance(shared, MakePlacement(Placement{ 0.0f, 0.0f, 10.0f, 2.0f }));
+			instanced.AddInstance(shared, MakePlacement(Placement{ 0.0f, 0.0f, 4.0f, 1.0f }));
+			instanced.Build();
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			auto hit = ray.Intersect(instanced);
+
+			Assert::IsTrue(hit.objectId == sphere->GetObjectId());
+			Assert::IsTrue(hit.objectHits.size() == 2);
+			Assert::IsTrue(hit.objectHits.at(0) == H::MakePoint(0.0f, 0.0f, 3.0f));
+			Assert::IsTrue(hit.objectHits.at(1) == H::MakePoint(0.0f, 0.0f, 5.0f));
+		}
+
+		TEST_METHOD(Instancing_SmallScale)
+		{
+			//a determinant of 1e-6, which a fixed epsilon took for singular
+			auto sphere = std::make_unique<Sphere<float>>(1.0f, H::MakePoint(0.0f, 0.0f, 0.0f));
+			auto shared = std::make_shared<BVH4f>(std::vector<Sphere<float>*>{ sphere.get() });
+
+			InstancedBVH4f instanced;
+			instanced.AddInstance(shared, MakePlacement(Placement{ 0.0f, 0.0f, 10.0f, 0.01f }));
+			instanced.Build();
+
+			const Instance<float>& instance = instanced.GetInstances().at(0);
+			Assert::IsFalse(instance.GetInverseTransform() == Affine3x4<float>());
+
+			Ray<float> ray{ H::MakePoint(0.0f, 0.0f, 0.0f), H::MakeVector(0.0f, 0.0f, 1.0f) };
+			float distance = std::numeric_limits<float>::max();
+			Object* object = nullptr;
+			Assert::IsTrue(instanced.IntersectClosest(ray, distance, object));
+			Assert::IsTrue(std::abs(distance - 9.99f) < 1e-3f);
+		}
+
+		TEST_METHOD(Instancing_MatchesFlattenedScene)
+		{
+			auto spheres = MakeSharedSpheres();
+			auto shared = MakeShared(spheres);
+
+			std::vector<Placement> placements;
+			for (int i = 0; i < 4; ++i)
+				for (int j = 0; j < 4; ++j)
+					placements.push_back(Placement{ float(i) * 40.0f - 60.0f, float(j) * 40.0f - 60.0f, float(i + j), 0.5f + float((i + j) % 3) * 0.5f });
+
+			InstancedBVH4f instanced;
+			for (const Placement& placement : placements)
+				instanced.AddInstance(shared, MakePlacement(placement));
+			instanced.Build();
+
+			Assert::IsTrue(shared.use_count() == long(placements.size() + 1));
+			CheckAgainstBruteForce(Flatten(spheres, placements), instanced);
+		}
+
+		TEST_METHOD(Instancing_MovedInstances)
+		{
+			auto spheres = MakeSharedSpheres();
+			auto shared = MakeShared(spheres);
+
+			std::vector<Placement> placements;
+			for (int i = 0; i < 8; ++i)
+				placements.push_back(Placement{ float(i) * 20.0f - 70.0f, 0.0f, 0.0f, 1.0f });
+
+			InstancedBVH4f instanced;
+			for (const Placement& placement : placements)
+				instanced.AddInstance(shared, MakePlacement(placement));
+			instanced.Build();
+
+			placements[2].y = 30.0f;
+			placements[5].y = -30.0f;
+			instanced.SetInstanceTransform(2, MakePlacement(placements[2]));
+			instanced.SetInstanceTransform(5, MakePlacement(placements[5]));
+			Assert::IsFalse(instanced.Update(std::numeric_limits<float>::max()));
+
+			CheckAgainstBruteForce(Flatten(spheres, placements), instanced);
+
+			//moving an instance added since the last Build rebuilds rather than refits
+			placements.push_back(Placement{ 60.0f, 60.0f, 0.0f, 1.0f });
+			size_t added = instanced.AddInstance(shared, MakePlacement(placements.back()));
+			placements.back().y = -60.0f;
+			instanced.SetInstanceTransform(added, MakePlacement(placements.back()));
+			Assert::IsTrue(instanced.Update(std::numeric_limits<float>::max()));
+
+			CheckAgainstBruteForce(Flatten(spheres, placements), instanced);
+		}
+	};
+}
+#endif
+#pragma endregion
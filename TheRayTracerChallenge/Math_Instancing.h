@@ -0,0 +1,189 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Transform.h"
+#include "Math_Affine.h"
+#include "Math_BoundingBox.h"
+#include "Math_Ray.h"
+#include "Math_Acceleration.h"
+#include "Math_BVH.h"
+#include <vector>
+#include <memory>
+
+namespace Math
+{
+	/* One placement of a shared bottom level structure. The inverse transform is computed once
+	when the transform is set, so that traversal only has to move the ray into instance space. */
+	template<typename T>
+	class Instance
+	{
+	protected:
+		std::shared_ptr<const IAccelerationStructure<T>> geometry;
+		Affine3x4<T> transform;
+		Affine3x4<T> inverseTransform;
+		BoundingBox<T> bounds;
+
+		void UpdateBounds()
+		{
+			bounds = BoundingBox<T>();
+
+			BoundingBox<T> localBounds = geometry ? geometry->GetBounds() : BoundingBox<T>();
+			if (localBounds.IsEmpty())
+				return;
+
+			for (size_t corner = 0; corner < 8; ++corner)
+			{
+				bounds.Expand(transform.TransformPoint(Helpers::MakePoint(
+					localBounds.GetBound(corner & 1, 0),
+					localBounds.GetBound((corner >> 1) & 1, 1),
+					localBounds.GetBound((corner >> 2) & 1, 2))));
+			}
+		}
+
+	public:
+		Instance()
+		{
+		}
+
+		Instance(std::shared_ptr<const IAccelerationStructure<T>> setGeometry, const Transform<T>& setTransform) :
+			geometry(setGeometry)
+		{
+			SetTransform(setTransform);
+		}
+
+		void SetTransform(const Transform<T>& setTransform)
+		{
+			transform = Affine3x4<T>(setTransform);
+			inverseTransform = transform.GetInverse();
+			UpdateBounds();
+		}
+
+		const Affine3x4<T>& GetTransform() const { return transform; }
+		const Affine3x4<T>& GetInverseTransform() const { return inverseTransform; }
+		const BoundingBox<T>& GetBounds() const { return bounds; }
+		const std::shared_ptr<const IAccelerationStructure<T>>& GetGeometry() const { return geometry; }
+
+		/* The direction is not renormalised, so distances along the instance space ray are
+		distances along the world ray and can be compared across instances. */
+		Ray<T> ToInstanceSpace(const Ray<T>& ray) const
+		{
+			return Ray<T>(inverseTransform.TransformPoint(ray.GetOrigin()), inverseTransform.TransformVector(ray.GetDirection()));
+		}
+
+		Point4<T> ToWorldSpace(const Point4<T>& point) const { return transform.TransformPoint(point); }
+	};
+
+	/* Two level acceleration structure: a wide BVH over instance bounds on top, shared bottom
+	level structures below. Memory grows with the unique geometry rather than the instance count,
+	and moving an instance only refits the top level. */
+	template<typename T, size_t Width = 4>
+	class InstancedBVH : public IAccelerationStructure<T>
+	{
+	public:
+		static constexpr T DefaultRebuildThreshold = T(1.5);
+
+	protected:
+		std::vector<Instance<T>> instances;
+		std::vector<BoundingBox<T>> instanceBounds;
+		std::vector<uint32_t> movedInstances;
+		WideBVH<T, Width> tree;
+
+	public:
+		size_t AddInstance(std::shared_ptr<const IAccelerationStructure<T>> geometry, const Transform<T>& transform)
+		{
+			instances.emplace_back(geometry, transform);
+			return instances.size() - 1;
+		}
+
+		/* Takes effect on the next Update */
+		void SetInstanceTransform(size_t index, const Transform<T>& transform)
+		{
+			instances[index].SetTransform(transform);
+			movedInstances.push_back(uint32_t(index));
+		}
+
+		void Build()
+		{
+			instanceBounds.clear();
+			instanceBounds.reserve(instances.size());
+			for (const Instance<T>& instance : instances)
+				instanceBounds.push_back(instance.GetBounds());
+
+			movedInstances.clear();
+			tree.Build(instanceBounds);
+		}
+
+		/* Refits the top level over the instances moved since the last update, or rebuilds it when
+		the refitted tree got costlier than rebuildThreshold times its build cost, or when instances
+		were added since the last Build. Returns true when a rebuild happened. */
+		bool Update(T rebuildThreshold = DefaultRebuildThreshold)
+		{
+			if (instanceBounds.size() != instances.size())
+			{
+				Build();
+				return true;
+			}
+
+			for (uint32_t index : movedInstances)
+				instanceBounds[index] = instances[index].GetBounds();
+
+			tree.Refit(instanceBounds, movedInstances);
+			movedInstances.clear();
+
+			if (tree.GetCost() <= tree.GetBuildCost() * rebuildThreshold)
+				return false;
+
+			tree.Build(instanceBounds);
+			return true;
+		}
+
+		/* Closest hit along with the instance it belongs to; closestObject is the shared bottom level object */
+		bool IntersectClosestInstance(const Ray<T>& ray, T& tClosest, Object*& closestObject, size_t& closestInstance) const
+		{
+			return tree.Traverse(ray, tClosest, [&](uint32_t index, T& tMax)
+			{
+				const Instance<T>& instance = instances[index];
+				if (!instance.GetGeometry()->IntersectClosest(instance.ToInstanceSpace(ray), tMax, closestObject))
+					return false;
+
+				closestInstance = index;
+				return true;
+			});
+		}
+
+		bool IntersectClosest(const Ray<T>& ray, T& tClosest, Object*& closestObject) const override
+		{
+			size_t closestInstance;
+			return IntersectClosestInstance(ray, tClosest, closestObject, closestInstance);
+		}
+
+		/* Hits are computed against the object in instance space and reported in world space */
+		RayHit<T> Intersect(const Ray<T>& ray, std::pmr::memory_resource* resource) const override
+		{
+			T tClosest = std::numeric_limits<T>::max();
+			Object* closestObject = nullptr;
+			size_t closestInstance = 0;
+
+			if (!IntersectClosestInstance(ray, tClosest, closestObject, closestInstance))
+				return RayHit<T>(resource);
+
+			RayHit<T> hit = instances[closestInstance].ToInstanceSpace(ray).Intersect(closestObject, resource);
+			for (size_t i = 0; i < hit.hitDistances.size(); ++i)
+				hit.objectHits[i] = ray.GetPosition(hit.hitDistances[i]);
+
+			for (size_t i = 0; i < hit.negativeHitDistances.size(); ++i)
+				hit.negativeObjectHits[i] = ray.GetPosition(hit.negativeHitDistances[i]);
+
+			return hit;
+		}
+
+		BoundingBox<T> GetBounds() const override { return tree.GetBounds(); }
+		const WideBVH<T, Width>& GetTree() const { return tree; }
+		const std::vector<Instance<T>>& GetInstances() const { return instances; }
+	};
+
+	using InstancedBVH4f = Math::InstancedBVH<float, 4>;
+	using InstancedBVH8f = Math::InstancedBVH<float, 8>;
+}
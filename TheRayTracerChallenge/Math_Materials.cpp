@@ -22,9 +22,13 @@ namespace
 	template<typename T>
 	Math::Vector4<T> Reflect(const Math::Vector4<T>& vector, const Math::Vector4<T>& normal)
 	{
-		return vector - normal * (T(2) * vector.Dot(normal));
+		return MultiplyAdd(vector, normal, T(-2) * vector.Dot(normal));
 	}
 
+}
+
+namespace Math
+{
 	template<typename T>
 	Math::Color4<T> GetColorOnMaterialAtPoint
 	(
@@ -33,43 +37,47 @@ namespace
 		Math::IMaterial<T>* material,
 		const Math::ILight<T>& light,
 		const Math::Point4<T>& eyePosition,
-		const Math::Vector4<T>& eyeOrientation
+		const Math::Vector4<T>& eyeOrientation,
+		bool inShadow
 	)
 	{
+		Math::Statistics::Increment(Math::Counter::ShadingCalls);
+
 		Math::PhongMaterial<T>* materialAsPhong = dynamic_cast<Math::PhongMaterial<T>*>(material);
 		if (materialAsPhong == nullptr)
-			return H::MakeColor(0.0f, 0.0f, 0.0f, 0.5f);
+			return H::MakeColor<T>(0.0f, 0.0f, 0.0f, 0.5f);
 
-		auto effective_color = materialAsPhong->GetColor() * light.GetIntensity();
+		//ambient and diffuse both scale the effective colour, so they share one fused product; specular is added in place
 		auto pointToLightDirection = light.GetPosition() - point;
 		pointToLightDirection.Normalize();
 
-		auto ambient = effective_color * materialAsPhong->GetValue(Math::PhongValueType::Ambient);		
-		auto diffuse = H::MakeColor<T>(0.0f, 0.0f, 0.0f);
-		auto specular = H::MakeColor<T>(0.0f, 0.0f, 0.0f);
-		
+		T effectiveScale = materialAsPhong->GetValue(Math::PhongValueType::Ambient);
+		T specularScale = T(0);
+
 		auto light_dot_normal = pointToLightDirection.Dot(surfaceNormal);
-		if (light_dot_normal >= 0.0f)
+		if (!inShadow && light_dot_normal >= 0.0f)
 		{
-			diffuse = effective_color * materialAsPhong->GetValue(Math::PhongValueType::Diffuse) * light_dot_normal;
-			auto reflectionVector = Reflect(pointToLightDirection * -1.0f, surfaceNormal);
-			auto reflection_dot_eye = reflectionVector.Dot(eyeOrientation * -1.0f);
+			effectiveScale += materialAsPhong->GetValue(Math::PhongValueType::Diffuse) * light_dot_normal;
+			auto reflectionVector = Reflect(pointToLightDirection * T(-1), surfaceNormal);
+			auto reflection_dot_eye = -reflectionVector.Dot(eyeOrientation);
 			if (reflection_dot_eye > 0.0f)
 			{
 				auto specularFactor = (T)pow(reflection_dot_eye, materialAsPhong->GetValue(Math::PhongValueType::Shininess));
-				specular = light.GetIntensity() * materialAsPhong->GetValue(Math::PhongValueType::Specular) * specularFactor;
+				specularScale = materialAsPhong->GetValue(Math::PhongValueType::Specular) * specularFactor;
 			}
 		}
 
-		return ambient + diffuse + specular;
-	}
-}
-
-namespace Math
-{
-	
+		auto color = MultiplyColors(materialAsPhong->GetColor(), light.GetIntensity(), effectiveScale);
+		if (specularScale > T(0))
+			color = MultiplyAdd(color, light.GetIntensity(), specularScale);
 
+		return color;
+	}
 
+#pragma region explicit instantiations
+	template Color4<float> GetColorOnMaterialAtPoint(const Point4<float>&, const Vector4<float>&, IMaterial<float>*, const ILight<float>&, const Point4<float>&, const Vector4<float>&, bool);
+	template Color4<double> GetColorOnMaterialAtPoint(const Point4<double>&, const Vector4<double>&, IMaterial<double>*, const ILight<double>&, const Point4<double>&, const Vector4<double>&, bool);
+#pragma endregion
 }
 
 
@@ -216,6 +224,22 @@ namespace Math
 			Assert::IsTrue(GetColorOnMaterialAtPoint<float>(point, normalAtPoint, material, light, eyePosition, eyeOrientation) == H::MakeColor<float>(0.1f, 0.1f, 0.1f));
 		}
 
+		TEST_METHOD(PhongColor_Light_PointInShadow)
+		{
+			auto eyePosition = H::MakePoint<float>(0.0f, 0.0f, -1.0f);
+			auto eyeOrientation = H::MakeVector<float>(0.0f, 0.0f, 1.0f);
+
+			auto point = H::MakePoint<float>(0.0f, 0.0f, 0.0f);
+			auto normalAtPoint = H::MakeVector<float>(0.0f, 0.0f, -1.0f);
+
+			auto light = LightOmni<float>();
+			light.SetIntensity(H::MakeColor<float>(1.0f, 1.0f, 1.0f));
+			light.SetPosition(H::MakePoint<float>(0.0f, 0.0f, -10.0f));
+
+			auto material = PhongMaterial<float>::GetDefaultMaterial();
+			Assert::IsTrue(GetColorOnMaterialAtPoint<float>(point, normalAtPoint, material, light, eyePosition, eyeOrientation, true) == H::MakeColor<float>(0.1f, 0.1f, 0.1f));
+		}
+
 		TEST_METHOD(Phong_Color_Sphere)
 		{
 			Sphere<float> sphere;
@@ -3,6 +3,7 @@
 
 #include "stdafx.h"
 #include "Math_Common.h"
+#include "Math_Statistics.h"
 #include "Math_Matrix.h"
 #include "Math_Tuple.h"
 #include "Math_Transform.h"
@@ -35,14 +36,14 @@ namespace Math
 
 		LightOmni()
 		{
-			SetPosition(H::MakePoint<T>(0.0f, 0.0f, 0.0f));
-			SetIntensity(H::MakeColor<T>(0.0f, 0.0f, 0.0f, 0.5f));
+			this->SetPosition(Helpers::MakePoint<T>(0.0f, 0.0f, 0.0f));
+			this->SetIntensity(Helpers::MakeColor<T>(0.0f, 0.0f, 0.0f, 0.5f));
 		}
 
 		LightOmni(const Point4<T>& setPosition, const Color4<T>& setIntensity)
 		{
-			SetPosition(setPosition);
-			SetIntensity(setIntensity); 
+			this->SetPosition(setPosition);
+			this->SetIntensity(setIntensity); 
 		}
 	};
 
@@ -61,13 +62,19 @@ namespace Math
 	class IRenderData
 	{
 	protected:
-		Transform<T> transform;
+		CachedTransform<T> transform;
 		std::shared_ptr<IMaterial<T>> material;
+		bool isDirty = false; /*set when the object moved since acceleration structures last saw it*/
 
 	public:
 		virtual Vector4<T> GetNormalAtPoint(const Point4<T>& point) = 0;
-		Transform<T> GetTransform() const { return transform; }
-		void SetTransform(const Transform<T>& setTransform) { transform = setTransform; }	
+		const Transform<T>& GetTransform() const { return transform.GetTransform(); }
+		const CachedTransform<T>& GetCachedTransform() const { return transform; }
+		void SetTransform(const Transform<T>& setTransform) { transform.SetTransform(setTransform); isDirty = true; }	
+
+		void MarkDirty() { isDirty = true; }
+		void ClearDirty() { isDirty = false; }
+		bool IsDirty() const { return isDirty; }
 
 		void SetMaterial(IMaterial<T>* setMaterial) { material.reset(setMaterial); }
 		std::shared_ptr<IMaterial<T>> GetMaterial() const { return material; }
@@ -143,7 +150,7 @@ namespace Math
 		static PhongMaterial<T>* GetDefaultMaterial()
 		{
 			PhongMaterial<T>* material = new PhongMaterial<T>();
-			material->SetColor(H::MakeColor<T>((T)1.0, (T)1.0, (T)1.0, (T)0.5));
+			material->SetColor(Helpers::MakeColor<T>((T)1.0, (T)1.0, (T)1.0, (T)0.5));
 			material->SetValue(PhongValueType::Ambient, (T)0.1);
 			material->SetValue(PhongValueType::Diffuse, (T)0.9);
 			material->SetValue(PhongValueType::Specular, (T)0.9);
@@ -152,6 +159,20 @@ namespace Math
 			return material;
 		}
 	};
+
+	/* Phong lighting of a material at a point, for one light and an eye looking along eyeOrientation.
+	A point in the shadow of the light only gets the ambient term. */
+	template<typename T>
+	Color4<T> GetColorOnMaterialAtPoint
+	(
+		const Point4<T>& point,
+		const Vector4<T>& surfaceNormal,
+		IMaterial<T>* material,
+		const ILight<T>& light,
+		const Point4<T>& eyePosition,
+		const Vector4<T>& eyeOrientation,
+		bool inShadow = false
+	);
 }
 
 
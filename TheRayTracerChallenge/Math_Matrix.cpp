@@ -3,59 +3,235 @@
 #include "Graphics.h"
 #include <functional>
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define MATRIX_USE_SSE
+#endif
+
+#if defined(__AVX__)
+#define MATRIX_USE_AVX
+#endif
+
 #ifdef _MSC_VER
 	#include "CppUnitTest.h"
+	#include "Math_TestHelpers.h"
 	using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #endif
 
-namespace Math
+namespace
 {
-	template<typename T, size_t Size>
-	std::array<T, Size> GetColumnFromMatrix(SquareMatrix<T, Size>& matrix, size_t column)
+	/* the logical lines of the matrix, transposing once when the flag is set */
+	template<typename T>
+	Math::SquareMatrixContents<T, 4> GetLines4(const Math::SquareMatrix<T, 4>& matrix)
 	{
-		std::array<T, Size> returnColumn;
-		for (size_t i = 0; i < Size; ++i)
+		if (!matrix.IsTransposed())
+			return matrix.GetContents();
+
+		Math::SquareMatrixContents<T, 4> lines;
+		for (size_t line = 0; line < 4; ++line)
+			for (size_t column = 0; column < 4; ++column)
+				lines[line][column] = matrix.GetOriginalValueAt(column, line);
+
+		return lines;
+	}
+
+#ifdef MATRIX_USE_SSE
+	inline void LoadLines4(const Math::SquareMatrix<float, 4>& matrix, __m128(&lines)[4])
+	{
+		const auto& contents = matrix.GetContents();
+		for (size_t line = 0; line < 4; ++line)
+			lines[line] = _mm_loadu_ps(contents[line].data());
+
+		if (matrix.IsTransposed())
+			_MM_TRANSPOSE4_PS(lines[0], lines[1], lines[2], lines[3]);
+	}
+
+	/* a transposed matrix stores its columns as lines, so it loads as is */
+	inline void LoadColumns4(const Math::SquareMatrix<float, 4>& matrix, __m128(&columns)[4])
+	{
+		const auto& contents = matrix.GetContents();
+		for (size_t column = 0; column < 4; ++column)
+			columns[column] = _mm_loadu_ps(contents[column].data());
+
+		if (!matrix.IsTransposed())
+			_MM_TRANSPOSE4_PS(columns[0], columns[1], columns[2], columns[3]);
+	}
+
+	inline __m128 MultiplyColumns4(const __m128(&columns)[4], __m128 vector)
+	{
+		__m128 result = _mm_mul_ps(columns[0], _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(0, 0, 0, 0)));
+		result = _mm_add_ps(result, _mm_mul_ps(columns[1], _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(1, 1, 1, 1))));
+		result = _mm_add_ps(result, _mm_mul_ps(columns[2], _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(2, 2, 2, 2))));
+		return _mm_add_ps(result, _mm_mul_ps(columns[3], _mm_shuffle_ps(vector, vector, _MM_SHUFFLE(3, 3, 3, 3))));
+	}
+#endif
+
+	/* One element of several matrices side by side, so that the batched inverse is written once for
+	plain values and for registers. Each lane type has arithmetic, LoadLanes, StoreLanes, MakeLanes,
+	SqrtLanes and ReplaceSingular, which takes the product of the column lengths so that singularity
+	is judged relative to scale as in IsSingularDeterminant. */
+	template<typename T>
+	inline void LoadLanes(const T* source, T& lanes) { lanes = *source; }
+
+	template<typename T>
+	inline void StoreLanes(T* target, const T& lanes) { *target = lanes; }
+
+	template<typename T>
+	inline T MakeLanes(float value, const T&) { return T(value); }
+
+	template<typename T>
+	inline T SqrtLanes(const T& lanes) { return std::sqrt(lanes); }
+
+	template<typename T>
+	inline void ReplaceSingular(T(&inverse)[16], const T& determinant, const T& bound)
+	{
+		if (std::abs(determinant) > std::numeric_limits<T>::epsilon() * bound)
+			return;
+
+		for (size_t element = 0; element < 16; ++element)
+			inverse[element] = element % 5 == 0 ? T(1) : T(0);
+	}
+
+#ifdef MATRIX_USE_SSE
+	struct FloatLanes4 { __m128 value; };
+	inline FloatLanes4 operator+(FloatLanes4 first, FloatLanes4 second) { return { _mm_add_ps(first.value, second.value) }; }
+	inline FloatLanes4 operator-(FloatLanes4 first, FloatLanes4 second) { return { _mm_sub_ps(first.value, second.value) }; }
+	inline FloatLanes4 operator*(FloatLanes4 first, FloatLanes4 second) { return { _mm_mul_ps(first.value, second.value) }; }
+	inline FloatLanes4 operator/(FloatLanes4 first, FloatLanes4 second) { return { _mm_div_ps(first.value, second.value) }; }
+	inline void LoadLanes(const float* source, FloatLanes4& lanes) { lanes.value = _mm_loadu_ps(source); }
+	inline void StoreLanes(float* target, const FloatLanes4& lanes) { _mm_storeu_ps(target, lanes.value); }
+	inline FloatLanes4 MakeLanes(float value, const FloatLanes4&) { return { _mm_set1_ps(value) }; }
+	inline FloatLanes4 SqrtLanes(const FloatLanes4& lanes) { return { _mm_sqrt_ps(lanes.value) }; }
+
+	inline void ReplaceSingular(FloatLanes4(&inverse)[16], const FloatLanes4& determinant, const FloatLanes4& bound)
+	{
+		//without blendv, which needs SSE4.1
+		__m128 magnitude = _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant.value);
+		__m128 singular = _mm_cmple_ps(magnitude, _mm_mul_ps(_mm_set1_ps(std::numeric_limits<float>::epsilon()), bound.value));
+		if (_mm_movemask_ps(singular) == 0)
+			return;
+
+		for (size_t element = 0; element < 16; ++element)
 		{
-			returnColumn[i] = matrix.GetOriginalValueAt(i, column);
+			__m128 identity = _mm_set1_ps(element % 5 == 0 ? 1.0f : 0.0f);
+			inverse[element].value = _mm_or_ps(_mm_and_ps(singular, identity), _mm_andnot_ps(singular, inverse[element].value));
 		}
+	}
+#endif
 
-		return returnColumn;
+#ifdef MATRIX_USE_AVX
+	struct FloatLanes8 { __m256 value; };
+	inline FloatLanes8 operator+(FloatLanes8 first, FloatLanes8 second) { return { _mm256_add_ps(first.value, second.value) }; }
+	inline FloatLanes8 operator-(FloatLanes8 first, FloatLanes8 second) { return { _mm256_sub_ps(first.value, second.value) }; }
+	inline FloatLanes8 operator*(FloatLanes8 first, FloatLanes8 second) { return { _mm256_mul_ps(first.value, second.value) }; }
+	inline FloatLanes8 operator/(FloatLanes8 first, FloatLanes8 second) { return { _mm256_div_ps(first.value, second.value) }; }
+	inline void LoadLanes(const float* source, FloatLanes8& lanes) { lanes.value = _mm256_loadu_ps(source); }
+	inline void StoreLanes(float* target, const FloatLanes8& lanes) { _mm256_storeu_ps(target, lanes.value); }
+	inline FloatLanes8 MakeLanes(float value, const FloatLanes8&) { return { _mm256_set1_ps(value) }; }
+	inline FloatLanes8 SqrtLanes(const FloatLanes8& lanes) { return { _mm256_sqrt_ps(lanes.value) }; }
+
+	inline void ReplaceSingular(FloatLanes8(&inverse)[16], const FloatLanes8& determinant, const FloatLanes8& bound)
+	{
+		__m256 magnitude = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), determinant.value);
+		__m256 singular = _mm256_cmp_ps(magnitude, _mm256_mul_ps(_mm256_set1_ps(std::numeric_limits<float>::epsilon()), bound.value), _CMP_LE_OQ);
+		if (_mm256_movemask_ps(singular) == 0)
+			return;
+
+		for (size_t element = 0; element < 16; ++element)
+			inverse[element].value = _mm256_blendv_ps(inverse[element].value, _mm256_set1_ps(element % 5 == 0 ? 1.0f : 0.0f), singular);
 	}
+#endif
 
-	template<typename T, size_t Size, size_t Subsize>
-	std::array<Math::SquareMatrix<T, Subsize>, Size> FindSubmatricesOfSize(Math::SquareMatrix<T, Size>& matrix)
+	/* Closed form inverse from the 2x2 determinants of the top two lines (s) and of the bottom two
+	lines (c); m and inverse are line by line */
+	template<typename Lanes>
+	void InvertLanes(const Lanes(&m)[16], Lanes(&inverse)[16], Lanes& determinant)
 	{
-		std::array<Math::SquareMatrix<T, Subsize>, Size>
+		Lanes s0 = m[0] * m[5] - m[4] * m[1];
+		Lanes s1 = m[0] * m[6] - m[4] * m[2];
+		Lanes s2 = m[0] * m[7] - m[4] * m[3];
+		Lanes s3 = m[1] * m[6] - m[5] * m[2];
+		Lanes s4 = m[1] * m[7] - m[5] * m[3];
+		Lanes s5 = m[2] * m[7] - m[6] * m[3];
+
+		Lanes c5 = m[10] * m[15] - m[14] * m[11];
+		Lanes c4 = m[9] * m[15] - m[13] * m[11];
+		Lanes c3 = m[9] * m[14] - m[13] * m[10];
+		Lanes c2 = m[8] * m[15] - m[12] * m[11];
+		Lanes c1 = m[8] * m[14] - m[12] * m[10];
+		Lanes c0 = m[8] * m[13] - m[12] * m[9];
+
+		determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		Lanes inverseDeterminant = MakeLanes(1.0f, determinant) / determinant;
+
+		inverse[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inverseDeterminant;
+		inverse[1] = (m[2] * c4 - m[1] * c5 - m[3] * c3) * inverseDeterminant;
+		inverse[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inverseDeterminant;
+		inverse[3] = (m[10] * s4 - m[9] * s5 - m[11] * s3) * inverseDeterminant;
+
+		inverse[4] = (m[6] * c2 - m[4] * c5 - m[7] * c1) * inverseDeterminant;
+		inverse[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inverseDeterminant;
+		inverse[6] = (m[14] * s2 - m[12] * s5 - m[15] * s1) * inverseDeterminant;
+		inverse[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inverseDeterminant;
+
+		inverse[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inverseDeterminant;
+		inverse[9] = (m[1] * c2 - m[0] * c4 - m[3] * c0) * inverseDeterminant;
+		inverse[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inverseDeterminant;
+		inverse[11] = (m[9] * s2 - m[8] * s4 - m[11] * s0) * inverseDeterminant;
+
+		inverse[12] = (m[5] * c1 - m[4] * c3 - m[6] * c0) * inverseDeterminant;
+		inverse[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inverseDeterminant;
+		inverse[14] = (m[13] * s1 - m[12] * s3 - m[14] * s0) * inverseDeterminant;
+		inverse[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inverseDeterminant;
 	}
 
-	template<typename T, size_t Size>
-	const T GetDeterminantHigherOrder(Math::SquareMatrix<T, Size>& matrix)
+	/* Product of the lengths of the columns of m, the Hadamard bound of its determinant */
+	template<typename Lanes>
+	Lanes GetDeterminantBound(const Lanes(&m)[16])
 	{
-		const size_t subMatrixSize = Size - 1;
+		Lanes bound = MakeLanes(1.0f, m[0]);
+		for (size_t column = 0; column < 4; ++column)
+			bound = bound * SqrtLanes(m[column] * m[column] + m[4 + column] * m[4 + column] + m[8 + column] * m[8 + column] + m[12 + column] * m[12 + column]);
 
-		std::array<Math::SquareMatrix<T, subMatrixSize>, Size> subMatrices = GetSubmatrices(matrix);
-		T detVal = T(0);
+		return bound;
+	}
 
-		for (size_t i = 0; i < Size; ++i)
-		{
-			T sign = T(pow(-1.0, double(i)));
-			T factor = matrix.GetValueAt(0, i);
-			T subMatrixDeterminant = GetDeterminantHigherOrder<T, subMatrixSize>(subMatrices.at(i));
+	/* Inverts the matrices at index onwards, as many as Lanes holds */
+	template<typename Lanes, typename T>
+	void InvertLanesAt(const Math::Matrix4Batch<T>& input, Math::Matrix4Batch<T>& inverses, T* determinants, size_t index)
+	{
+		Lanes elements[16];
+		for (size_t element = 0; element < 16; ++element)
+			LoadLanes(input.GetElements(element / 4, element % 4) + index, elements[element]);
 
-			detVal += sign * factor * subMatrixDeterminant;
-		}
+		Lanes inverse[16];
+		Lanes determinant;
+		InvertLanes(elements, inverse, determinant);
+		ReplaceSingular(inverse, determinant, GetDeterminantBound(elements));
 
-		return detVal;
+		for (size_t element = 0; element < 16; ++element)
+			StoreLanes(inverses.GetElements(element / 4, element % 4) + index, inverse[element]);
+
+		StoreLanes(determinants + index, determinant);
 	}
+}
 
+namespace Math
+{
 	template<typename T, size_t Size>
-	const T GetDeterminantHigherOrder(Math::SquareMatrix<T, 2>& matrix)
+	std::array<T, Size> GetColumnFromMatrix(const SquareMatrix<T, Size>& matrix, size_t column)
 	{
-		return GetDeterminant2<T>(matrix);
+		std::array<T, Size> returnColumn;
+		for (size_t i = 0; i < Size; ++i)
+		{
+			returnColumn[i] = matrix.GetOriginalValueAt(i, column);
+		}
+
+		return returnColumn;
 	}
 
 	template<typename T, size_t Size>
-	SquareMatrixArray<T, Size> GetCofactorSubmatrices(Math::SquareMatrix<T, Size>& matrix)
+	SquareMatrixArray<T, Size> GetCofactorSubmatrices(const Math::SquareMatrix<T, Size>& matrix)
 	{
 		SquareMatrixArray<T, Size> cofactorSubmatrices;
 
@@ -94,7 +270,7 @@ namespace Math
 	}
 
 	template<typename T, size_t Size>
-	std::array<Math::SquareMatrix<T, Size - 1>, Size> GetSubmatrices(Math::SquareMatrix<T, Size>& matrix)
+	std::array<Math::SquareMatrix<T, Size - 1>, Size> GetSubmatrices(const Math::SquareMatrix<T, Size>& matrix)
 	{
 		std::array<Math::SquareMatrix<T, Size - 1>, Size> subMatrices;
 		for (size_t i = 0; i < Size; ++i)
@@ -123,7 +299,7 @@ namespace Math
 	}
 
 	template<typename T>
-	const T GetDeterminant4(Math::SquareMatrix<T, 4>& matrix)
+	const T GetDeterminant4(const Math::SquareMatrix<T, 4>& matrix)
 	{
 		std::array<Math::SquareMatrix<T, 3>, 4> subMatrices = GetSubmatrices(matrix);
 		T detVal = T(0);
@@ -131,7 +307,7 @@ namespace Math
 		for (size_t i = 0; i < 4; ++i)
 		{
 			T sign = i % 2 == 0 ? T(1) : T(-1);
-			T factor = matrix.GetOriginalValueAt(0, i);
+			T factor = matrix.GetValueAt(0, i);
 			T subMatrixDeterminant = GetDeterminant3(subMatrices.at(i));
 
 			detVal += sign * factor * subMatrixDeterminant;
@@ -141,7 +317,7 @@ namespace Math
 	}
 
 	template<typename T>
-	const T GetDeterminant3(Math::SquareMatrix<T, 3>& matrix)
+	const T GetDeterminant3(const Math::SquareMatrix<T, 3>& matrix)
 	{
 		return
 			matrix.GetOriginalValueAt(0, 0) *
@@ -156,7 +332,7 @@ namespace Math
 	}
 
 	template<typename T>
-	const T GetDeterminant2(Math::SquareMatrix<T, 2>& matrix)
+	const T GetDeterminant2(const Math::SquareMatrix<T, 2>& matrix)
 	{
 		return
 			matrix.GetOriginalValueAt(0, 0) * matrix.GetOriginalValueAt(1, 1) -
@@ -164,46 +340,187 @@ namespace Math
 
 	}
 
-	template<typename T, size_t Size>
-	SquareMatrixContents<T, Size> GetZero()
+	template<typename T, size_t Size> 
+	bool operator== (const Math::SquareMatrix<T, Size>& first, const Math::SquareMatrix<T, Size>& second)
 	{
-		SquareMatrixContents<T, Size> zero;
-		for (size_t i = 0; i < Size; ++i)
-			for (size_t j = 0; j < Size; ++j)
-				zero[i][j] = T(0);
-
-		return zero;
+		return CheckEquals(first, second);
 	}
 
 	template<typename T, size_t Size>
-	SquareMatrixContents<T, Size> GetIdentity()
+	SquareMatrix<T, Size> operator*(const SquareMatrix<T, Size>& first, const SquareMatrix<T, Size>& second)
 	{
-		SquareMatrixContents<T, Size> identity = GetZero<T, Size>();
-		for (size_t i = 0; i < Size; ++i)
+		if constexpr (Size == 4)
+			return MultiplyMatrices4<T>(first, second);
+		else
+			return GetMultipliedContents(first, second);
+	}
+
+	template<typename T>
+	SquareMatrix<T, 4> MultiplyMatrices4(const SquareMatrix<T, 4>& first, const SquareMatrix<T, 4>& second)
+	{
+		SquareMatrixContents<T, 4> result;
+
+#ifdef MATRIX_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
 		{
-			identity[i][i] = T(1);
+			//line i of the product is the sum of the lines of second weighted by line i of first
+			__m128 firstLines[4];
+			__m128 secondLines[4];
+			LoadLines4(first, firstLines);
+			LoadLines4(second, secondLines);
+
+			for (size_t line = 0; line < 4; ++line)
+				_mm_storeu_ps(result[line].data(), MultiplyColumns4(secondLines, firstLines[line]));
+
+			return SquareMatrix<T, 4>(result);
 		}
+#endif
+
+		SquareMatrixContents<T, 4> firstLines = GetLines4(first);
+		SquareMatrixContents<T, 4> secondLines = GetLines4(second);
 
-		return identity;
+		for (size_t line = 0; line < 4; ++line)
+		{
+			for (size_t column = 0; column < 4; ++column)
+			{
+				result[line][column] =
+					firstLines[line][0] * secondLines[0][column] +
+					firstLines[line][1] * secondLines[1][column] +
+					firstLines[line][2] * secondLines[2][column] +
+					firstLines[line][3] * secondLines[3][column];
+			}
+		}
+
+		return SquareMatrix<T, 4>(result);
 	}
 
-	template<typename T, size_t Size> 
-	bool operator== (Math::SquareMatrix<T, Size>& first, Math::SquareMatrix<T, Size>& second)
+	template<typename T>
+	void MultiplyMatrix4Vector(const SquareMatrix<T, 4>& matrix, const T* input, T* output)
 	{
-		return CheckEquals(first, second);
+		MultiplyMatrix4Vectors(matrix, input, output, 1);
 	}
 
-	template<typename T, size_t Size>
-	SquareMatrix<T, Size> operator*(SquareMatrix<T, Size>& first, SquareMatrix<T, Size>& second)
+	template<typename T>
+	void MultiplyMatrix4Vectors(const SquareMatrix<T, 4>& matrix, const T* input, T* output, size_t count)
 	{
-		return GetMultipliedContents(first, second);
+		size_t index = 0;
+
+#ifdef MATRIX_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			__m128 columns[4];
+			LoadColumns4(matrix, columns);
+
+#ifdef MATRIX_USE_AVX
+			//two vectors per iteration: each half of a register holds one, the columns are repeated in both halves
+			__m256 wideColumns[4];
+			for (size_t column = 0; column < 4; ++column)
+				wideColumns[column] = _mm256_insertf128_ps(_mm256_castps128_ps256(columns[column]), columns[column], 1);
+
+			for (; index + 2 <= count; index += 2)
+			{
+				__m256 vectors = _mm256_loadu_ps(input + index * 4);
+				__m256 result = _mm256_mul_ps(wideColumns[0], _mm256_permute_ps(vectors, 0x00));
+				result = _mm256_add_ps(result, _mm256_mul_ps(wideColumns[1], _mm256_permute_ps(vectors, 0x55)));
+				result = _mm256_add_ps(result, _mm256_mul_ps(wideColumns[2], _mm256_permute_ps(vectors, 0xAA)));
+				result = _mm256_add_ps(result, _mm256_mul_ps(wideColumns[3], _mm256_permute_ps(vectors, 0xFF)));
+				_mm256_storeu_ps(output + index * 4, result);
+			}
+#endif
+
+			for (; index < count; ++index)
+				_mm_storeu_ps(output + index * 4, MultiplyColumns4(columns, _mm_loadu_ps(input + index * 4)));
+
+			return;
+		}
+#endif
+
+		SquareMatrixContents<T, 4> lines = GetLines4(matrix);
+		for (; index < count; ++index)
+		{
+			const T* vector = input + index * 4;
+			T x = vector[0], y = vector[1], z = vector[2], w = vector[3];
+
+			for (size_t line = 0; line < 4; ++line)
+				output[index * 4 + line] = lines[line][0] * x + lines[line][1] * y + lines[line][2] * z + lines[line][3] * w;
+		}
+	}
+
+	template<typename T>
+	void InvertMatrices4(const Matrix4Batch<T>& input, Matrix4Batch<T>& inverses, T* determinants, size_t start, size_t count)
+	{
+		size_t index = start;
+		size_t end = start + count;
+
+#ifdef MATRIX_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+#ifdef MATRIX_USE_AVX
+			for (; index + 8 <= end; index += 8)
+				InvertLanesAt<FloatLanes8>(input, inverses, determinants, index);
+#endif
+			for (; index + 4 <= end; index += 4)
+				InvertLanesAt<FloatLanes4>(input, inverses, determinants, index);
+		}
+#endif
+
+		for (; index < end; ++index)
+			InvertLanesAt<T>(input, inverses, determinants, index);
+
+		//singular ones included, they are not told apart per lane
+		Statistics::Increment(Counter::MatrixInversions, count);
 	}
 
 	template<typename T, size_t Size>
-	Math::SquareMatrix<T, Size>	operator+(Math::SquareMatrix<T, Size>& first, Math::SquareMatrix<T, Size>& second)
+	Math::SquareMatrix<T, Size>	operator+(const Math::SquareMatrix<T, Size>& first, const Math::SquareMatrix<T, Size>& second)
 	{
 		return GetAddedContents(first, second);
 	}
+
+#pragma region explicit instantiations
+	/* the helpers are defined here, so the sizes the headers use are instantiated for other translation units;
+	5 to 8 are the sizes of the LU solved systems */
+#define MATH_INSTANTIATE_MATRIX(T, Size) \
+	template std::array<T, Size> GetColumnFromMatrix<T, Size>(const SquareMatrix<T, Size>&, size_t); \
+	template SquareMatrixArray<T, Size> GetCofactorSubmatrices<T, Size>(const SquareMatrix<T, Size>&); \
+	template bool operator==<T, Size>(const SquareMatrix<T, Size>&, const SquareMatrix<T, Size>&); \
+	template SquareMatrix<T, Size> operator*<T, Size>(const SquareMatrix<T, Size>&, const SquareMatrix<T, Size>&); \
+	template SquareMatrix<T, Size> operator+<T, Size>(const SquareMatrix<T, Size>&, const SquareMatrix<T, Size>&);
+
+#define MATH_INSTANTIATE_DETERMINANTS(T) \
+	template const T GetDeterminant2<T>(const SquareMatrix<T, 2>&); \
+	template const T GetDeterminant3<T>(const SquareMatrix<T, 3>&); \
+	template const T GetDeterminant4<T>(const SquareMatrix<T, 4>&);
+
+	MATH_INSTANTIATE_MATRIX(float, 2)
+	MATH_INSTANTIATE_MATRIX(float, 3)
+	MATH_INSTANTIATE_MATRIX(float, 4)
+	MATH_INSTANTIATE_MATRIX(double, 2)
+	MATH_INSTANTIATE_MATRIX(double, 3)
+	MATH_INSTANTIATE_MATRIX(double, 4)
+	MATH_INSTANTIATE_MATRIX(float, 5)
+	MATH_INSTANTIATE_MATRIX(float, 6)
+	MATH_INSTANTIATE_MATRIX(float, 7)
+	MATH_INSTANTIATE_MATRIX(float, 8)
+	MATH_INSTANTIATE_MATRIX(double, 5)
+	MATH_INSTANTIATE_MATRIX(double, 6)
+	MATH_INSTANTIATE_MATRIX(double, 7)
+	MATH_INSTANTIATE_MATRIX(double, 8)
+	MATH_INSTANTIATE_DETERMINANTS(float)
+	MATH_INSTANTIATE_DETERMINANTS(double)
+
+	template SquareMatrix<float, 4> MultiplyMatrices4<float>(const SquareMatrix<float, 4>&, const SquareMatrix<float, 4>&);
+	template SquareMatrix<double, 4> MultiplyMatrices4<double>(const SquareMatrix<double, 4>&, const SquareMatrix<double, 4>&);
+	template void MultiplyMatrix4Vector<float>(const SquareMatrix<float, 4>&, const float*, float*);
+	template void MultiplyMatrix4Vector<double>(const SquareMatrix<double, 4>&, const double*, double*);
+	template void MultiplyMatrix4Vectors<float>(const SquareMatrix<float, 4>&, const float*, float*, size_t);
+	template void MultiplyMatrix4Vectors<double>(const SquareMatrix<double, 4>&, const double*, double*, size_t);
+	template void InvertMatrices4<float>(const Matrix4Batch<float>&, Matrix4Batch<float>&, float*, size_t, size_t);
+	template void InvertMatrices4<double>(const Matrix4Batch<double>&, Matrix4Batch<double>&, double*, size_t, size_t);
+
+#undef MATH_INSTANTIATE_MATRIX
+#undef MATH_INSTANTIATE_DETERMINANTS
+#pragma endregion
 }
 
 #pragma region Math Tests
@@ -430,6 +747,27 @@ namespace Math
 			Assert::IsTrue(Equals<float>(det, 0.0f));
 		}
 
+		TEST_METHOD(MatrixDeterminant_Helpers_Order4Transposed)
+		{
+			//the expansion factors are logical values like the minors, not the stored ones
+			auto matrix = SquareMatrix<float, 4>({
+				6.0f, 4.0f, 4.0f, 4.0f,
+				5.0f, 5.0f, 7.0f, 6.0f,
+				4.0f, -9.0f, 3.0f, -7.0f,
+				9.0f, 1.0f, 7.0f, -6.0f });
+
+			matrix.SetTransposed(true);
+			Assert::IsTrue(Equals<float>(matrix.GetDeterminant(), -2120.0f));
+
+			auto transposed = SquareMatrix<float, 4>({
+				6.0f, 5.0f, 4.0f, 9.0f,
+				4.0f, 5.0f, -9.0f, 1.0f,
+				4.0f, 7.0f, 3.0f, 7.0f,
+				4.0f, 6.0f, -7.0f, -6.0f });
+
+			Assert::IsTrue(matrix.GetInverse() == transposed.GetInverse());
+		}
+
 		TEST_METHOD(MatrixDeterminant_Helpers_OrderHigherThan4)
 		{
 			auto matrix = SquareMatrix<float, 5>({
@@ -442,6 +780,129 @@ namespace Math
 			Assert::IsTrue(Equals<float>(matrix.GetDeterminant(), 30000.0f));
 		}
 
+		TEST_METHOD(Matrix4_MultiplicationKernelTransposed)
+		{
+			auto first = SquareMatrix<float, 4>({
+				1.0f, 2.0f, 3.0f, 4.0f,
+				5.0f, 6.0f, 7.0f, 8.0f,
+				9.0f, 8.0f, 7.0f, 6.0f,
+				5.0f, 4.0f, 3.0f, 2.0f });
+
+			auto second = SquareMatrix<float, 4>({
+				-2.0f, 1.0f, 2.0f, 3.0f,
+				3.0f, 2.0f, 1.0f, -1.0f,
+				4.0f, 3.0f, 6.0f, 5.0f,
+				1.0f, 2.0f, 7.0f, 8.0f });
+
+			for (bool firstTransposed : { false, true })
+			{
+				for (bool secondTransposed : { false, true })
+				{
+					first.SetTransposed(firstTransposed);
+					second.SetTransposed(secondTransposed);
+
+					Assert::IsTrue(first * second == GetMultipliedContents(first, second));
+				}
+			}
+		}
+
+		TEST_METHOD(LUDecomposition_MatchesCofactors)
+		{
+			auto matrix = SquareMatrix<double, 4>({
+				-5.0, 2.0, 6.0, -8.0,
+				1.0, -5.0, 1.0, 8.0,
+				7.0, 7.0, -6.0, -7.0,
+				1.0, -3.0, 7.0, 4.0 });
+
+			LUDecomposition<double, 4> decomposition(matrix);
+			Assert::IsFalse(decomposition.IsSingular());
+			Assert::IsTrue(std::abs(decomposition.GetDeterminant() - matrix.GetDeterminant()) < 1e-9);
+
+			auto inverse = decomposition.GetInverse();
+			auto expected = matrix.GetInverse();
+			for (size_t line = 0; line < 4; ++line)
+				for (size_t column = 0; column < 4; ++column)
+					Assert::IsTrue(std::abs(inverse.GetValueAt(line, column) - expected.GetValueAt(line, column)) < 1e-12);
+
+			auto singular = SquareMatrix<double, 3>({
+				1.0, 2.0, 3.0,
+				2.0, 4.0, 6.0,
+				0.0, 1.0, 1.0 });
+
+			std::array<double, 3> solution{ 7.0, 7.0, 7.0 };
+			Assert::IsFalse(singular.Solve({ 1.0, 2.0, 3.0 }, solution));
+			Assert::IsTrue(solution[0] == 7.0);
+			Assert::IsTrue(Equals<double>(singular.GetDeterminant(), 0.0));
+		}
+
+		TEST_METHOD(LUDecomposition_SolveAndInverse6)
+		{
+			SquareMatrixContents<double, 6> contents;
+			for (size_t line = 0; line < 6; ++line)
+				for (size_t column = 0; column < 6; ++column)
+					contents[line][column] = line == column ? 0.5 : double((line * 7 + column * 3) % 5) - 2.0;
+
+			SquareMatrix<double, 6> matrix(contents);
+			std::array<double, 6> expected{ 1.0, -2.0, 3.0, 0.5, -1.5, 4.0 };
+			std::array<double, 6> rhs{};
+			for (size_t line = 0; line < 6; ++line)
+				for (size_t column = 0; column < 6; ++column)
+					rhs[line] += contents[line][column] * expected[column];
+
+			std::array<double, 6> solution;
+			Assert::IsTrue(matrix.Solve(rhs, solution));
+			for (size_t i = 0; i < 6; ++i)
+				Assert::IsTrue(std::abs(solution[i] - expected[i]) < 1e-9);
+
+			auto product = matrix * matrix.GetInverse();
+			for (size_t line = 0; line < 6; ++line)
+				for (size_t column = 0; column < 6; ++column)
+					Assert::IsTrue(std::abs(product.GetValueAt(line, column) - (line == column ? 1.0 : 0.0)) < 1e-9);
+		}
+
+		TEST_METHOD(LUDecomposition_SmallScaleIsInvertible)
+		{
+			//determinants of 1e-8 and 1e-18, far below any fixed epsilon, of well conditioned matrices
+			SquareMatrix<float, 8> floats = SquareMatrix<float, 8>::Identity();
+			SquareMatrix<double, 6> doubles = SquareMatrix<double, 6>::Identity();
+			for (size_t i = 0; i < 8; ++i)
+				floats.SetValueAt(i, i, 0.1f);
+			for (size_t i = 0; i < 6; ++i)
+				doubles.SetValueAt(i, i, 1e-3);
+
+			Assert::IsTrue(floats.IsInvertible() && doubles.IsInvertible());
+			Assert::IsTrue(CachedMatrix<float, 8>(floats).IsInvertible());
+
+			auto floatInverse = floats.GetInverse();
+			auto doubleInverse = doubles.GetInverse();
+			for (size_t line = 0; line < 8; ++line)
+				for (size_t column = 0; column < 8; ++column)
+					Assert::IsTrue(std::abs(floatInverse.GetValueAt(line, column) - (line == column ? 10.0f : 0.0f)) < 1e-5f);
+			for (size_t line = 0; line < 6; ++line)
+				for (size_t column = 0; column < 6; ++column)
+					Assert::IsTrue(std::abs(doubleInverse.GetValueAt(line, column) - (line == column ? 1e3 : 0.0)) < 1e-9);
+
+			std::array<float, 8> solution;
+			Assert::IsTrue(floats.Solve({ 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }, solution));
+			Assert::IsTrue(std::abs(solution[7] - 10.0f) < 1e-5f);
+
+			//still singular when a column is a multiple of another, whatever the scale
+			for (size_t line = 0; line < 6; ++line)
+				doubles.SetValueAt(line, 5, 2.0 * doubles.GetValueAt(line, 0));
+
+			Assert::IsFalse(doubles.IsInvertible());
+			Assert::IsTrue(doubles.GetInverse() == SquareMatrix<double, 6>::Identity());
+
+			//a 4x4 transform scaled by 0.01 has a determinant of 1e-6
+			auto scaling = SquareMatrix<float, 4>({
+				0.01f, 0.0f, 0.0f, 5.0f,
+				0.0f, 0.01f, 0.0f, 0.0f,
+				0.0f, 0.0f, 0.01f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f });
+			Assert::IsTrue(scaling.IsInvertible());
+			Assert::IsTrue(scaling * scaling.GetInverse() == SquareMatrix<float, 4>::Identity());
+		}
+
 		TEST_METHOD(Matrix4_Submatrices)
 		{
 			auto matrix = SquareMatrix<float, 4>({
@@ -628,6 +1089,94 @@ namespace Math
 			Assert::IsTrue(matrix * matrixInverse == SquareMatrix<float, 4>::Identity());
 		}
 
+		TEST_METHOD(CachedMatrix_InverseComputedOncePerChange)
+		{
+			auto matrix = SquareMatrix<float, 4>({
+				 9.0f,  3.0f,  0.0f,  9.0f,
+				-5.0f, -2.0f, -6.0f, -3.0f,
+				-4.0f,  9.0f,  6.0f,  4.0f,
+				-7.0f,  6.0f,  6.0f,  2.0f });
+
+			CachedMatrix<float, 4> cached(matrix);
+			StatisticsPhase phase;
+
+			Assert::IsTrue(cached.GetInverse() == matrix.GetInverse());
+			Assert::IsTrue(cached.GetInverse() == matrix.GetInverse());
+			Assert::IsTrue(phase.Get().Get(Counter::MatrixInversions) == 3);
+
+			cached.SetValueAt(3, 3, 0.0f);
+			matrix.SetValueAt(3, 3, 0.0f);
+			Assert::IsTrue(Equals<float>(cached.GetDeterminant(), matrix.GetDeterminant()));
+			Assert::IsTrue(cached.GetInverse() == matrix.GetInverse());
+			Assert::IsTrue(phase.Get().Get(Counter::MatrixInversions) == 5);
+		}
+
+		TEST_METHOD(Matrix4Batch_InvertsLikeGetInverse)
+		{
+			//37 covers the eight wide, four wide and one at a time steps
+			const size_t count = 37;
+			Matrix4Batch<float> matrices(count);
+			std::vector<SquareMatrix<float, 4>> originals;
+
+			unsigned int seed = 7u;
+			for (size_t index = 0; index < count; ++index)
+			{
+				SquareMatrixContents<float, 4> contents;
+				for (size_t line = 0; line < 4; ++line)
+				{
+					for (size_t column = 0; column < 4; ++column)
+					{
+						contents[line][column] = TestHelpers::NextRandom(seed) * 2.0f - 1.0f + (line == column ? 3.0f : 0.0f);
+					}
+				}
+
+				//singular ones in a wide and in a scalar step
+				if (index == 3 || index == 36)
+					contents[1] = contents[2];
+
+				//and well conditioned ones of small scale, whose determinant is below a fixed epsilon
+				if (index == 5 || index == 35)
+					for (auto& line : contents)
+						for (float& value : line)
+							value *= 0.01f;
+
+				SquareMatrix<float, 4> matrix(contents);
+				matrix.SetTransposed(index % 2 == 1);
+				originals.push_back(matrix);
+				matrices.SetMatrix(index, matrix);
+			}
+
+			Matrix4Batch<float> inverses;
+			std::vector<float> determinants;
+			InvertMatrices4(std::execution::par, matrices, inverses, determinants);
+			Assert::IsTrue(inverses.GetCount() == count && determinants.size() == count);
+
+			for (size_t index = 0; index < count; ++index)
+			{
+				SquareMatrix<float, 4> expected = originals[index].GetInverse();
+				SquareMatrix<float, 4> inverse = inverses.GetMatrix(index);
+				for (size_t line = 0; line < 4; ++line)
+					for (size_t column = 0; column < 4; ++column)
+						Assert::IsTrue(std::abs(inverse.GetValueAt(line, column) - expected.GetValueAt(line, column)) < 1e-5f * std::max(1.0f, std::abs(expected.GetValueAt(line, column))));
+
+				Assert::IsTrue(std::abs(determinants[index] - originals[index].GetDeterminant()) < 1e-4f * std::max(1.0f, std::abs(determinants[index])));
+			}
+
+			Assert::IsTrue(inverses.GetMatrix(3) == SquareMatrix<float, 4>::Identity());
+			Assert::IsTrue(inverses.GetMatrix(36) == SquareMatrix<float, 4>::Identity());
+			Assert::IsFalse(inverses.GetMatrix(5) == SquareMatrix<float, 4>::Identity());
+			Assert::IsFalse(inverses.GetMatrix(35) == SquareMatrix<float, 4>::Identity());
+
+			//double goes one at a time
+			Matrix4Batch<double> doubles(1);
+			doubles.SetMatrix(0, SquareMatrix<double, 4>({ 2.0, 0.0, 0.0, 1.0, 0.0, 4.0, 0.0, 2.0, 0.0, 0.0, 8.0, 3.0, 0.0, 0.0, 0.0, 1.0 }));
+			Matrix4Batch<double> doubleInverses;
+			std::vector<double> doubleDeterminants;
+			InvertMatrices4(doubles, doubleInverses, doubleDeterminants);
+			Assert::IsTrue(doubleInverses.GetMatrix(0) == doubles.GetMatrix(0).GetInverse());
+			Assert::IsTrue(doubleDeterminants[0] == 64.0);
+		}
+
 	};
 }
 #endif
\ No newline at end of file
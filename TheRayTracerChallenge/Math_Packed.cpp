@@ -0,0 +1,256 @@
+#include "stdafx.h"
+#include "Math_Packed.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define PACKED_USE_SSE
+#endif
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+namespace Math
+{
+	/* the conversions treat both arrays as plain runs of values */
+	static_assert(sizeof(Point3<float>) == 3 * sizeof(float) && std::is_standard_layout_v<Point3<float>>, "Point3 must be 3 packed values");
+	static_assert(sizeof(Vector3<double>) == 3 * sizeof(double) && std::is_standard_layout_v<Vector3<double>>, "Vector3 must be 3 packed values");
+
+	/* entries converted per step of TransformPacked*, small enough for the stack */
+	const size_t PackedBlockSize = 256;
+
+	static void CheckPackedSizes(size_t inputSize, size_t outputSize)
+	{
+		if (inputSize != outputSize)
+			throw std::runtime_error("a packed conversion needs an output as long as its input");
+	}
+
+	/* x y z x y z ... to x y z w x y z w ..., w being what the 4 wide type implies */
+	template<typename T>
+	void UnpackTriples(const T* input, T* output, size_t count, T w)
+	{
+		size_t i = 0;
+
+#ifdef PACKED_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			//four entries are three registers in and four out
+			const __m128 keepXYZ = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+			const __m128 lastW = _mm_setr_ps(0.0f, 0.0f, 0.0f, w);
+			auto setW = [&](__m128 value) { return _mm_or_ps(_mm_and_ps(value, keepXYZ), lastW); };
+
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 first = _mm_loadu_ps(input + i * 3);			//x0 y0 z0 x1
+				__m128 second = _mm_loadu_ps(input + i * 3 + 4);	//y1 z1 x2 y2
+				__m128 third = _mm_loadu_ps(input + i * 3 + 8);		//z2 x3 y3 z3
+
+				__m128 x1y1 = _mm_shuffle_ps(first, second, _MM_SHUFFLE(0, 0, 3, 3));
+				_mm_storeu_ps(output + i * 4, setW(first));
+				_mm_storeu_ps(output + i * 4 + 4, setW(_mm_shuffle_ps(x1y1, second, _MM_SHUFFLE(1, 1, 2, 0))));
+				_mm_storeu_ps(output + i * 4 + 8, setW(_mm_shuffle_ps(second, third, _MM_SHUFFLE(0, 0, 3, 2))));
+				_mm_storeu_ps(output + i * 4 + 12, setW(_mm_shuffle_ps(third, third, _MM_SHUFFLE(3, 3, 2, 1))));
+			}
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			output[i * 4] = input[i * 3];
+			output[i * 4 + 1] = input[i * 3 + 1];
+			output[i * 4 + 2] = input[i * 3 + 2];
+			output[i * 4 + 3] = w;
+		}
+	}
+
+	template<typename T>
+	void PackTriples(const T* input, T* output, size_t count)
+	{
+		size_t i = 0;
+
+#ifdef PACKED_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 point0 = _mm_loadu_ps(input + i * 4);
+				__m128 point1 = _mm_loadu_ps(input + i * 4 + 4);
+				__m128 point2 = _mm_loadu_ps(input + i * 4 + 8);
+				__m128 point3 = _mm_loadu_ps(input + i * 4 + 12);
+
+				__m128 z0x1 = _mm_shuffle_ps(point0, point1, _MM_SHUFFLE(0, 0, 2, 2));
+				__m128 z2x3 = _mm_shuffle_ps(point2, point3, _MM_SHUFFLE(0, 0, 2, 2));
+				_mm_storeu_ps(output + i * 3, _mm_shuffle_ps(point0, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+				_mm_storeu_ps(output + i * 3 + 4, _mm_shuffle_ps(point1, point2, _MM_SHUFFLE(1, 0, 2, 1)));
+				_mm_storeu_ps(output + i * 3 + 8, _mm_shuffle_ps(z2x3, point3, _MM_SHUFFLE(2, 1, 2, 0)));
+			}
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			output[i * 3] = input[i * 4];
+			output[i * 3 + 1] = input[i * 4 + 1];
+			output[i * 3 + 2] = input[i * 4 + 2];
+		}
+	}
+
+	template<typename T>
+	void PackPoints(std::span<const Point4<T>> input, std::span<Point3<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+		PackTriples(reinterpret_cast<const T*>(input.data()), reinterpret_cast<T*>(output.data()), input.size());
+	}
+
+	template<typename T>
+	void PackVectors(std::span<const Vector4<T>> input, std::span<Vector3<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+		PackTriples(reinterpret_cast<const T*>(input.data()), reinterpret_cast<T*>(output.data()), input.size());
+	}
+
+	template<typename T>
+	void UnpackPoints(std::span<const Point3<T>> input, std::span<Point4<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+		UnpackTriples(reinterpret_cast<const T*>(input.data()), reinterpret_cast<T*>(output.data()), input.size(), T(1));
+	}
+
+	template<typename T>
+	void UnpackVectors(std::span<const Vector3<T>> input, std::span<Vector4<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+		UnpackTriples(reinterpret_cast<const T*>(input.data()), reinterpret_cast<T*>(output.data()), input.size(), T(0));
+	}
+
+	template<typename T>
+	void TransformPackedPoints(const Transform<T>& transform, std::span<const Point3<T>> input, std::span<Point3<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+
+		std::array<Point4<T>, PackedBlockSize> block;
+		for (size_t start = 0; start < input.size(); start += PackedBlockSize)
+		{
+			size_t count = std::min(PackedBlockSize, input.size() - start);
+			std::span<Point4<T>> unpacked(block.data(), count);
+
+			UnpackPoints(input.subspan(start, count), unpacked);
+			transform.TransformPoints(unpacked, unpacked);
+			PackPoints(std::span<const Point4<T>>(unpacked), output.subspan(start, count));
+		}
+	}
+
+	template<typename T>
+	void TransformPackedVectors(const Transform<T>& transform, std::span<const Vector3<T>> input, std::span<Vector3<T>> output)
+	{
+		CheckPackedSizes(input.size(), output.size());
+
+		std::array<Vector4<T>, PackedBlockSize> block;
+		for (size_t start = 0; start < input.size(); start += PackedBlockSize)
+		{
+			size_t count = std::min(PackedBlockSize, input.size() - start);
+			std::span<Vector4<T>> unpacked(block.data(), count);
+
+			UnpackVectors(input.subspan(start, count), unpacked);
+			transform.TransformVectors(unpacked, unpacked);
+			PackVectors(std::span<const Vector4<T>>(unpacked), output.subspan(start, count));
+		}
+	}
+
+#pragma region explicit instantiations
+#define MATH_INSTANTIATE_PACKED(T) \
+	template class Point3<T>; \
+	template class Vector3<T>; \
+	template void PackPoints(std::span<const Point4<T>>, std::span<Point3<T>>); \
+	template void PackVectors(std::span<const Vector4<T>>, std::span<Vector3<T>>); \
+	template void UnpackPoints(std::span<const Point3<T>>, std::span<Point4<T>>); \
+	template void UnpackVectors(std::span<const Vector3<T>>, std::span<Vector4<T>>); \
+	template void TransformPackedPoints(const Transform<T>&, std::span<const Point3<T>>, std::span<Point3<T>>); \
+	template void TransformPackedVectors(const Transform<T>&, std::span<const Vector3<T>>, std::span<Vector3<T>>);
+
+	MATH_INSTANTIATE_PACKED(float)
+	MATH_INSTANTIATE_PACKED(double)
+
+#undef MATH_INSTANTIATE_PACKED
+#pragma endregion
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathPacked)
+	{
+	public:
+		TEST_METHOD(Packed_RoundTrip)
+		{
+			Assert::IsTrue(sizeof(Point3<float>) == 12 && sizeof(Vector3<float>) == 12);
+
+			constexpr Point3<float> constant(H::MakePoint(1.0f, 2.0f, 3.0f));
+			static_assert(constant.GetY() == 2.0f && H::Get(constant.ToPoint4(), C::W) == 1.0f);
+
+			//seven entries: the four wide path and the remainder both run
+			std::vector<Point4<float>> points;
+			std::vector<Vector4<float>> vectors;
+			for (size_t i = 0; i < 7; ++i)
+			{
+				points.push_back(H::MakePoint(float(i), 10.0f + float(i), -float(i)));
+				vectors.push_back(H::MakeVector(0.5f * float(i), -2.0f, float(i * i)));
+			}
+
+			std::vector<Point3<float>> packedPoints(points.size());
+			std::vector<Vector3<float>> packedVectors(vectors.size());
+			PackPoints<float>(points, packedPoints);
+			PackVectors<float>(vectors, packedVectors);
+
+			std::vector<Point4<float>> unpackedPoints(points.size());
+			std::vector<Vector4<float>> unpackedVectors(vectors.size());
+			UnpackPoints<float>(packedPoints, unpackedPoints);
+			UnpackVectors<float>(packedVectors, unpackedVectors);
+
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				Assert::IsTrue(packedPoints[i] == Point3<float>(points[i]));
+				Assert::IsTrue(packedVectors[i].ToVector4() == vectors[i]);
+				Assert::IsTrue(unpackedPoints[i] == points[i] && H::Get(unpackedPoints[i], C::W) == 1.0f);
+				Assert::IsTrue(unpackedVectors[i] == vectors[i] && H::Get(unpackedVectors[i], C::W) == 0.0f);
+			}
+
+			bool thrown = false;
+			try { PackPoints<float>(points, std::span<Point3<float>>(packedPoints).first(3)); }
+			catch (const std::runtime_error&) { thrown = true; }
+			Assert::IsTrue(thrown);
+		}
+
+		TEST_METHOD(Packed_Transform)
+		{
+			auto transform = Transform<double>::MakeTranslation(1.0, 2.0, 3.0) * Transform<double>::MakeRotation(0.3, 0.2, 0.1);
+
+			//more than one block, transformed in place
+			std::vector<Point3<double>> points;
+			std::vector<Vector3<double>> vectors;
+			for (size_t i = 0; i < 600; ++i)
+			{
+				points.push_back(Point3<double>(double(i), 1.0, -0.5 * double(i)));
+				vectors.push_back(Vector3<double>(1.0, double(i), 2.0));
+			}
+
+			std::vector<Point3<double>> transformedPoints = points;
+			std::vector<Vector3<double>> transformedVectors = vectors;
+			TransformPackedPoints<double>(transform, transformedPoints, transformedPoints);
+			TransformPackedVectors<double>(transform, transformedVectors, transformedVectors);
+
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				Assert::IsTrue(transformedPoints[i] == Point3<double>(points[i].ToPoint4() * transform));
+				Assert::IsTrue(transformedVectors[i] == Vector3<double>(vectors[i].ToVector4() * transform));
+			}
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Transform.h"
+
+#include <span>
+
+namespace Math
+{
+	/* Storage forms of Point4 and Vector4 without the w their type already implies: 12 bytes instead
+	of 16 for float, for vertex buffers, particle arrays and scene files where arrays are large and
+	mostly at rest. Computing is done on the 4 wide types; convert at the edges, a whole array at a
+	time with the Pack / Unpack functions below. */
+	template<typename T>
+	class Point3
+	{
+	private:
+		T x, y, z;
+
+	public:
+		constexpr Point3() : x(T(0)), y(T(0)), z(T(0)) { }
+		constexpr Point3(T setX, T setY, T setZ) : x(setX), y(setY), z(setZ) { }
+		constexpr explicit Point3(const Point4<T>& point) :
+			x(Helpers::Get(point, Helpers::Coordinate::X)),
+			y(Helpers::Get(point, Helpers::Coordinate::Y)),
+			z(Helpers::Get(point, Helpers::Coordinate::Z)) { }
+
+		constexpr T GetX() const { return x; }
+		constexpr T GetY() const { return y; }
+		constexpr T GetZ() const { return z; }
+
+		constexpr Point4<T> ToPoint4() const { return Helpers::MakePoint(x, y, z); }
+	};
+
+	template<typename T>
+	class Vector3
+	{
+	private:
+		T x, y, z;
+
+	public:
+		constexpr Vector3() : x(T(0)), y(T(0)), z(T(0)) { }
+		constexpr Vector3(T setX, T setY, T setZ) : x(setX), y(setY), z(setZ) { }
+		constexpr explicit Vector3(const Vector4<T>& vector) :
+			x(Helpers::Get(vector, Helpers::Coordinate::X)),
+			y(Helpers::Get(vector, Helpers::Coordinate::Y)),
+			z(Helpers::Get(vector, Helpers::Coordinate::Z)) { }
+
+		constexpr T GetX() const { return x; }
+		constexpr T GetY() const { return y; }
+		constexpr T GetZ() const { return z; }
+
+		constexpr Vector4<T> ToVector4() const { return Helpers::MakeVector(x, y, z); }
+	};
+
+#pragma region array conversions
+	/* output[i] = input[i] converted, four at a time with SSE for float; both spans must be as long */
+	template<typename T> void PackPoints(std::span<const Point4<T>> input, std::span<Point3<T>> output);
+	template<typename T> void PackVectors(std::span<const Vector4<T>> input, std::span<Vector3<T>> output);
+	template<typename T> void UnpackPoints(std::span<const Point3<T>> input, std::span<Point4<T>> output);
+	template<typename T> void UnpackVectors(std::span<const Vector3<T>> input, std::span<Vector4<T>> output);
+
+	/* Transform::TransformPoints / TransformVectors on packed arrays: unpacked a block at a time
+	into a buffer on the stack, so the 4 wide copy never exists for the whole array. output may be input */
+	template<typename T> void TransformPackedPoints(const Transform<T>& transform, std::span<const Point3<T>> input, std::span<Point3<T>> output);
+	template<typename T> void TransformPackedVectors(const Transform<T>& transform, std::span<const Vector3<T>> input, std::span<Vector3<T>> output);
+#pragma endregion
+
+#pragma region operators
+	template<typename T>
+	bool operator==(const Point3<T>& first, const Point3<T>& second)
+	{
+		return first.ToPoint4() == second.ToPoint4();
+	}
+
+	template<typename T>
+	bool operator==(const Vector3<T>& first, const Vector3<T>& second)
+	{
+		return first.ToVector4() == second.ToVector4();
+	}
+#pragma endregion
+}
@@ -25,20 +25,23 @@ namespace Math
     template<typename T>
     Vector4<T> Sphere<T>::GetNormalAtPoint(const Point4<T>& point)
     {
-        static auto identity = Transform<T>::Identity();
-        auto transform = this->GetTransform().GetRotation();        
-        auto inverse = transform.GetInverse();
+        //inverted once when the transform was set
+        const auto& inverse = this->GetCachedTransform().GetInverse();
 
         auto pointLocalSpace = point * inverse;
         auto thisPositionLocalSpace = this->GetPosition() * inverse;
         auto normalLocalSpace = pointLocalSpace - thisPositionLocalSpace;
         
-        inverse.SetTransposed(true);
-        auto normalWorldSpace = normalLocalSpace * inverse;
+        auto normalWorldSpace = normalLocalSpace * this->GetCachedTransform().GetNormalTransform();
         normalWorldSpace.Normalize();
 
         return H::MakeVector(H::Get(normalWorldSpace, C::X), H::Get(normalWorldSpace, C::Y), H::Get(normalWorldSpace, C::Z));
     }
+
+#pragma region explicit instantiations
+    template class Sphere<float>;
+    template class Sphere<double>;
+#pragma endregion
 }
 
 #pragma region tests here
@@ -3,13 +3,16 @@
 
 #include "stdafx.h"
 #include "Math_Common.h"
+#include "Math_Statistics.h"
 #include "Math_Matrix.h"
 #include "Math_Tuple.h"
 #include "Math_Transform.h"
 #include "Math_Materials.h"
 #include "Math_Ray.h"
+#include "Math_BoundingBox.h"
 #include <unordered_map>
 #include <unordered_set>
+#include <cmath>
 
 namespace Math
 {
@@ -53,19 +56,55 @@ namespace Math
 		Point4<T> position;
 
 	public:
-		Sphere() : radius{0}, position{H::MakePoint(T(0), T(0), T(0))}
+		Sphere() : radius{0}, position{Helpers::MakePoint(T(0), T(0), T(0))}
         {
-            SetTransform(Transform<T>::Identity());
+            this->SetTransform(Transform<T>::Identity());
         }
 
 		Sphere(T setRadius, Point4<T> setPosition) : radius{setRadius}, position{setPosition}{ }
 
-        T GetRadius() { return radius; }
-        Point4<T> GetPosition() { return position; }
+        T GetRadius() const { return radius; }
+        Point4<T> GetPosition() const { return position; }
+        BoundingBox<T> GetBounds() const { return BoundingBox<T>::FromCenterAndRadius(position, radius); }
 
-        void SetRadius(const T setRadius) { radius = setRadius; }
-        void SetPosition(const Point4<T>& setPosition) { position = setPosition; }
+        void SetRadius(const T setRadius) { radius = setRadius; this->MarkDirty(); }
+        void SetPosition(const Point4<T>& setPosition) { position = setPosition; this->MarkDirty(); }
 
         Vector4<T> GetNormalAtPoint(const Point4<T>& point) override;
+
+        /* Roots of the ray/sphere quadratic in increasing order, measured in the ray's own
+        parametrisation so that they match GetPosition(distance) and stay valid for rays transformed
+        into another space. Ray::Intersect and IntersectClosest both take their distances from here. */
+        QuadraticRoots<T> GetIntersectionDistances(const Ray<T>& ray) const
+        {
+            Vector4<T> centerToRayOrigin = ray.GetOrigin() - position;
+            const Vector4<T>& direction = ray.GetDirection();
+
+            T a = direction.GetMagnitudeSquared();
+            T b = T(2) * direction.Dot(centerToRayOrigin);
+            T c = centerToRayOrigin.GetMagnitudeSquared() - radius * radius;
+
+            return SolveQuadratic(a, b, c);
+        }
+
+        /* Closest root inside [tMin, tMax] */
+        bool IntersectClosest(const Ray<T>& ray, T tMin, T tMax, T& distance) const
+        {
+            Statistics::Increment(Counter::SphereTests);
+
+            for (T root : GetIntersectionDistances(ray))
+            {
+                if (root < tMin)
+                    continue;
+
+                if (root > tMax)
+                    return false;
+
+                distance = root;
+                return true;
+            }
+
+            return false;
+        }
 	};
 }
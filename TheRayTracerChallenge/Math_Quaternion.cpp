@@ -0,0 +1,239 @@
+#include "stdafx.h"
+#include "Math_Quaternion.h"
+
+#include <cmath>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+namespace Math
+{
+	template<typename T>
+	Quaternion<T> Quaternion<T>::MakeAxisAngle(const Vector4<T>& axis, const T angle)
+	{
+		T sine = std::sin(angle * T(0.5));
+		return Quaternion<T>(H::Get(axis, C::X) * sine, H::Get(axis, C::Y) * sine, H::Get(axis, C::Z) * sine, std::cos(angle * T(0.5)));
+	}
+
+	template<typename T>
+	Quaternion<T> Quaternion<T>::MakeRotation(const T angleX, const T angleY, const T angleZ)
+	{
+		//Transform<T>::MakeRotation is X * Y * Z, so Z is applied first
+		Quaternion<T> rotationX(std::sin(angleX * T(0.5)), T(0), T(0), std::cos(angleX * T(0.5)));
+		Quaternion<T> rotationY(T(0), std::sin(angleY * T(0.5)), T(0), std::cos(angleY * T(0.5)));
+		Quaternion<T> rotationZ(T(0), T(0), std::sin(angleZ * T(0.5)), std::cos(angleZ * T(0.5)));
+
+		return rotationX * rotationY * rotationZ;
+	}
+
+	template<typename T>
+	Quaternion<T> Quaternion<T>::FromTransform(const Transform<T>& transform)
+	{
+		auto m = [&transform](size_t line, size_t column) { return transform.GetValueAt(line, column); };
+
+		//divide by the largest of the four components, so that the square root is never taken near zero
+		T trace = m(0, 0) + m(1, 1) + m(2, 2);
+		if (trace > T(0))
+		{
+			T scale = std::sqrt(trace + T(1)) * T(2);
+			return Quaternion<T>((m(2, 1) - m(1, 2)) / scale, (m(0, 2) - m(2, 0)) / scale, (m(1, 0) - m(0, 1)) / scale, scale * T(0.25));
+		}
+
+		if (m(0, 0) > m(1, 1) && m(0, 0) > m(2, 2))
+		{
+			T scale = std::sqrt(T(1) + m(0, 0) - m(1, 1) - m(2, 2)) * T(2);
+			return Quaternion<T>(scale * T(0.25), (m(0, 1) + m(1, 0)) / scale, (m(0, 2) + m(2, 0)) / scale, (m(2, 1) - m(1, 2)) / scale);
+		}
+
+		if (m(1, 1) > m(2, 2))
+		{
+			T scale = std::sqrt(T(1) + m(1, 1) - m(0, 0) - m(2, 2)) * T(2);
+			return Quaternion<T>((m(0, 1) + m(1, 0)) / scale, scale * T(0.25), (m(1, 2) + m(2, 1)) / scale, (m(0, 2) - m(2, 0)) / scale);
+		}
+
+		T scale = std::sqrt(T(1) + m(2, 2) - m(0, 0) - m(1, 1)) * T(2);
+		return Quaternion<T>((m(0, 2) + m(2, 0)) / scale, (m(1, 2) + m(2, 1)) / scale, scale * T(0.25), (m(1, 0) - m(0, 1)) / scale);
+	}
+
+	template<typename T>
+	Quaternion<T> Quaternion<T>::Slerp(const Quaternion<T>& from, const Quaternion<T>& to, const T factor)
+	{
+		//q and -q are the same rotation, take the one on the short arc
+		T cosine = from.Dot(to);
+		Quaternion<T> target = cosine < T(0) ? Quaternion<T>(-to.x, -to.y, -to.z, -to.w) : to;
+		cosine = std::abs(cosine);
+
+		T fromWeight = T(1) - factor;
+		T toWeight = factor;
+
+		//nearly parallel, the sine below would vanish; a normalised linear blend is as good there
+		if (cosine < T(0.9995))
+		{
+			T angle = std::acos(cosine);
+			T inverseSine = T(1) / std::sin(angle);
+			fromWeight = std::sin(fromWeight * angle) * inverseSine;
+			toWeight = std::sin(toWeight * angle) * inverseSine;
+		}
+
+		Quaternion<T> result(
+			from.x * fromWeight + target.x * toWeight,
+			from.y * fromWeight + target.y * toWeight,
+			from.z * fromWeight + target.z * toWeight,
+			from.w * fromWeight + target.w * toWeight);
+
+		if (cosine >= T(0.9995))
+			result.Normalize();
+
+		return result;
+	}
+
+	template<typename T>
+	Quaternion<T> Quaternion<T>::GetNormalized() const
+	{
+		Quaternion<T> normalized = *this;
+		normalized.Normalize();
+		return normalized;
+	}
+
+	template<typename T>
+	void Quaternion<T>::Normalize()
+	{
+		T inverseMagnitude = T(1) / GetMagnitude();
+		x *= inverseMagnitude;
+		y *= inverseMagnitude;
+		z *= inverseMagnitude;
+		w *= inverseMagnitude;
+	}
+
+	template<typename T>
+	std::array<std::array<T, 3>, 3> Quaternion<T>::GetRotationLines() const
+	{
+		T xx = x * x, yy = y * y, zz = z * z;
+		T xy = x * y, xz = x * z, yz = y * z;
+		T wx = w * x, wy = w * y, wz = w * z;
+
+		return { {
+			{ T(1) - T(2) * (yy + zz), T(2) * (xy - wz), T(2) * (xz + wy) },
+			{ T(2) * (xy + wz), T(1) - T(2) * (xx + zz), T(2) * (yz - wx) },
+			{ T(2) * (xz - wy), T(2) * (yz + wx), T(1) - T(2) * (xx + yy) } } };
+	}
+
+	template<typename T>
+	Transform<T> Quaternion<T>::ToTransform() const
+	{
+		std::array<std::array<T, 3>, 3> rotation = GetRotationLines();
+		return Transform<T>({ {
+			{ rotation[0][0], rotation[0][1], rotation[0][2], T(0) },
+			{ rotation[1][0], rotation[1][1], rotation[1][2], T(0) },
+			{ rotation[2][0], rotation[2][1], rotation[2][2], T(0) },
+			{ T(0), T(0), T(0), T(1) } } });
+	}
+
+	template<typename T>
+	Vector4<T> Quaternion<T>::Rotate(const Vector4<T>& vector) const
+	{
+		//v + w t + u x t with t = 2 u x v, cheaper than building the matrix for one vector
+		Vector4<T> axis = H::MakeVector(x, y, z);
+		Vector4<T> twiceCross = axis.Cross(vector);
+		twiceCross = H::MakeVector(H::Get(twiceCross, C::X) * T(2), H::Get(twiceCross, C::Y) * T(2), H::Get(twiceCross, C::Z) * T(2));
+		Vector4<T> secondCross = axis.Cross(twiceCross);
+
+		return H::MakeVector(
+			H::Get(vector, C::X) + w * H::Get(twiceCross, C::X) + H::Get(secondCross, C::X),
+			H::Get(vector, C::Y) + w * H::Get(twiceCross, C::Y) + H::Get(secondCross, C::Y),
+			H::Get(vector, C::Z) + w * H::Get(twiceCross, C::Z) + H::Get(secondCross, C::Z));
+	}
+
+	template<typename T>
+	Quaternion<T> operator*(const Quaternion<T>& first, const Quaternion<T>& second)
+	{
+		T x1 = first.GetX(), y1 = first.GetY(), z1 = first.GetZ(), w1 = first.GetW();
+		T x2 = second.GetX(), y2 = second.GetY(), z2 = second.GetZ(), w2 = second.GetW();
+
+		return Quaternion<T>(
+			w1 * x2 + x1 * w2 + y1 * z2 - z1 * y2,
+			w1 * y2 - x1 * z2 + y1 * w2 + z1 * x2,
+			w1 * z2 + x1 * y2 - y1 * x2 + z1 * w2,
+			w1 * w2 - x1 * x2 - y1 * y2 - z1 * z2);
+	}
+
+	template<typename T>
+	bool operator==(const Quaternion<T>& first, const Quaternion<T>& second)
+	{
+		return
+			Equals<T>(first.GetX(), second.GetX()) &&
+			Equals<T>(first.GetY(), second.GetY()) &&
+			Equals<T>(first.GetZ(), second.GetZ()) &&
+			Equals<T>(first.GetW(), second.GetW());
+	}
+
+#pragma region explicit instantiations
+	template class Quaternion<float>;
+	template class Quaternion<double>;
+	template Quaternion<float> operator*(const Quaternion<float>&, const Quaternion<float>&);
+	template Quaternion<double> operator*(const Quaternion<double>&, const Quaternion<double>&);
+	template bool operator==(const Quaternion<float>&, const Quaternion<float>&);
+	template bool operator==(const Quaternion<double>&, const Quaternion<double>&);
+#pragma endregion
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathQuaternion)
+	{
+	public:
+		TEST_METHOD(Quaternion_MatchesTransformRotation)
+		{
+			auto quaternion = Quaternion<double>::MakeRotation(0.3, -1.1, 0.7);
+			auto transform = Transform<double>::MakeRotation(0.3, -1.1, 0.7);
+			auto converted = quaternion.ToTransform();
+
+			for (size_t line = 0; line < 4; ++line)
+				for (size_t column = 0; column < 4; ++column)
+					Assert::IsTrue(std::abs(converted.GetValueAt(line, column) - transform.GetValueAt(line, column)) < 1e-12);
+
+			//back from the matrix, up to the sign
+			auto roundTrip = Quaternion<double>::FromTransform(transform);
+			Assert::IsTrue(std::abs(std::abs(roundTrip.Dot(quaternion)) - 1.0) < 1e-12);
+
+			auto vector = H::MakeVector(1.0, 2.0, -3.0);
+			auto rotated = quaternion.Rotate(vector);
+			auto expected = vector * transform;
+			Assert::IsTrue(std::abs(H::Get(rotated, C::X) - H::Get(expected, C::X)) < 1e-12);
+			Assert::IsTrue(std::abs(H::Get(rotated, C::Y) - H::Get(expected, C::Y)) < 1e-12);
+			Assert::IsTrue(std::abs(H::Get(rotated, C::Z) - H::Get(expected, C::Z)) < 1e-12);
+
+			//composition matches the matrix product
+			auto other = Quaternion<double>::MakeAxisAngle(H::MakeVector(0.0, 1.0, 0.0), 0.4);
+			Assert::IsTrue((quaternion * other).ToTransform() == quaternion.ToTransform() * other.ToTransform());
+			Assert::IsTrue(quaternion * quaternion.GetConjugate() == Quaternion<double>());
+		}
+
+		TEST_METHOD(Quaternion_Slerp)
+		{
+			auto from = Quaternion<float>();
+			auto to = Quaternion<float>::MakeAxisAngle(H::MakeVector(0.0f, 0.0f, 1.0f), GetPiBy2<float>());
+
+			Assert::IsTrue(Quaternion<float>::Slerp(from, to, 0.0f) == from);
+			Assert::IsTrue(Quaternion<float>::Slerp(from, to, 1.0f) == to);
+			Assert::IsTrue(Quaternion<float>::Slerp(from, to, 0.5f) == Quaternion<float>::MakeAxisAngle(H::MakeVector(0.0f, 0.0f, 1.0f), GetPiBy4<float>()));
+
+			//the same target with the opposite sign still takes the short arc
+			Quaternion<float> negated(-to.GetX(), -to.GetY(), -to.GetZ(), -to.GetW());
+			Assert::IsTrue(std::abs(std::abs(Quaternion<float>::Slerp(from, negated, 0.5f).GetW()) - std::cos(GetPiBy4<float>() * 0.5f)) < 1e-6f);
+
+			//nearly equal rotations go through the normalised blend
+			auto close = Quaternion<float>::MakeAxisAngle(H::MakeVector(0.0f, 0.0f, 1.0f), 1e-4f);
+			Assert::IsTrue(std::abs(Quaternion<float>::Slerp(from, close, 0.5f).GetMagnitude() - 1.0f) < 1e-6f);
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Transform.h"
+
+namespace Math
+{
+	/* A rotation as x y z w, with x y z the axis scaled by the sine and w the cosine of half the angle.
+	Four numbers instead of a 4x4 matrix: composing costs 16 multiplies, interpolating stays on the
+	rotation manifold, and the matrix is only built when a transform is actually needed. Same
+	convention as Transform: right handed, and first * second applies second first. */
+	template<typename T>
+	class Quaternion
+	{
+	private:
+		T x, y, z, w;
+
+	public:
+		/* The identity rotation */
+		constexpr Quaternion() : x(T(0)), y(T(0)), z(T(0)), w(T(1)) { }
+		constexpr Quaternion(T setX, T setY, T setZ, T setW) : x(setX), y(setY), z(setZ), w(setW) { }
+
+		/* Around a unit axis */
+		static Quaternion<T> MakeAxisAngle(const Vector4<T>& axis, const T angle);
+
+		/* The rotation of Transform<T>::MakeRotation with the same angles */
+		static Quaternion<T> MakeRotation(const T angleX, const T angleY, const T angleZ);
+
+		/* From the rotation part of transform, which must have no scaling nor shearing */
+		static Quaternion<T> FromTransform(const Transform<T>& transform);
+
+		/* Shortest path spherical interpolation at constant angular speed */
+		static Quaternion<T> Slerp(const Quaternion<T>& from, const Quaternion<T>& to, const T factor);
+
+		constexpr T GetX() const { return x; }
+		constexpr T GetY() const { return y; }
+		constexpr T GetZ() const { return z; }
+		constexpr T GetW() const { return w; }
+
+		constexpr T Dot(const Quaternion<T>& other) const { return x * other.x + y * other.y + z * other.z + w * other.w; }
+		T GetMagnitude() const { return std::sqrt(Dot(*this)); }
+
+		Quaternion<T> GetNormalized() const;
+		void Normalize();
+
+		/* The inverse of a unit quaternion */
+		constexpr Quaternion<T> GetConjugate() const { return Quaternion<T>(-x, -y, -z, w); }
+
+		/* The 3x3 rotation matrix, line by line */
+		std::array<std::array<T, 3>, 3> GetRotationLines() const;
+
+		Transform<T> ToTransform() const;
+
+		Vector4<T> Rotate(const Vector4<T>& vector) const;
+	};
+
+#pragma region operators
+	/* first applied after second, as for Transform */
+	template<typename T>
+	Quaternion<T> operator*(const Quaternion<T>& first, const Quaternion<T>& second);
+
+	/* q and -q are the same rotation, but compare as different quaternions */
+	template<typename T>
+	bool operator==(const Quaternion<T>& first, const Quaternion<T>& second);
+#pragma endregion
+}
@@ -1,9 +1,12 @@
 ﻿#include "stdafx.h"
 #include "Math_Ray.h"
 #include "Math_Primitives.h"
+#include "Math_Acceleration.h"
 #include "Graphics.h"
+#include "Math_Arena.h"
 
 #include <vector>
+#include <algorithm>
 #include <cmath>
 
 #ifdef _MSC_VER
@@ -18,63 +21,12 @@ using CI = Math::Helpers::ColorInput;
 namespace
 {
     template<typename T>
-    std::vector<T> SolveQuadratic(const T &a, const T &b, const T &c)
-    {
-        std::vector<T> solutions;
-
-        T discr = (b * b) - (T(4) * a * c);
-        if (discr < 0) 
-            return solutions;
-
-        else if (discr == 0) 
-            solutions.push_back(T(-0.5) * b / a);
-
-        else 
-        {
-            T q = (b > 0) 
-                ? T(-0.5) * (b + sqrt(discr)) 
-                : T(-0.5) * (b - sqrt(discr));
-
-            auto x0 = q / a;
-            auto x1 = c / q;
-            if (x0 > x1) 
-                std::swap(x0, x1);
-
-            solutions.push_back(x0);
-            solutions.push_back(x1);
-        }
-
-        return solutions;
-    }
-
-    template<typename T>
-	std::vector<T> IntersectSphere(Math::Ray<T> ray, Math::Sphere<T>* obj)
+	Math::QuadraticRoots<T> IntersectSphere(const Math::Ray<T>& ray, const Math::Sphere<T>* obj)
     {
         if (obj == nullptr)
-            return std::vector<T>();
-
-        static const auto pointZero = H::MakePoint<T>(T(0), T(0), T(0));
-        ray.Normalize();
-
-		auto spherePosition = obj->GetPosition();
+            return Math::QuadraticRoots<T>();
 
-        if (!(obj->GetPosition() == pointZero))
-        {
-            auto positionDiff = obj->GetPosition() - pointZero;
-            obj->SetPosition(obj->GetPosition() - positionDiff);
-            ray.SetOrigin(ray.GetOrigin() - positionDiff);
-        }
-
-        Math::Vector4<T> centerToRayOrigin = ray.GetOrigin() - obj->GetPosition();
-        auto dir = ray.GetDirection();
-        auto radiusSquared = obj->GetRadius() * obj->GetRadius();
-
-        float a = dir.GetMagnitudeSquared();
-        float b = 2 * dir.Dot(centerToRayOrigin);
-        float c = centerToRayOrigin.GetMagnitudeSquared() - radiusSquared;
-		
-		obj->SetPosition(spherePosition);
-        return SolveQuadratic(a, b, c);
+        return obj->GetIntersectionDistances(ray);
     }
 }
 
@@ -82,19 +34,32 @@ namespace
 namespace Math
 {
     template<typename T>
-    RayHit<T> Ray<T>::Intersect(Object* obj)
+    RayHit<T> Ray<T>::Intersect(Object* obj, std::pmr::memory_resource* resource) const
     {
-		RayHit<T> ray;
-		std::vector<T> solutions;
+		RayHit<T> ray(resource);
+		QuadraticRoots<T> solutions;
+
+		if (obj == nullptr)
+			return ray;
+
+		ray.objectId = obj->GetObjectId();
 
 		if (IsA(Sphere<T>*, decltype(obj)))
 		{
+			Statistics::Increment(Counter::SphereTests);
 			solutions = IntersectSphere(*this, (Sphere<T>*)(obj));
 		}
 
-		if (solutions.empty())
+		if (solutions.count == 0)
 			return ray;
 
+		//sized once, so a ray costs at most one allocation per list
+		size_t positiveCount = std::count_if(solutions.begin(), solutions.end(), [](T value) { return value >= T(0); });
+		ray.hitDistances.reserve(positiveCount);
+		ray.objectHits.reserve(positiveCount);
+		ray.negativeHitDistances.reserve(solutions.count - positiveCount);
+		ray.negativeObjectHits.reserve(solutions.count - positiveCount);
+
 		for (auto& value : solutions)
 		{
 			auto objectHit = this->GetOrigin() + (this->GetDirection() * value);
@@ -113,6 +78,12 @@ namespace Math
         return ray;
     }
 
+	template<typename T>
+	RayHit<T> Ray<T>::Intersect(const IAccelerationStructure<T>& structure, std::pmr::memory_resource* resource) const
+	{
+		return structure.Intersect(*this, resource);
+	}
+
 	template<typename T>	
 	Ray<T> Ray<T>::Transform(Math::Transform<T>& transform)
 	{
@@ -123,6 +94,10 @@ namespace Math
 		return newRay;
 	}
 
+#pragma region explicit instantiations
+	template class Ray<float>;
+	template class Ray<double>;
+#pragma endregion
 }
 
 
@@ -207,6 +182,43 @@ namespace Math
 
         }
 
+        TEST_METHOD(Ray_SphereIntersection_ArenaHits)
+        {
+            Ray<float> ray{ H::MakePoint<float>(0.0f, 0.0f, -5.0f), H::MakeVector<float>(0.0f, 0.0f, 1.0f) };
+
+            Sphere<float> sphere;
+            sphere.SetRadius(1);
+            sphere.SetPosition(H::MakePoint<float>(0.0f, 0.0f, 0.0f));
+
+            Arena arena(1024);
+            ArenaScope scope(arena);
+            auto intersectionPoints = ray.Intersect(&sphere, &arena);
+            Assert::IsTrue(intersectionPoints.hitDistances.get_allocator().resource() == &arena);
+            Assert::IsTrue(intersectionPoints.hitDistances.size() == 2);
+            Assert::IsTrue(Equalsf(intersectionPoints.hitDistances[0], 4.0f));
+            Assert::IsTrue(intersectionPoints.objectHits.at(1) == H::MakePoint<float>(0.0f, 0.0f, 1.0f));
+            Assert::IsTrue(arena.GetBlockCount() == 1);
+        }
+
+        TEST_METHOD(Ray_SphereIntersection_ClosestMatchesIntersect)
+        {
+            //starting just off the surface, as shadow rays do, where the near root is the least stable
+            Sphere<float> sphere(10.0f, H::MakePoint<float>(3.0f, -2.0f, 50.0f));
+            Ray<float> ray{ H::MakePoint<float>(3.0f, -2.0f, 39.999f), H::MakeVector<float>(0.0f, 0.6f, 0.8f) };
+
+            auto intersectionPoints = ray.Intersect(&sphere);
+            Assert::IsTrue(intersectionPoints.hitDistances.size() == 2);
+
+            float distance;
+            Assert::IsTrue(sphere.IntersectClosest(ray, 0.0f, std::numeric_limits<float>::max(), distance));
+            Assert::IsTrue(distance == intersectionPoints.hitDistances[0]);
+
+            Assert::IsTrue(sphere.IntersectClosest(ray, intersectionPoints.hitDistances[0] * 2.0f, std::numeric_limits<float>::max(), distance));
+            Assert::IsTrue(distance == intersectionPoints.hitDistances[1]);
+
+            Assert::IsFalse(sphere.IntersectClosest(ray, 0.0f, intersectionPoints.hitDistances[0] * 0.5f, distance));
+        }
+
         TEST_METHOD(Ray_SphereIntersection_ZeroPoints_SphereBehindRay)
         {
             auto point = H::MakePoint<float>(0.0f, 0.0f, 5.0f);
@@ -240,6 +252,56 @@ namespace Math
 			Assert::IsTrue(rayTransformed2.GetDirection() == H::MakeVector<float>(0.0f, 3.0f, 0.0f));
 		}
 
+		TEST_METHOD(Ray_InverseDirection)
+		{
+			Ray<float> ray{ H::MakePoint<float>(1.0f, 2.0f, 3.0f), H::MakeVector<float>(2.0f, -4.0f, 0.5f) };
+
+			Assert::IsTrue(Equalsf(ray.GetInverseDirection()[0], 0.5f));
+			Assert::IsTrue(Equalsf(ray.GetInverseDirection()[1], -0.25f));
+			Assert::IsTrue(Equalsf(ray.GetInverseDirection()[2], 2.0f));
+			Assert::IsTrue(ray.GetDirectionSign() == std::array<size_t, 3>{ 0, 1, 0 });
+
+			ray.SetDirection(H::MakeVector<float>(-1.0f, 1.0f, -2.0f));
+			Assert::IsTrue(Equalsf(ray.GetInverseDirection()[2], -0.5f));
+			Assert::IsTrue(ray.GetDirectionSign() == std::array<size_t, 3>{ 1, 0, 1 });
+			Assert::IsTrue(ray.GetOriginCoordinates() == std::array<float, 3>{ 1.0f, 2.0f, 3.0f });
+		}
+
+		TEST_METHOD(Ray_BoundsIntersection)
+		{
+			BoundingBox<float> box(H::MakePoint(-1.0f, -1.0f, -1.0f), H::MakePoint(1.0f, 1.0f, 1.0f));
+			float tEntry = 0.0f;
+
+			Ray<float> ray{ H::MakePoint<float>(0.0f, 0.0f, -5.0f), H::MakeVector<float>(0.0f, 0.0f, 1.0f) };
+			Assert::IsTrue(ray.IntersectBounds(box, 0.0f, 100.0f, tEntry));
+			Assert::IsTrue(Equalsf(tEntry, 4.0f));
+
+			//the box is further away than the allowed distance
+			Assert::IsFalse(ray.IntersectBounds(box, 0.0f, 3.0f, tEntry));
+
+			//negative direction
+			ray = Ray<float>{ H::MakePoint<float>(0.5f, 0.5f, 5.0f), H::MakeVector<float>(0.0f, 0.0f, -1.0f) };
+			Assert::IsTrue(ray.IntersectBounds(box, 0.0f, 100.0f, tEntry));
+			Assert::IsTrue(Equalsf(tEntry, 4.0f));
+
+			//box behind the ray
+			ray = Ray<float>{ H::MakePoint<float>(0.0f, 0.0f, 5.0f), H::MakeVector<float>(0.0f, 0.0f, 1.0f) };
+			Assert::IsFalse(ray.IntersectBounds(box));
+
+			//origin inside the box
+			ray = Ray<float>{ H::MakePoint<float>(0.0f, 0.0f, 0.0f), H::MakeVector<float>(1.0f, 1.0f, 0.0f) };
+			Assert::IsTrue(ray.IntersectBounds(box, 0.0f, 100.0f, tEntry));
+			Assert::IsTrue(Equalsf(tEntry, 0.0f));
+
+			//axis parallel miss and diagonal hit
+			ray = Ray<float>{ H::MakePoint<float>(2.0f, 0.0f, -5.0f), H::MakeVector<float>(0.0f, 0.0f, 1.0f) };
+			Assert::IsFalse(ray.IntersectBounds(box));
+
+			ray = Ray<float>{ H::MakePoint<float>(-5.0f, -5.0f, -5.0f), H::MakeVector<float>(1.0f, 1.0f, 1.0f) };
+			Assert::IsTrue(ray.IntersectBounds(box, 0.0f, 100.0f, tEntry));
+			Assert::IsTrue(Equalsf(tEntry, 4.0f));
+		}
+
 		TEST_METHOD(Ray_SphereIntersection_DawingSphereShadowOnCanvas)
 		{
 			Color4f sphereShadowColor = H::MakeColor(1.0f, 0.0f, 0.0f, 0.5f);
@@ -5,26 +5,41 @@
 #include "Math_Matrix.h"
 #include "Math_Tuple.h"
 #include "Math_Transform.h"
+#include "Math_BoundingBox.h"
 #include <vector>
+#include <memory_resource>
 #include <map>
 #include <unordered_map>
 
 namespace Math
 {
     class Object;
+	template<typename T> class IAccelerationStructure;
 	
+	/* The hit lists are pmr vectors: by default they use the heap, and given a Math::Arena (or any
+	other memory resource) they are allocated from it, so per ray intersections in a frame cost no
+	heap traffic. Copies go back to the default resource; moves keep it. */
 	template<typename T>
 	struct RayHit
 	{
 	public:
 		size_t objectId;
-		std::vector<T> negativeHitDistances;
-		std::vector<Point4<T>> negativeObjectHits;
+		std::pmr::vector<T> negativeHitDistances;
+		std::pmr::vector<Point4<T>> negativeObjectHits;
 
-		std::vector<T> hitDistances;
-		std::vector<Point4<T>> objectHits;
+		std::pmr::vector<T> hitDistances;
+		std::pmr::vector<Point4<T>> objectHits;
 
 		RayHit() : objectId{ size_t(-1) } { }
+
+		explicit RayHit(std::pmr::memory_resource* resource) :
+			objectId{ size_t(-1) },
+			negativeHitDistances{ resource },
+			negativeObjectHits{ resource },
+			hitDistances{ resource },
+			objectHits{ resource }
+		{
+		}
 	};
 
 
@@ -35,30 +50,82 @@ namespace Math
 		Point4<T> origin;
 		Vector4<T> direction;
 
+		/* cached slab test data, refreshed whenever the origin or the direction is set */
+		std::array<T, 3> inverseDirection;
+		std::array<T, 3> originCoordinates;
+		std::array<size_t, 3> directionSign;
+
+		void UpdateSlabData()
+		{
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				T directionValue = Helpers::Get(direction, Helpers::Coordinate(axis));
+				inverseDirection[axis] = T(1) / directionValue;
+				originCoordinates[axis] = Helpers::Get(origin, Helpers::Coordinate(axis));
+				directionSign[axis] = inverseDirection[axis] < T(0) ? 1 : 0;
+			}
+		}
+
 	public:		
 		Ray()
 		{
-			origin = H::MakePoint(T(0), T(0), T(0));
-			direction = H::MakeVector(T(0), T(0), T(0));
+			origin = Helpers::MakePoint(T(0), T(0), T(0));
+			direction = Helpers::MakeVector(T(0), T(0), T(0));
+			UpdateSlabData();
 		}
 		
 		Ray(const Point4<T>& setOrigin, const Vector4<T>& setDirection) :
 			origin(setOrigin),
 			direction(setDirection)
 		{
-
+			UpdateSlabData();
 		}
 
-		Point4<T>& GetOrigin() { return origin; }
-		Vector4<T>& GetDirection() { return direction; }
-		Point4<T> GetPosition(T time) { return origin + direction * time; }
-        void SetOrigin(const Point4<T>& setOrigin) { origin = setOrigin; }
-        void SetDirection(const Vector4<T>& setDirection) { direction = setDirection; }
+		const Point4<T>& GetOrigin() const { return origin; }
+		const Vector4<T>& GetDirection() const { return direction; }
+		Point4<T> GetPosition(T time) const { return MultiplyAdd(origin, direction, time); }
+        void SetOrigin(const Point4<T>& setOrigin) { origin = setOrigin; UpdateSlabData(); }
+        void SetDirection(const Vector4<T>& setDirection) { direction = setDirection; UpdateSlabData(); }
+
+        void Normalize() { direction.Normalize(); UpdateSlabData(); }
 
-        void Normalize() { direction.Normalize(); }
+		const std::array<T, 3>& GetInverseDirection() const { return inverseDirection; }
+		const std::array<T, 3>& GetOriginCoordinates() const { return originCoordinates; }
+		const std::array<size_t, 3>& GetDirectionSign() const { return directionSign; }
 
-        RayHit<T> Intersect(Object* obj);
+        RayHit<T> Intersect(Object* obj, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+		RayHit<T> Intersect(const IAccelerationStructure<T>& structure, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
 		Ray<T> Transform(Transform<T>& transform);
 
+		/* Branchless slab test; the near and far planes are picked through the direction sign,
+		so there is no per-axis swap. Returns the entry distance through tEntry. */
+		bool IntersectBounds(const BoundingBox<T>& box, T tMin, T tMax, T& tEntry) const
+		{
+			T tNearX = (box.GetBound(directionSign[0], 0) - originCoordinates[0]) * inverseDirection[0];
+			T tNearY = (box.GetBound(directionSign[1], 1) - originCoordinates[1]) * inverseDirection[1];
+			T tNearZ = (box.GetBound(directionSign[2], 2) - originCoordinates[2]) * inverseDirection[2];
+
+			T tFarX = (box.GetBound(1 - directionSign[0], 0) - originCoordinates[0]) * inverseDirection[0];
+			T tFarY = (box.GetBound(1 - directionSign[1], 1) - originCoordinates[1]) * inverseDirection[1];
+			T tFarZ = (box.GetBound(1 - directionSign[2], 2) - originCoordinates[2]) * inverseDirection[2];
+
+			//written so that a NaN (origin on a slab plane of an axis parallel ray) keeps the other value
+			T tNear = tNearX > tMin ? tNearX : tMin;
+			tNear = tNearY > tNear ? tNearY : tNear;
+			tNear = tNearZ > tNear ? tNearZ : tNear;
+
+			T tFar = tFarX < tMax ? tFarX : tMax;
+			tFar = tFarY < tFar ? tFarY : tFar;
+			tFar = tFarZ < tFar ? tFarZ : tFar;
+
+			tEntry = tNear;
+			return tNear <= tFar;
+		}
+
+		bool IntersectBounds(const BoundingBox<T>& box, T tMin = T(0), T tMax = std::numeric_limits<T>::max()) const
+		{
+			T tEntry;
+			return IntersectBounds(box, tMin, tMax, tEntry);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,74 @@
+#include "stdafx.h"
+#include "Math_Scene.h"
+#include "Math_Primitives.h"
+#include "Math_TestHelpers.h"
+
+#include <iterator>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+using H = Math::Helpers;
+using C = Math::Helpers::Coordinate;
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathScene)
+	{
+		/* Draws the spheres of one group into storage, which owns the spheres of every group */
+		static std::vector<Sphere<float>*> MakeSpheres(TestHelpers::SphereStorage& storage, size_t count, float minRadius, float maxRadius, unsigned int seed)
+		{
+			auto spheres = TestHelpers::MakeSpheres(count, seed, minRadius, maxRadius);
+			auto pointers = TestHelpers::GetPointers(spheres);
+			std::move(spheres.begin(), spheres.end(), std::back_inserter(storage));
+			return pointers;
+		}
+
+		static void CheckAgainstBruteForce(const TestHelpers::SphereStorage& spheres, const Scenef& scene)
+		{
+			Assert::IsTrue(TestHelpers::CountBruteForceMismatches(scene, spheres, H::MakePoint(0.0f, 0.0f, -90.0f), 50.0f, 0.0f, 300, 41u) == 0);
+		}
+
+	public:
+		TEST_METHOD(Scene_AutoSelection)
+		{
+			TestHelpers::SphereStorage storage;
+			Scenef scene;
+
+			size_t swarm = scene.AddGroup(MakeSpheres(storage, 2000, 0.3f, 0.5f, 1u));
+			size_t mixed = scene.AddGroup(MakeSpheres(storage, 2000, 0.1f, 5.0f, 2u));
+			size_t small = scene.AddGroup(MakeSpheres(storage, 10, 0.3f, 0.5f, 3u));
+			size_t forced = scene.AddGroup(MakeSpheres(storage, 10, 0.3f, 0.5f, 4u), AcceleratorType::UniformGrid);
+
+			Assert::IsTrue(scene.GetAcceleratorType(swarm) == AcceleratorType::UniformGrid);
+			Assert::IsTrue(scene.GetAcceleratorType(mixed) != AcceleratorType::UniformGrid);
+			Assert::IsTrue(scene.GetAcceleratorType(small) != AcceleratorType::UniformGrid);
+			Assert::IsTrue(scene.GetAcceleratorType(forced) == AcceleratorType::UniformGrid);
+		}
+
+		TEST_METHOD(Scene_GroupsMatchBruteForce)
+		{
+			TestHelpers::SphereStorage storage;
+			Scenef scene;
+			scene.AddGroup(MakeSpheres(storage, 1500, 0.4f, 0.6f, 5u));
+			scene.AddGroup(MakeSpheres(storage, 100, 0.5f, 4.0f, 6u), AcceleratorType::BVH4);
+			scene.AddGroup(MakeSpheres(storage, 100, 0.5f, 4.0f, 7u), AcceleratorType::BVH8);
+
+			CheckAgainstBruteForce(storage, scene);
+
+			//move everything and let each group catch up its own way
+			unsigned int seed = 8u;
+			for (auto& sphere : storage)
+				sphere->SetPosition(sphere->GetPosition() + H::MakeVector(TestHelpers::NextRandom(seed) * 4.0f - 2.0f, TestHelpers::NextRandom(seed) * 4.0f - 2.0f, 0.0f));
+
+			scene.Update();
+			CheckAgainstBruteForce(storage, scene);
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_BoundingBox.h"
+#include "Math_Ray.h"
+#include "Math_Primitives.h"
+#include "Math_Acceleration.h"
+#include "Math_BVH.h"
+#include "Math_Grid.h"
+#include "Math_Trace.h"
+#include <vector>
+#include <memory>
+
+namespace Math
+{
+	enum class AcceleratorType : int
+	{
+		Auto = 0,
+		BVH4,
+		BVH8,
+		UniformGrid
+	};
+
+	/* Objects grouped by how they are best accelerated; each group owns its own structure and the
+	scene answers ray queries over all of them. Auto picks a uniform grid for large groups of
+	similar spheres, which it rebuilds every update, and a wide BVH, refitted on update, otherwise. */
+	template<typename T>
+	class Scene : public IAccelerationStructure<T>
+	{
+	public:
+		static const size_t GridMinObjectCount = 1024;
+		static constexpr T GridMaxRadiusRatio = T(2);
+
+	protected:
+		struct Group
+		{
+			std::vector<Sphere<T>*> objects;
+			AcceleratorType requestedType;
+			AcceleratorType type;
+			std::unique_ptr<IAccelerationStructure<T>> accelerator;
+		};
+
+		std::vector<Group> groups;
+
+		static AcceleratorType ResolveType(const std::vector<Sphere<T>*>& objects, AcceleratorType requestedType)
+		{
+			if (requestedType != AcceleratorType::Auto)
+				return requestedType;
+
+#ifdef BVH_USE_AVX
+			AcceleratorType bvhType = AcceleratorType::BVH8;
+#else
+			AcceleratorType bvhType = AcceleratorType::BVH4;
+#endif
+
+			if (objects.size() < GridMinObjectCount)
+				return bvhType;
+
+			T minRadius = std::numeric_limits<T>::max();
+			T maxRadius = T(0);
+			for (const Sphere<T>* object : objects)
+			{
+				minRadius = object->GetRadius() < minRadius ? object->GetRadius() : minRadius;
+				maxRadius = object->GetRadius() > maxRadius ? object->GetRadius() : maxRadius;
+			}
+
+			return maxRadius <= minRadius * GridMaxRadiusRatio ? AcceleratorType::UniformGrid : bvhType;
+		}
+
+		static void BuildGroup(Group& group)
+		{
+			TRACE_ZONE("scene group build");
+
+			group.type = ResolveType(group.objects, group.requestedType);
+
+			switch (group.type)
+			{
+			case AcceleratorType::BVH8:
+				group.accelerator = std::make_unique<BVHAccelerator<T, 8>>(group.objects);
+				break;
+			case AcceleratorType::UniformGrid:
+				group.accelerator = std::make_unique<Math::UniformGrid<T>>(group.objects);
+				break;
+			default:
+				group.accelerator = std::make_unique<BVHAccelerator<T, 4>>(group.objects);
+				break;
+			}
+		}
+
+	public:
+		size_t AddGroup(const std::vector<Sphere<T>*>& objects, AcceleratorType type = AcceleratorType::Auto)
+		{
+			groups.push_back(Group{ objects, type, type, nullptr });
+			BuildGroup(groups.back());
+			return groups.size() - 1;
+		}
+
+		void SetGroupObjects(size_t index, const std::vector<Sphere<T>*>& objects)
+		{
+			groups[index].objects = objects;
+			BuildGroup(groups[index]);
+		}
+
+		/* Brings every group up to date with the objects moved since the last update */
+		void Update()
+		{
+			for (Group& group : groups)
+			{
+				switch (group.type)
+				{
+				case AcceleratorType::BVH4:
+					static_cast<BVHAccelerator<T, 4>*>(group.accelerator.get())->Update();
+					break;
+				case AcceleratorType::BVH8:
+					static_cast<BVHAccelerator<T, 8>*>(group.accelerator.get())->Update();
+					break;
+				default:
+					BuildGroup(group);
+					break;
+				}
+			}
+		}
+
+		bool IntersectClosest(const Ray<T>& ray, T& tClosest, Object*& closestObject) const override
+		{
+			bool hit = false;
+			for (const Group& group : groups)
+			{
+				if (ray.IntersectBounds(group.accelerator->GetBounds(), T(0), tClosest))
+					hit |= group.accelerator->IntersectClosest(ray, tClosest, closestObject);
+			}
+
+			return hit;
+		}
+
+		BoundingBox<T> GetBounds() const override
+		{
+			BoundingBox<T> bounds;
+			for (const Group& group : groups)
+				bounds.Merge(group.accelerator->GetBounds());
+
+			return bounds;
+		}
+
+		size_t GetGroupCount() const { return groups.size(); }
+		AcceleratorType GetAcceleratorType(size_t index) const { return groups[index].type; }
+		const IAccelerationStructure<T>& GetAccelerator(size_t index) const { return *groups[index].accelerator; }
+	};
+
+	using Scenef = Math::Scene<float>;
+}
@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "Math_Statistics.h"
+
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+namespace Math
+{
+	thread_local RenderStatistics Statistics::threadStatistics;
+
+	const char* RenderStatistics::GetName(Counter counter)
+	{
+		switch (counter)
+		{
+		case Counter::PrimaryRays:
+			return "primary rays";
+		case Counter::ShadowRays:
+			return "shadow rays";
+		case Counter::SphereTests:
+			return "sphere tests";
+		case Counter::BVHNodeVisits:
+			return "BVH node visits";
+		case Counter::GridCellVisits:
+			return "grid cell visits";
+		case Counter::ShadingCalls:
+			return "shading calls";
+		case Counter::MatrixInversions:
+			return "matrix inversions";
+		case Counter::Allocations:
+			return "allocations";
+		case Counter::AllocatedBytes:
+			return "allocated bytes";
+		default:
+			return "unknown";
+		}
+	}
+
+	void RenderStatistics::Dump(std::ostream& out) const
+	{
+		uint64_t primaryRays = Get(Counter::PrimaryRays);
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			char line[96];
+			if (primaryRays > 0)
+				snprintf(line, sizeof(line), "%-20s %14llu %12.3f/ray\n", GetName(Counter(i)), (unsigned long long)values[i], double(values[i]) / double(primaryRays));
+			else
+				snprintf(line, sizeof(line), "%-20s %14llu\n", GetName(Counter(i)), (unsigned long long)values[i]);
+
+			out << line;
+		}
+	}
+
+	std::string RenderStatistics::ToString() const
+	{
+		std::stringstream ss;
+		Dump(ss);
+		return ss.str();
+	}
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathStatistics)
+	{
+	public:
+		TEST_METHOD(Statistics_PerThread)
+		{
+			Statistics::ResetThreadStatistics();
+			Statistics::Increment(Counter::SphereTests);
+			Statistics::Increment(Counter::SphereTests, 4);
+
+			RenderStatistics other;
+			std::thread([&other]()
+			{
+				Statistics::Increment(Counter::SphereTests, 10);
+				Statistics::Increment(Counter::PrimaryRays);
+				other = Statistics::GetThreadStatistics();
+			}).join();
+
+			//the other thread's counts stay on the other thread
+			Assert::IsTrue(Statistics::GetThreadStatistics().Get(Counter::SphereTests) == 5);
+			Assert::IsTrue(Statistics::GetThreadStatistics().Get(Counter::PrimaryRays) == 0);
+
+			RenderStatistics merged = Statistics::GetThreadStatistics();
+			merged += other;
+			Assert::IsTrue(merged.Get(Counter::SphereTests) == 15);
+			Assert::IsTrue(merged.GetRayCount() == 1);
+			Assert::IsTrue((merged - other).Get(Counter::SphereTests) == 5);
+
+			std::string dump = merged.ToString();
+			Assert::IsTrue(dump.find("sphere tests") != std::string::npos);
+			Assert::IsTrue(dump.find("15.000/ray") != std::string::npos);
+		}
+	};
+}
+#endif
+#pragma endregion
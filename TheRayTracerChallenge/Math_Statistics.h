@@ -0,0 +1,82 @@
+#pragma once
+
+#include "stdafx.h"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Math
+{
+	enum class Counter : int
+	{
+		PrimaryRays = 0,
+		ShadowRays,
+		SphereTests,
+		BVHNodeVisits,
+		GridCellVisits,
+		ShadingCalls,
+		MatrixInversions, /*inverses computed by SquareMatrix::GetInverse*/
+		Allocations, /*heap allocations, counted when the allocation hook is linked (Math_Allocation.h)*/
+		AllocatedBytes,
+		Count
+	};
+
+	/* A snapshot of the counters; one per thread while rendering, merged into one per frame */
+	struct RenderStatistics
+	{
+		std::array<uint64_t, size_t(Counter::Count)> values{};
+
+		uint64_t Get(Counter counter) const { return values[size_t(counter)]; }
+		uint64_t GetRayCount() const { return Get(Counter::PrimaryRays) + Get(Counter::ShadowRays); }
+
+		RenderStatistics& operator+=(const RenderStatistics& other)
+		{
+			for (size_t i = 0; i < values.size(); ++i)
+				values[i] += other.values[i];
+
+			return *this;
+		}
+
+		RenderStatistics operator-(const RenderStatistics& other) const
+		{
+			RenderStatistics difference;
+			for (size_t i = 0; i < values.size(); ++i)
+				difference.values[i] = values[i] - other.values[i];
+
+			return difference;
+		}
+
+		static const char* GetName(Counter counter);
+
+		/* One "name: value" line per counter, with the per primary ray ratio when there are primary rays */
+		void Dump(std::ostream& out) const;
+		std::string ToString() const;
+	};
+
+	/* Counters of the calling thread. Incrementing is a plain add on thread local storage, so
+	the hot paths can count without contention; readers take snapshots of their own thread and
+	merge them, as Graphics::Renderer does at the end of each frame. */
+	class Statistics
+	{
+	private:
+		static thread_local RenderStatistics threadStatistics;
+
+	public:
+		static void Increment(Counter counter, uint64_t amount = 1) { threadStatistics.values[size_t(counter)] += amount; }
+		static const RenderStatistics& GetThreadStatistics() { return threadStatistics; }
+		static void ResetThreadStatistics() { threadStatistics = RenderStatistics(); }
+	};
+
+	/* What the calling thread counted since the phase started */
+	class StatisticsPhase
+	{
+	private:
+		RenderStatistics start;
+
+	public:
+		StatisticsPhase() : start{ Statistics::GetThreadStatistics() } { }
+
+		RenderStatistics Get() const { return Statistics::GetThreadStatistics() - start; }
+	};
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "stdafx.h"
+#include "Math_Common.h"
+#include "Math_Tuple.h"
+#include "Math_Ray.h"
+#include "Math_Primitives.h"
+#include "Math_Acceleration.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace Math
+{
+	/* Fixtures of the acceleration structure tests and of the benchmarks: a seeded generator, so that
+	runs are the same on every platform, random sphere sets and a brute force reference for the
+	closest hit along a ray. */
+	namespace TestHelpers
+	{
+		using SphereStorage = std::vector<std::unique_ptr<Sphere<float>>>;
+
+		/* Linear congruential generator, uniform in [0, 1) */
+		inline float NextRandom(unsigned int& state)
+		{
+			state = state * 1664525u + 1013904223u;
+			return float(state >> 8) / float(1 << 24);
+		}
+
+		inline std::vector<Sphere<float>*> GetPointers(const SphereStorage& spheres)
+		{
+			std::vector<Sphere<float>*> pointers;
+			for (const auto& sphere : spheres)
+				pointers.push_back(sphere.get());
+
+			return pointers;
+		}
+
+		/* Centres in [-halfExtent, halfExtent) on every axis, radii in [minRadius, maxRadius) */
+		inline SphereStorage MakeSpheres(size_t count, unsigned int seed, float minRadius, float maxRadius, float halfExtent = 50.0f)
+		{
+			SphereStorage spheres;
+			for (size_t i = 0; i < count; ++i)
+			{
+				auto position = Helpers::MakePoint(
+					(NextRandom(seed) * 2.0f - 1.0f) * halfExtent,
+					(NextRandom(seed) * 2.0f - 1.0f) * halfExtent,
+					(NextRandom(seed) * 2.0f - 1.0f) * halfExtent);
+
+				spheres.push_back(std::make_unique<Sphere<float>>(minRadius + NextRandom(seed) * (maxRadius - minRadius), position));
+			}
+
+			return spheres;
+		}
+
+		/* From origin towards a random point with x and y in [-halfExtent, halfExtent) and z in [-depth, depth) */
+		inline Ray<float> MakeRandomRay(const Point4<float>& origin, float halfExtent, float depth, unsigned int& seed)
+		{
+			auto target = Helpers::MakePoint(
+				(NextRandom(seed) * 2.0f - 1.0f) * halfExtent,
+				(NextRandom(seed) * 2.0f - 1.0f) * halfExtent,
+				(NextRandom(seed) * 2.0f - 1.0f) * depth);
+
+			auto direction = target - origin;
+			direction.Normalize();
+			return Ray<float>{ origin, direction };
+		}
+
+		/* Closest hit by testing every sphere; closestObject stays null on a miss */
+		inline bool IntersectBruteForce(const SphereStorage& spheres, const Ray<float>& ray, float& closestDistance, Object*& closestObject)
+		{
+			closestDistance = std::numeric_limits<float>::max();
+			closestObject = nullptr;
+			for (const auto& sphere : spheres)
+			{
+				float distance;
+				if (sphere->IntersectClosest(ray, 0.0f, closestDistance, distance))
+				{
+					closestDistance = distance;
+					closestObject = sphere.get();
+				}
+			}
+
+			return closestObject != nullptr;
+		}
+
+		/* Casts rayCount random rays (MakeRandomRay) and counts those on which structure and the brute
+		force over spheres disagree: on whether there is a hit, on its distance beyond distanceTolerance
+		relative to it and, when compareObjects is set, on the object hit. Structures that hit copies of
+		the spheres, as instances do, leave compareObjects off. */
+		inline size_t CountBruteForceMismatches(const IAccelerationStructure<float>& structure, const SphereStorage& spheres,
+			const Point4<float>& origin, float halfExtent, float depth, size_t rayCount, unsigned int seed,
+			float distanceTolerance = GetEpsilon<float>(), bool compareObjects = true)
+		{
+			size_t mismatches = 0;
+			for (size_t i = 0; i < rayCount; ++i)
+			{
+				Ray<float> ray = MakeRandomRay(origin, halfExtent, depth, seed);
+
+				float expectedDistance;
+				Object* expectedObject;
+				bool expectedHit = IntersectBruteForce(spheres, ray, expectedDistance, expectedObject);
+
+				float distance = std::numeric_limits<float>::max();
+				Object* object = nullptr;
+				bool hit = structure.IntersectClosest(ray, distance, object);
+
+				bool matches = hit == expectedHit;
+				if (matches && hit)
+				{
+					matches = std::abs(distance - expectedDistance) <= distanceTolerance * std::max(expectedDistance, 1.0f);
+					if (compareObjects)
+						matches = matches && object == expectedObject;
+				}
+
+				if (!matches)
+					++mismatches;
+			}
+
+			return mismatches;
+		}
+	}
+}
@@ -0,0 +1,260 @@
+#include "stdafx.h"
+#include "Math_Trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include "CppUnitTest.h"
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+#endif
+
+namespace
+{
+	struct TraceEvent
+	{
+		const char* name;
+		int64_t start;
+		int64_t end;
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t track;
+		bool inUse; /*owned by a running thread*/
+		std::vector<TraceEvent> events;
+	};
+
+	const std::chrono::steady_clock::time_point traceEpoch = std::chrono::steady_clock::now();
+
+	std::mutex registryMutex;
+	std::vector<std::unique_ptr<ThreadBuffer>> buffers; /*kept after their thread exits, until exported*/
+	std::map<std::string, uint32_t> tracksByName;
+	std::vector<std::string> trackNames;
+
+	/* Hands the buffer back when its thread exits or changes name, so that the next thread of the
+	same name records into it instead of adding a buffer every frame */
+	struct ThreadBufferOwner
+	{
+		ThreadBuffer* buffer = nullptr;
+
+		void Release()
+		{
+			if (buffer == nullptr)
+				return;
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			buffer->inUse = false;
+			buffer = nullptr;
+		}
+
+		~ThreadBufferOwner() { Release(); }
+	};
+
+	thread_local ThreadBufferOwner threadBuffer;
+	thread_local std::string threadName;
+
+	uint32_t AddTrack(const std::string& name)
+	{
+		trackNames.push_back(name);
+		return uint32_t(trackNames.size() - 1);
+	}
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		if (threadBuffer.buffer != nullptr)
+			return *threadBuffer.buffer;
+
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		uint32_t track;
+		if (threadName.empty())
+		{
+			track = AddTrack("thread " + std::to_string(trackNames.size()));
+		}
+		else
+		{
+			auto entry = tracksByName.find(threadName);
+			track = entry != tracksByName.end() ? entry->second : AddTrack(threadName);
+			tracksByName[threadName] = track;
+
+			for (const auto& buffer : buffers)
+			{
+				if (buffer->track == track && !buffer->inUse)
+				{
+					buffer->inUse = true;
+					threadBuffer.buffer = buffer.get();
+					return *buffer;
+				}
+			}
+		}
+
+		buffers.push_back(std::make_unique<ThreadBuffer>(ThreadBuffer{ track, true, {} }));
+		threadBuffer.buffer = buffers.back().get();
+		return *threadBuffer.buffer;
+	}
+
+	void WriteEscaped(std::ostream& out, const std::string& text)
+	{
+		for (char character : text)
+		{
+			if (character == '"' || character == '\\')
+				out << '\\';
+
+			out << character;
+		}
+	}
+}
+
+namespace Math
+{
+	std::atomic<bool> Trace::enabled{ false };
+
+	int64_t Trace::Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - traceEpoch).count();
+	}
+
+	void Trace::SetThreadName(const std::string& name)
+	{
+		if (name == threadName)
+			return;
+
+		//the next event opens a buffer on the track of the new name
+		threadName = name;
+		threadBuffer.Release();
+	}
+
+	void Trace::Record(const char* name, int64_t start, int64_t end)
+	{
+		GetThreadBuffer().events.push_back(TraceEvent{ name, start, end });
+	}
+
+	size_t Trace::GetEventCount()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		size_t count = 0;
+		for (const auto& buffer : buffers)
+			count += buffer->events.size();
+
+		return count;
+	}
+
+	size_t Trace::GetBufferCount()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+		return buffers.size();
+	}
+
+	void Trace::Clear()
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		for (const auto& buffer : buffers)
+			buffer->events.clear();
+	}
+
+	void Trace::WriteChromeTrace(std::ostream& out)
+	{
+		std::lock_guard<std::mutex> lock(registryMutex);
+
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+		bool first = true;
+		for (size_t track = 0; track < trackNames.size(); ++track)
+		{
+			out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track << ",\"args\":{\"name\":\"";
+			WriteEscaped(out, trackNames[track]);
+			out << "\"}}";
+			first = false;
+		}
+
+		char timing[64];
+		for (const auto& buffer : buffers)
+		{
+			for (const TraceEvent& event : buffer->events)
+			{
+				out << (first ? "\n" : ",\n") << "{\"name\":\"";
+				WriteEscaped(out, event.name);
+				snprintf(timing, sizeof(timing), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", double(event.start) / 1e3, double(event.end - event.start) / 1e3);
+				out << timing << ",\"pid\":1,\"tid\":" << buffer->track << "}";
+				first = false;
+			}
+		}
+
+		out << "\n]}\n";
+	}
+}
+
+#pragma region tests here
+#ifdef _MSC_VER
+namespace Math
+{
+	TEST_CLASS(TestMathTrace)
+	{
+	public:
+		TEST_METHOD(Trace_Zones)
+		{
+			Trace::Disable();
+			Trace::Clear();
+			{
+				TRACE_ZONE("disabled");
+			}
+			Assert::IsTrue(Trace::GetEventCount() == 0);
+
+			Trace::Enable();
+			{
+				TRACE_ZONE("outer");
+				TRACE_ZONE("inner");
+			}
+
+			for (size_t frame = 0; frame < 2; ++frame)
+			{
+				std::thread([]()
+				{
+					Trace::SetThreadName("test worker");
+					TRACE_ZONE("work");
+				}).join();
+			}
+			//threads restarted under the same name, as render workers every frame, reuse one buffer
+			size_t bufferCount = Trace::GetBufferCount();
+			for (size_t frame = 0; frame < 4; ++frame)
+			{
+				std::thread([]() { Trace::SetThreadName("test worker"); }).join();
+				std::thread([]()
+				{
+					Trace::SetThreadName("test worker");
+					TRACE_ZONE("work");
+				}).join();
+			}
+			Trace::Disable();
+
+			Assert::IsTrue(Trace::GetBufferCount() == bufferCount);
+			Assert::IsTrue(Trace::GetEventCount() == 8);
+
+			std::stringstream json;
+			Trace::WriteChromeTrace(json);
+			std::string text = json.str();
+
+			Assert::IsTrue(text.find("\"traceEvents\"") != std::string::npos);
+			Assert::IsTrue(text.find("\"name\":\"inner\",\"ph\":\"X\"") != std::string::npos);
+
+			//both worker threads report on the one track of their name
+			size_t nameRecord = text.find("\"args\":{\"name\":\"test worker\"}");
+			Assert::IsTrue(nameRecord != std::string::npos);
+			Assert::IsTrue(text.find("\"args\":{\"name\":\"test worker\"}", nameRecord + 1) == std::string::npos);
+
+			Trace::Clear();
+			Assert::IsTrue(Trace::GetEventCount() == 0);
+		}
+	};
+}
+#endif
+#pragma endregion
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "stdafx.h"
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace Math
+{
+	/* Scoped timing zones exported as Chrome trace_event JSON (chrome://tracing, Perfetto).
+	Recording is off until Enable; a disabled zone costs one relaxed load and a branch, and
+	defining RAYTRACER_NO_TRACING compiles the zones out entirely. Each thread records into its
+	own buffer. Threads that share a name through SetThreadName share a track, so the workers a
+	renderer starts every frame keep appearing on the same rows. */
+	class Trace
+	{
+	private:
+		static std::atomic<bool> enabled;
+
+	public:
+		static void Enable() { enabled.store(true, std::memory_order_relaxed); }
+		static void Disable() { enabled.store(false, std::memory_order_relaxed); }
+		static bool IsEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+		/* Nanoseconds since the first call */
+		static int64_t Now();
+
+		/* Names the track of the calling thread; unnamed threads get a track of their own */
+		static void SetThreadName(const std::string& name);
+
+		/* name must outlive the trace, zones pass string literals */
+		static void Record(const char* name, int64_t start, int64_t end);
+
+		static size_t GetEventCount();
+
+		/* Per thread buffers held. A thread that exits hands its buffer to the next one of the same
+		name, so workers started every frame do not add any */
+		static size_t GetBufferCount();
+
+		/* Drops every recorded event; not to be called while zones are open on other threads */
+		static void Clear();
+
+		/* Writes the recorded events as complete ("X") events plus one thread_name record per
+		track; not to be called while zones are open on other threads */
+		static void WriteChromeTrace(std::ostream& out);
+	};
+
+	class TraceZone
+	{
+	private:
+		const char* name;
+		int64_t start;
+
+	public:
+		explicit TraceZone(const char* setName) : name{ setName }, start{ Trace::IsEnabled() ? Trace::Now() : -1 } { }
+
+		~TraceZone()
+		{
+			if (start >= 0)
+				Trace::Record(name, start, Trace::Now());
+		}
+
+		TraceZone(const TraceZone&) = delete;
+		TraceZone& operator=(const TraceZone&) = delete;
+	};
+}
+
+#define TRACE_CONCAT_INNER(first, second) first##second
+#define TRACE_CONCAT(first, second) TRACE_CONCAT_INNER(first, second)
+
+#ifdef RAYTRACER_NO_TRACING
+#define TRACE_ZONE(name)
+#else
+#define TRACE_ZONE(name) Math::TraceZone TRACE_CONCAT(traceZone, __LINE__)(name)
+#endif
@@ -95,52 +95,16 @@ namespace
 
 namespace Math
 {   
-	template<typename T>
-	Transform<T> Transform<T>::MakeTranslation(const T x, const T y, const T z)
-	{
-		Transform<T> translation = Transform<T>::Identity();
-		translation.SetOriginalValueAt(0, 3, x);
-		translation.SetOriginalValueAt(1, 3, y);
-		translation.SetOriginalValueAt(2, 3, z);
-
-		return translation;
-	}
-
-	template<typename T>
-	Transform<T> Transform<T>::MakeScaling(const T x, const T y, const T z)
-	{
-		Transform<T> scaling = Transform<T>::Identity();
-		scaling.SetOriginalValueAt(0, 0, x);
-		scaling.SetOriginalValueAt(1, 1, y);
-		scaling.SetOriginalValueAt(2, 2, z);
-		return scaling;
-	}
-
 	template<typename T>
 	Transform<T> Transform<T>::MakeRotation(const T radiansX, const T radiansY, const T radiansZ)
 	{
-		return MakeRotationCompound(radiansX, radiansY, radiansZ);
-		//return MakeRotationInplace(radiansX, radiansY, radiansZ);
+		return MakeRotationInplace(radiansX, radiansY, radiansZ);
 	}
 
-	template<typename T>
-	Transform<T> Transform<T>::MakeShearing(
-		const T xOverY, const T xOverZ,
-		const T yOverX, const T yOverZ,
-		const T zOverX, const T zOverY)
-	{
-		Transform<T> shearing = Transform<T>::Identity();
-		shearing.SetOriginalValueAt(0, 1, xOverY);
-		shearing.SetOriginalValueAt(0, 2, xOverZ);
-
-		shearing.SetOriginalValueAt(1, 0, yOverX);
-		shearing.SetOriginalValueAt(1, 2, yOverZ);
-
-		shearing.SetOriginalValueAt(2, 0, zOverX);
-		shearing.SetOriginalValueAt(2, 1, zOverY);
-
-		return shearing;
-	}
+#pragma region explicit instantiations
+	template class Transform<float>;
+	template class Transform<double>;
+#pragma endregion
 }
 
 #pragma region Math Tests
@@ -362,6 +326,123 @@ namespace Math
 			canvas.SetFilename("clockplot.ppm");
 			canvas.WritePPMFile();
 		}
+
+		TEST_METHOD(Transform_ConstexprBuilders)
+		{
+			//evaluated by the compiler, a failure here does not build
+			constexpr auto origin = H::MakePoint(1.0f, 2.0f, 3.0f);
+			constexpr auto translation = Transform<float>::MakeTranslation(5.0f, -3.0f, 2.0f);
+			constexpr auto scaling = Transform<float>::MakeScaling(2.0f, 3.0f, 4.0f);
+			constexpr auto shearing = Transform<float>::MakeShearing(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+			constexpr auto identity = Transform<double>::Identity();
+
+			static_assert(H::Get(origin, C::W) == 1.0f);
+			static_assert(translation.GetValueAt(0, 3) == 5.0f && translation.GetValueAt(3, 3) == 1.0f);
+			static_assert(scaling.GetValueAt(2, 2) == 4.0f && scaling.GetValueAt(0, 3) == 0.0f);
+			static_assert(shearing.GetValueAt(0, 1) == 1.0f);
+			static_assert(identity.GetValueAt(2, 2) == 1.0 && identity.GetValueAt(2, 1) == 0.0);
+
+			Assert::IsTrue(origin * translation == H::MakePoint(6.0f, -1.0f, 5.0f));
+			Assert::IsTrue(origin * scaling == H::MakePoint(2.0f, 6.0f, 12.0f));
+			Assert::IsTrue(origin * shearing == H::MakePoint(3.0f, 2.0f, 3.0f));
+		}
+
+		TEST_METHOD(Transform_CopyKeepsTransposition)
+		{
+			auto transform = Transform<float>::MakeTranslation(1.0f, 2.0f, 3.0f);
+			transform.SetTransposed(true);
+
+			Transform<float> assigned = Transform<float>::Identity();
+			assigned = transform;
+			Transform<float> copied(transform);
+
+			Assert::IsTrue(assigned == transform);
+			Assert::IsTrue(copied == transform);
+		}
+
+		TEST_METHOD(Transform_Batches)
+		{
+			auto transform = Transform<float>::MakeTranslation(10.0f, 5.0f, 7.0f) * Transform<float>::MakeScaling(2.0f, 1.0f, 0.5f) * Transform<float>::MakeRotation(0.3f, 0.0f, 0.7f);
+
+			//more than one chunk, with a partial last one
+			const size_t count = BatchChunkSize * 2 + 3;
+			std::vector<Point4f> points;
+			std::vector<Vector4f> vectors;
+			for (size_t i = 0; i < count; ++i)
+			{
+				float value = float(i % 97) * 0.25f;
+				points.push_back(H::MakePoint(value, 1.0f - value, 2.0f));
+				vectors.push_back(H::MakeVector(1.0f, value, -value));
+			}
+
+			std::vector<Point4f> transformedPoints(count);
+			transform.TransformPoints(std::execution::par, points, transformedPoints);
+
+			std::vector<Vector4f> transformedVectors = vectors;
+			transform.TransformVectors(transformedVectors, transformedVectors);
+
+			std::vector<Vector4f> transformedNormals(count);
+			transform.TransformNormals(std::execution::par, vectors, transformedNormals);
+
+			auto normalTransform = transform.GetInverse();
+			normalTransform.SetTransposed(true);
+			for (size_t i = 0; i < count; i += 101)
+			{
+				Assert::IsTrue(transformedPoints[i] == points[i] * transform);
+				Assert::IsTrue(transformedVectors[i] == vectors[i] * transform);
+				Assert::IsTrue(transformedNormals[i] == (vectors[i] * normalTransform).GetNormalized());
+			}
+
+			std::vector<Point4f> tooShort(count - 1);
+			bool thrown = false;
+			try { transform.TransformPoints(points, tooShort); }
+			catch (const std::runtime_error&) { thrown = true; }
+			Assert::IsTrue(thrown);
+		}
+
+		TEST_METHOD(CachedTransform_InvertedOncePerChange)
+		{
+			auto transform = Transform<float>::MakeTranslation(10.0f, 5.0f, 7.0f) * Transform<float>::MakeScaling(2.0f, 2.0f, 2.0f);
+			auto inverse = transform.GetInverse();
+			StatisticsPhase phase;
+
+			CachedTransform<float> cached(transform);
+			CachedTransform<float> copied(cached);
+			CachedTransform<float> assigned;
+			assigned = copied;
+			Assert::IsTrue(phase.Get().Get(Counter::MatrixInversions) == 1);
+
+			Assert::IsTrue(assigned.GetTransform() == transform);
+			Assert::IsTrue(assigned.GetInverse() == inverse);
+			Assert::IsTrue(Equals<float>(assigned.GetDeterminant(), 8.0f));
+			Assert::IsTrue(assigned.GetNormalTransform().GetValueAt(0, 3) == inverse.GetValueAt(3, 0));
+
+			//mutation recomputes, and only the mutated copy
+			assigned.SetTransform(Transform<float>::MakeScaling(4.0f, 4.0f, 4.0f));
+			Assert::IsTrue(phase.Get().Get(Counter::MatrixInversions) == 2);
+			Assert::IsTrue(Equals<float>(assigned.GetInverse().GetValueAt(0, 0), 0.25f));
+			Assert::IsTrue(cached.GetInverse() == copied.GetInverse());
+			Assert::IsTrue(phase.Get().Get(Counter::MatrixInversions) == 2);
+		}
+
+		TEST_METHOD(CachedTransform_MakeBatch)
+		{
+			std::vector<Transform<float>> transforms;
+			for (size_t index = 0; index < 19; ++index)
+				transforms.push_back(Transform<float>::MakeTranslation(float(index), 1.0f, 2.0f) * Transform<float>::MakeScaling(1.0f + float(index), 2.0f, 0.5f));
+
+			auto batch = CachedTransform<float>::MakeBatch(std::execution::par, transforms);
+			Assert::IsTrue(batch.size() == transforms.size());
+
+			for (size_t index = 0; index < transforms.size(); ++index)
+			{
+				CachedTransform<float> single(transforms[index]);
+				Assert::IsTrue(batch[index].GetTransform() == single.GetTransform());
+				Assert::IsTrue(batch[index].GetInverse() == single.GetInverse());
+				Assert::IsTrue(batch[index].GetNormalTransform() == single.GetNormalTransform());
+				Assert::IsTrue(Equals<float>(batch[index].GetDeterminant(), single.GetDeterminant()));
+			}
+		}
 	};
 }
 #endif
\ No newline at end of file
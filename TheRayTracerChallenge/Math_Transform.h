@@ -4,35 +4,52 @@
 #include "Math_Common.h"
 #include "Math_Matrix.h"
 #include "Math_Tuple.h"
+#include <span>
+#include <vector>
 
 namespace Math
 {
 	template<typename T>
 	class Transform : public SquareMatrix<T, 4>
 	{
-	public:
+	private:
+		static void CheckBatchSizes(size_t inputSize, size_t outputSize)
+		{
+			if (inputSize != outputSize)
+				throw std::runtime_error("a transformed batch needs an output as long as its input");
+		}
+
+		static void NormalizeVectors(std::span<Vector4<T>> vectors)
+		{
+			for (Vector4<T>& vector : vectors)
+				vector.Normalize();
+		}
 
-		static Transform Zero()
+		template<typename ExecutionPolicy, typename Function>
+		static void ForEachChunk(ExecutionPolicy&& policy, size_t inputSize, size_t outputSize, Function&& function)
+		{
+			CheckBatchSizes(inputSize, outputSize);
+			ForEachBatchChunk(policy, inputSize, function);
+		}
+
+	public:
+		static constexpr Transform Zero()
 		{
-			Transform<T> zero;
-			zero.SetContents(GetZero<T, 4>());
-			return zero;
+			return Transform<T>(GetZero<T, 4>());
 		}
 
-		static Transform Identity()
+		static constexpr Transform Identity()
 		{
-			Transform<T> identity;
-			identity.SetContents(GetIdentity<T, 4>());
-			return identity;
+			return Transform<T>(GetIdentity<T, 4>());
 		}
 		
         Transform<T> GetTranslation()
         {
             Transform<T> translation = Transform<T>::Identity();
-            translation.SetOriginalValueAt(3, 0, GetValueAt(3, 0));
-            translation.SetOriginalValueAt(3, 1, GetValueAt(3, 1));
-            translation.SetOriginalValueAt(3, 2, GetValueAt(3, 2));
-            translation.SetOriginalValueAt(3, 3, GetValueAt(3, 3));
+            translation.SetOriginalValueAt(3, 0, this->GetValueAt(3, 0));
+            translation.SetOriginalValueAt(3, 1, this->GetValueAt(3, 1));
+            translation.SetOriginalValueAt(3, 2, this->GetValueAt(3, 2));
+            translation.SetOriginalValueAt(3, 3, this->GetValueAt(3, 3));
 
             return translation;
         }
@@ -65,54 +82,241 @@ namespace Math
             {
                 for (size_t j = 0; j < 3; ++j)
                 {
-                    this->SetOriginalValueAt(i, j, t transformOther.GetValueAt(i, j));
+                    this->SetOriginalValueAt(i, j, transformOther.GetValueAt(i, j));
                 }
             }
         }
-		static Transform<T> MakeTranslation(const T x, const T y, const T z);
-		static Transform<T> MakeScaling(const T x, const T y, const T z);
+		/* Translation, scaling and shearing are constexpr, so fixed scene setup can be built at
+		compile time; rotation needs the trigonometric functions, which are not */
+		static constexpr Transform<T> MakeTranslation(const T x, const T y, const T z);
+		static constexpr Transform<T> MakeScaling(const T x, const T y, const T z);
 		static Transform<T> MakeRotation(const T angleX, const T angleY, const T angleZ);
-		static Transform<T> MakeShearing
+		static constexpr Transform<T> MakeShearing
 		(
 			const T xOverY, const T xOverZ,
 			const T yOverX, const T yOverZ,
 			const T zOverX, const T zOverY
 		);
 
-		void operator=(const Transform<T>& other)
+		/* The transposed inverse, which keeps normals perpendicular to transformed surfaces */
+		Transform<T> GetNormalTransform() const
 		{
-			this->contents = other.contents;
-		}		
+			Transform<T> normalTransform(this->GetInverse().GetContents());
+			normalTransform.SetTransposed(true);
+			return normalTransform;
+		}
 
-		Transform() : SquareMatrix()
+		/* Batches, output[i] = input[i] * transform: the matrix stays in registers for the whole batch
+		(MultiplyPoints). The output must be as long as the input and may be the same array. Normals
+		go through the normal transform, computed once per batch, and come out normalized. The overloads
+		taking an execution policy run it in chunks (ForEachBatchChunk). */
+		void TransformPoints(std::span<const Point4<T>> input, std::span<Point4<T>> output) const
 		{
+			CheckBatchSizes(input.size(), output.size());
+			MultiplyPoints(*this, input.data(), output.data(), input.size());
 		}
 
-		Transform(std::array<std::array<T, 4>, 4> contentsNew) : SquareMatrix(contentsNew)
+		void TransformVectors(std::span<const Vector4<T>> input, std::span<Vector4<T>> output) const
+		{
+			CheckBatchSizes(input.size(), output.size());
+			MultiplyVectors(*this, input.data(), output.data(), input.size());
+		}
+
+		void TransformNormals(std::span<const Vector4<T>> input, std::span<Vector4<T>> output) const
+		{
+			GetNormalTransform().TransformVectors(input, output);
+			NormalizeVectors(output);
+		}
+
+		template<typename ExecutionPolicy>
+		void TransformPoints(ExecutionPolicy&& policy, std::span<const Point4<T>> input, std::span<Point4<T>> output) const
+		{
+			ForEachChunk(policy, input.size(), output.size(), [&](size_t start, size_t count)
+			{
+				TransformPoints(input.subspan(start, count), output.subspan(start, count));
+			});
+		}
+
+		template<typename ExecutionPolicy>
+		void TransformVectors(ExecutionPolicy&& policy, std::span<const Vector4<T>> input, std::span<Vector4<T>> output) const
+		{
+			ForEachChunk(policy, input.size(), output.size(), [&](size_t start, size_t count)
+			{
+				TransformVectors(input.subspan(start, count), output.subspan(start, count));
+			});
+		}
+
+		template<typename ExecutionPolicy>
+		void TransformNormals(ExecutionPolicy&& policy, std::span<const Vector4<T>> input, std::span<Vector4<T>> output) const
+		{
+			Transform<T> normalTransform = GetNormalTransform();
+			ForEachChunk(policy, input.size(), output.size(), [&](size_t start, size_t count)
+			{
+				normalTransform.TransformVectors(input.subspan(start, count), output.subspan(start, count));
+				NormalizeVectors(output.subspan(start, count));
+			});
+		}
+
+		constexpr Transform() : SquareMatrix<T, 4>()
+		{
+		}
+
+		constexpr Transform(std::array<std::array<T, 4>, 4> contentsNew) : SquareMatrix<T, 4>(contentsNew)
 		{	
 		}
+	};
+
+#pragma region constexpr builders
+	template<typename T>
+	constexpr Transform<T> Transform<T>::MakeTranslation(const T x, const T y, const T z)
+	{
+		return Transform<T>({ {
+			{ T(1), T(0), T(0), x },
+			{ T(0), T(1), T(0), y },
+			{ T(0), T(0), T(1), z },
+			{ T(0), T(0), T(0), T(1) } } });
+	}
+
+	template<typename T>
+	constexpr Transform<T> Transform<T>::MakeScaling(const T x, const T y, const T z)
+	{
+		return Transform<T>({ {
+			{ x, T(0), T(0), T(0) },
+			{ T(0), y, T(0), T(0) },
+			{ T(0), T(0), z, T(0) },
+			{ T(0), T(0), T(0), T(1) } } });
+	}
+
+	template<typename T>
+	constexpr Transform<T> Transform<T>::MakeShearing(
+		const T xOverY, const T xOverZ,
+		const T yOverX, const T yOverZ,
+		const T zOverX, const T zOverY)
+	{
+		return Transform<T>({ {
+			{ T(1), xOverY, xOverZ, T(0) },
+			{ yOverX, T(1), yOverZ, T(0) },
+			{ zOverX, zOverY, T(1), T(0) },
+			{ T(0), T(0), T(0), T(1) } } });
+	}
+#pragma endregion
+
+	/* A transform together with its inverse, its normal transform (the transposed inverse) and its
+	determinant. They are computed when the transform is set rather than on first use, so reading
+	them is const and safe from the render threads; copies carry them along and every way of
+	changing the transform goes through SetTransform. */
+	template<typename T>
+	class CachedTransform
+	{
+	private:
+		Transform<T> transform;
+		Transform<T> inverse;
+		Transform<T> normalTransform;
+		T determinant;
+
+		void Update()
+		{
+			determinant = transform.GetDeterminant();
+			inverse = Transform<T>(transform.GetInverse().GetContents());
+			UpdateNormalTransform();
+		}
 
-		Transform(const Transform& other) : SquareMatrix(other.contents)
+		void UpdateNormalTransform()
 		{
+			SquareMatrixContents<T, 4> normalContents;
+			for (size_t line = 0; line < 4; ++line)
+				for (size_t column = 0; column < 4; ++column)
+					normalContents[line][column] = inverse.GetValueAt(column, line);
+
+			normalTransform = Transform<T>(normalContents);
 		}
+
+		/* For MakeBatch, which has already inverted the transform */
+		CachedTransform(const Transform<T>& setTransform, const Transform<T>& setInverse, T setDeterminant) :
+			transform(setTransform),
+			inverse(setInverse),
+			determinant(setDeterminant)
+		{
+			UpdateNormalTransform();
+		}
+
+	public:
+		CachedTransform() :
+			transform(Transform<T>::Identity()),
+			inverse(Transform<T>::Identity()),
+			normalTransform(Transform<T>::Identity()),
+			determinant(T(1))
+		{
+		}
+
+		CachedTransform(const Transform<T>& setTransform) : transform(setTransform)
+		{
+			Update();
+		}
+
+		CachedTransform& operator=(const Transform<T>& setTransform)
+		{
+			SetTransform(setTransform);
+			return *this;
+		}
+
+		void SetTransform(const Transform<T>& setTransform)
+		{
+			transform = setTransform;
+			Update();
+		}
+
+		/* Scene load: many transforms inverted in one pass of InvertMatrices4, eight at a time with
+		AVX and split across threads by the execution policy */
+		template<typename ExecutionPolicy>
+		static std::vector<CachedTransform<T>> MakeBatch(ExecutionPolicy&& policy, std::span<const Transform<T>> transforms)
+		{
+			Matrix4Batch<T> matrices(transforms.size());
+			for (size_t index = 0; index < transforms.size(); ++index)
+				matrices.SetMatrix(index, transforms[index]);
+
+			Matrix4Batch<T> inverses;
+			std::vector<T> determinants;
+			InvertMatrices4(policy, matrices, inverses, determinants);
+
+			std::vector<CachedTransform<T>> batch;
+			batch.reserve(transforms.size());
+			for (size_t index = 0; index < transforms.size(); ++index)
+				batch.push_back(CachedTransform<T>(transforms[index], Transform<T>(inverses.GetMatrix(index).GetContents()), determinants[index]));
+
+			return batch;
+		}
+
+		static std::vector<CachedTransform<T>> MakeBatch(std::span<const Transform<T>> transforms)
+		{
+			return MakeBatch(std::execution::seq, transforms);
+		}
+
+		const Transform<T>& GetTransform() const { return transform; }
+
+		/* The identity when the transform is singular, as SquareMatrix::GetInverse */
+		const Transform<T>& GetInverse() const { return inverse; }
+		const Transform<T>& GetNormalTransform() const { return normalTransform; }
+		T GetDeterminant() const { return determinant; }
+		bool IsInvertible() const { return !IsSingularDeterminant(determinant, transform); }
 	};
 
 	
 #pragma region operators
     template<typename T>
-    Transform<T> operator*(Transform<T>& transform1, Transform<T>& transform2)
+    Transform<T> operator*(const Transform<T>& transform1, const Transform<T>& transform2)
     {
-        return GetMultipliedContents(transform1, transform2);
+        return Transform<T>(MultiplyMatrices4<T>(transform1, transform2).GetContents());
     }
 
     template<typename T>
-    Transform<T> operator+(Transform<T>& transform1, Transform<T>& transform2)
+    Transform<T> operator+(const Transform<T>& transform1, const Transform<T>& transform2)
     {
         return GetAddedContents(transform1, transform2);
     }
 
     template<typename T>
-    bool operator== (Math::Transform<T>& transform1, Math::Transform<T>& transform2)
+    bool operator== (const Math::Transform<T>& transform1, const Math::Transform<T>& transform2)
     {
         return CheckEquals(transform1, transform2);
     }
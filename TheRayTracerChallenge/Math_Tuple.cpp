@@ -2,6 +2,15 @@
 #include "Math_Tuple.h"
 #include "Math_Matrix.h"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#define TUPLE_USE_SSE
+#endif
+
+#if defined(__AVX__)
+#define TUPLE_USE_AVX
+#endif
+
 #ifdef _MSC_VER
 #include "CppUnitTest.h"
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -15,90 +24,24 @@ using CI = Math::Helpers::ColorInput;
 
 namespace Math
 {
-
-
-	template<typename T>
-	constexpr M::Tuple4<T> AddTuples(const M::Tuple4<T>& first, const M::Tuple4<T>& second)
-	{
-		return M::Tuple4<T> {
-			H::Get(first, C::X) + H::Get(second, C::X),
-				H::Get(first, C::Y) + H::Get(second, C::Y),
-				H::Get(first, C::Z) + H::Get(second, C::Z),
-				H::Get(first, C::W) + H::Get(second, C::W) };
-	}
-
 	template<typename T>
-	constexpr M::Tuple4<T> SubtractTuples(const M::Tuple4<T>& first, const M::Tuple4<T>& second)
+	M::Tuple4<T> MultiplyTupleByMatrix(const M::Tuple4<T>& tuple, const M::SquareMatrix<T, 4>& matrix)
 	{
-		return M::Tuple4<T> {
-			H::Get(first, C::X) - H::Get(second, C::X),
-				H::Get(first, C::Y) - H::Get(second, C::Y),
-				H::Get(first, C::Z) - H::Get(second, C::Z),
-				H::Get(first, C::W) - H::Get(second, C::W)};
-	}
+		T input[4] = { H::Get(tuple, C::X), H::Get(tuple, C::Y), H::Get(tuple, C::Z), H::Get(tuple, C::W) };
+		T output[4];
+		M::MultiplyMatrix4Vector(matrix, input, output);
 
-	template<typename T>
-	constexpr void MultiplyTupleByScalar(M::Tuple4<T>& tuple, const T scalar)
-	{
-		H::Set(tuple, C::X, H::Get(tuple, C::X) * scalar);
-		H::Set(tuple, C::Y, H::Get(tuple, C::Y) * scalar);
-		H::Set(tuple, C::Z, H::Get(tuple, C::Z) * scalar);
+		return M::Tuple4<T>{ output[0], output[1], output[2], output[3] };
 	}
 
-	template<typename T>
-	constexpr void DivideTupleByScalar(M::Tuple4<T>& tuple, const T scalar)
-	{
-		H::Set(tuple, C::X, H::Get(tuple, C::X) / scalar);
-		H::Set(tuple, C::Y, H::Get(tuple, C::Y) / scalar);
-		H::Set(tuple, C::Z, H::Get(tuple, C::Z) / scalar);
-	}
-
-	template<typename T>
-	constexpr M::Tuple4<T> MultiplyTupleByMatrix(M::Tuple4<T>& tuple, M::SquareMatrix<T, 4>& matrix)
-	{
-		M::Tuple4<T> retVal{ 0.0f, 0.0f, 0.0f, 0.0f };
-
-		static const size_t Size = 4;
-
-
-		for (size_t i = 0; i < Size; ++i)
-		{
-			for (size_t j = 0; j < Size; ++j)
-			{
-				H::Set(retVal, C(i),
-					H::Get(retVal, C(i)) +
-					matrix.GetValueAt(i, j) * H::Get(tuple, C(j)));
-			}
-		}
-
-		return retVal;
-	}
-
-	template<typename T> M::Vector4<T> operator*(const M::Vector4<T>& vector, const T scalar)
-	{
-		M::Vector4<T> retVal = vector;
-		MultiplyTupleByScalar(retVal, scalar);
-		return retVal;
-	}
-
-	template<typename T> M::Color4<T> operator*(const M::Color4<T>& color, const T scalar)
-	{
-		M::Color4<T> retVal = color;
-		MultiplyTupleByScalar(retVal, scalar);
-		return retVal;
-	}
-
-	template<typename T> Math::Color4<T> operator*(const Math::Color4<T>& color1, const Math::Color4<T>& color2)
-	{
-		Color4<T> retVal = color1;
-		retVal.Hadamard(color2);
-		return retVal;
-	}
+	/* the batches hand arrays of tuples to the matrix kernels as arrays of 4 values */
+	static_assert(sizeof(M::Point4<float>) == 4 * sizeof(float) && std::is_standard_layout_v<M::Point4<float>>, "Point4 must be 4 packed values");
+	static_assert(sizeof(M::Vector4<double>) == 4 * sizeof(double) && std::is_standard_layout_v<M::Vector4<double>>, "Vector4 must be 4 packed values");
 
 	template<typename T>
 	Math::Vector4<T> operator*(
 		const Math::Vector4<T>& vector,
-		Math::SquareMatrix<T, 4>& matrix)
+		const Math::SquareMatrix<T, 4>& matrix)
 	{
 		M::Tuple4<T> retValT = MultiplyTupleByMatrix(static_cast<M::Tuple4<T>>(vector), matrix);
 		return H::MakeVector(retValT);
@@ -106,7 +49,7 @@ namespace Math
 
 	template<typename T> 
 	Math::Vector4<T> operator*(
-		Math::SquareMatrix<T, 4>& matrix,
+		const Math::SquareMatrix<T, 4>& matrix,
 		const Math::Vector4<T>& vector)
 	{
 		return vector * matrix;
@@ -115,7 +58,7 @@ namespace Math
 	template<typename T> 
 	Math::Point4<T> operator*(
 		const Math::Point4<T>& point, 
-		Math::SquareMatrix<T, 4>& matrix)
+		const Math::SquareMatrix<T, 4>& matrix)
 	{
 		M::Tuple4<T> retValT = MultiplyTupleByMatrix(static_cast<M::Tuple4<T>>(point), matrix);
 		return H::MakePoint(retValT);
@@ -123,99 +66,145 @@ namespace Math
 
 	template<typename T> 
 	Math::Point4<T> operator*(
-		Math::SquareMatrix<T, 4>& matrix,
+		const Math::SquareMatrix<T, 4>& matrix,
 		const Math::Point4<T>& point)
 	{
 		return point * matrix;
 	}
 
-	template<typename T> M::Vector4<T> operator/(const M::Vector4<T>& vector, const T scalar)
+	template<typename T>
+	void MultiplyPoints(const Math::SquareMatrix<T, 4>& matrix, const Math::Point4<T>* input, Math::Point4<T>* output, size_t count)
 	{
-		M::Vector4<T> retVal = vector;
-		DivideTupleByScalar(retVal, scalar);
-		return retVal;
-	}
+		MultiplyMatrix4Vectors(matrix, reinterpret_cast<const T*>(input), reinterpret_cast<T*>(output), count);
 
-	template<typename T> M::Color4<T> operator/(const M::Color4<T>& color, const T scalar)
-	{
-		M::Color4<T> retVal = color;
-		DivideTupleByScalar(retVal, scalar);
-		return retVal;
+		//as MakePoint does for a single point
+		for (size_t i = 0; i < count; ++i)
+			H::Set(output[i], C::W, T(1));
 	}
 
-	template<typename T> void operator*=(M::Vector4<T>& vector, const T scalar)
+	template<typename T>
+	void MultiplyVectors(const Math::SquareMatrix<T, 4>& matrix, const Math::Vector4<T>* input, Math::Vector4<T>* output, size_t count)
 	{
-		MultiplyTupleByScalar(vector, scalar);
-	}
+		MultiplyMatrix4Vectors(matrix, reinterpret_cast<const T*>(input), reinterpret_cast<T*>(output), count);
 
-	template<typename T> void operator*=(M::Color4<T>& color, const T scalar)
-	{
-		MultiplyTupleByScalar(color, scalar);
+		for (size_t i = 0; i < count; ++i)
+			H::Set(output[i], C::W, T(0));
 	}
 
-	template<typename T> void operator*= (Math::Color4<T>& color, const Math::Color4<T>& colorOther)
+#ifdef TUPLE_USE_SSE
+	/* one Newton step on the estimate: y (3 - x y y) / 2 */
+	inline __m128 RefineReciprocalSqrt(__m128 value, __m128 estimate)
 	{
-		color.Hadamard(colorOther);
+		__m128 product = _mm_mul_ps(_mm_mul_ps(value, estimate), estimate);
+		return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), estimate), _mm_sub_ps(_mm_set1_ps(3.0f), product));
 	}
 
-	template<typename T> void operator/=(M::Vector4<T>& vector, const T scalar)
+	/* 1 / sqrt(value), refined from the estimate where value is a normal float. Below FLT_MIN the
+	estimate is inf and at inf it is 0, which the Newton step turns into inf or NaN, so those lanes
+	take the exact quotient and match GetNormalized. */
+	inline __m128 GetReciprocalSqrt(__m128 value)
 	{
-		DivideTupleByScalar(vector, scalar);
-	}
+		__m128 refined = RefineReciprocalSqrt(value, _mm_rsqrt_ps(value));
+		__m128 outside = _mm_or_ps(
+			_mm_cmplt_ps(value, _mm_set1_ps(std::numeric_limits<float>::min())),
+			_mm_cmpgt_ps(value, _mm_set1_ps(std::numeric_limits<float>::max())));
 
-	template<typename T> void operator/=(M::Color4<T>& color, const T scalar)
-	{
-		DivideTupleByScalar(color, scalar);
-	}
+		if (_mm_movemask_ps(outside) == 0)
+			return refined;
 
-	template<typename T> M::Point4<T>  operator+ (const M::Point4<T>& first, const M::Vector4<T>& second)
-	{
-		return H::MakePoint(AddTuples(first, second));
+		__m128 exact = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(value));
+		return _mm_or_ps(_mm_and_ps(outside, exact), _mm_andnot_ps(outside, refined));
 	}
+#endif
 
-	template<typename T> M::Vector4<T> operator+ (const M::Vector4<T>& first, const M::Vector4<T>& second)
+#ifdef TUPLE_USE_AVX
+	inline __m256 RefineReciprocalSqrt(__m256 value, __m256 estimate)
 	{
-		return H::MakeVector(AddTuples(first, second));
+		__m256 product = _mm256_mul_ps(_mm256_mul_ps(value, estimate), estimate);
+		return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), estimate), _mm256_sub_ps(_mm256_set1_ps(3.0f), product));
 	}
 
-	template<typename T> Math::Color4<T> operator+ (const Math::Color4<T>& first, const Math::Color4<T>& second)
+	inline __m256 GetReciprocalSqrt(__m256 value)
 	{
-		return H::MakeColor(AddTuples(first, second));
-	}
+		__m256 refined = RefineReciprocalSqrt(value, _mm256_rsqrt_ps(value));
+		__m256 outside = _mm256_or_ps(
+			_mm256_cmp_ps(value, _mm256_set1_ps(std::numeric_limits<float>::min()), _CMP_LT_OQ),
+			_mm256_cmp_ps(value, _mm256_set1_ps(std::numeric_limits<float>::max()), _CMP_GT_OQ));
 
-	template<typename T> M::Point4<T>  operator- (const M::Point4<T>& first, const M::Vector4<T>& second)
-	{
-		return H::MakePoint(SubtractTuples(first, second));
-	}
+		if (_mm256_movemask_ps(outside) == 0)
+			return refined;
 
-	template<typename T> M::Vector4<T> operator- (const M::Point4<T>& first, const M::Point4<T>& second)
-	{
-		return H::MakeVector(SubtractTuples(first, second));
+		return _mm256_blendv_ps(refined, _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(value)), outside);
 	}
+#endif
 
-	template<typename T> M::Vector4<T> operator- (const M::Vector4<T>& first, const M::Vector4<T>& second)
+	template<typename T>
+	void NormalizeVectorsFast(Math::Vector4<T>* vectors, size_t count)
 	{
-		return H::MakeVector(SubtractTuples(first, second));
-	}
+		size_t i = 0;
 
-	template<typename T> Math::Color4<T> operator- (const Math::Color4<T>& first, const Math::Color4<T>& second)
-	{
-		return H::MakeColor(SubtractTuples(first, second));
+#ifdef TUPLE_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			float* values = reinterpret_cast<float*>(vectors);
+
+#ifdef TUPLE_USE_AVX
+			//two vectors per register: the even ones in the low halves, the odd ones in the high halves
+			for (; i + 8 <= count; i += 8)
+			{
+				__m256 pairs[4];
+				for (size_t pair = 0; pair < 4; ++pair)
+					pairs[pair] = _mm256_loadu_ps(values + (i + 2 * pair) * 4);
+
+				__m256 low01 = _mm256_unpacklo_ps(pairs[0], pairs[1]);
+				__m256 high01 = _mm256_unpackhi_ps(pairs[0], pairs[1]);
+				__m256 low23 = _mm256_unpacklo_ps(pairs[2], pairs[3]);
+				__m256 high23 = _mm256_unpackhi_ps(pairs[2], pairs[3]);
+				__m256 xs = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(1, 0, 1, 0));
+				__m256 ys = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(3, 2, 3, 2));
+				__m256 zs = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(1, 0, 1, 0));
+
+				__m256 magnitudesSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(xs, xs), _mm256_mul_ps(ys, ys)), _mm256_mul_ps(zs, zs));
+				__m256 scales = GetReciprocalSqrt(magnitudesSquared);
+
+				_mm256_storeu_ps(values + i * 4, _mm256_mul_ps(pairs[0], _mm256_permute_ps(scales, _MM_SHUFFLE(0, 0, 0, 0))));
+				_mm256_storeu_ps(values + (i + 2) * 4, _mm256_mul_ps(pairs[1], _mm256_permute_ps(scales, _MM_SHUFFLE(1, 1, 1, 1))));
+				_mm256_storeu_ps(values + (i + 4) * 4, _mm256_mul_ps(pairs[2], _mm256_permute_ps(scales, _MM_SHUFFLE(2, 2, 2, 2))));
+				_mm256_storeu_ps(values + (i + 6) * 4, _mm256_mul_ps(pairs[3], _mm256_permute_ps(scales, _MM_SHUFFLE(3, 3, 3, 3))));
+			}
+#endif
+
+			//transposed, so that four magnitudes come out of one register; w is 0 and stays 0
+			for (; i + 4 <= count; i += 4)
+			{
+				__m128 rows[4];
+				for (size_t row = 0; row < 4; ++row)
+					rows[row] = _mm_loadu_ps(values + (i + row) * 4);
+
+				__m128 xs = rows[0], ys = rows[1], zs = rows[2], ws = rows[3];
+				_MM_TRANSPOSE4_PS(xs, ys, zs, ws);
+
+				__m128 magnitudesSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xs, xs), _mm_mul_ps(ys, ys)), _mm_mul_ps(zs, zs));
+				__m128 scales = GetReciprocalSqrt(magnitudesSquared);
+
+				_mm_storeu_ps(values + i * 4, _mm_mul_ps(rows[0], _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(0, 0, 0, 0))));
+				_mm_storeu_ps(values + (i + 1) * 4, _mm_mul_ps(rows[1], _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(1, 1, 1, 1))));
+				_mm_storeu_ps(values + (i + 2) * 4, _mm_mul_ps(rows[2], _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(2, 2, 2, 2))));
+				_mm_storeu_ps(values + (i + 3) * 4, _mm_mul_ps(rows[3], _mm_shuffle_ps(scales, scales, _MM_SHUFFLE(3, 3, 3, 3))));
+			}
+		}
+#endif
+
+		for (; i < count; ++i)
+			vectors[i].NormalizeFast();
 	}
+
 }
 
 namespace Math
 {
 
 #pragma region Tuple
-	template<typename T> Tuple4<T>::Tuple4(T x, T y, T z, T w)
-	{
-		this->x = x;
-		this->y = y;
-		this->z = z;
-		this->w = w;
-	}
-
 	template<typename T> Tuple4<T> Tuple4<T>::GetNegated()
 	{
 		return Tuple4{ x * (T)-1.0, y * (T)-1.0, z * (T)-1.0f, w };
@@ -228,52 +217,9 @@ namespace Math
 		this->z *= -1.0;
 	}
 
-	template<typename T> Point4<T> Helpers::MakePoint(const T& x, const T& y, const T& z)
-	{
-		return Point4<T>{ x, y, z, T(1) };
-	}
-
-	template<typename T> Vector4<T> Helpers::MakeVector(const T& x, const T& y, const T& z)
-	{
-		return Vector4<T>{ x, y, z, T(0) };
-	}
-
-	template<typename T> Color4<T> Helpers::MakeColor(const T& r, const T& g, const T& b, const T& a)
-	{
-		return Color4<T>{ r, g, b, a };
-	}
-
-	template<typename T> Color4<T> Helpers::MakeColor(const T& r, const T& g, const T& b)
-	{
-		return Color4<T>{ r, g, b, T(0.5)};
-	}
-
-	template<typename T> Point4<T> Helpers::MakePoint(const Tuple4<T>& tuple)
-	{
-		return Point4<T>(tuple);
-	}
-
-	template<typename T> Vector4<T> Helpers::MakeVector(const Tuple4<T>& tuple)
-	{
-		return Vector4<T>(tuple);
-	}
-
-	template<typename T> Color4<T> Helpers::MakeColor(const Tuple4<T>& tuple)
-	{
-		return Color4<T>(tuple);
-	}
-#pragma endregion
-
-#pragma region Point
-	template<typename T>
-	Math::Point4<T>::Point4(T x, T y, T z) : Tuple4{ x,y,z,T(1) } {}
-
 #pragma endregion
 
 #pragma region Vector
-	template<typename T>
-	Math::Vector4<T>::Vector4(T x, T y, T z) : Tuple4{ x,y,z, T(0) } {}
-
 	template<typename T> Vector4<T> Vector4<T>::GetNormalized() const
 	{
 		auto retVal = *this;
@@ -286,46 +232,52 @@ namespace Math
 		*this /= GetMagnitude();
 	}
 
-	template<typename T> constexpr T Vector4<T>::GetMagnitudeSquared() const
+	template<typename T> Vector4<T> Vector4<T>::GetNormalizedFast() const
 	{
-		return x * x + y * y + z * z;
-	}
-
-	template<typename T> constexpr T Vector4<T>::GetMagnitude() const
-	{
-		return std::sqrt(GetMagnitudeSquared());
+		auto retVal = *this;
+		retVal.NormalizeFast();
+		return retVal;
 	}
 
-	template<typename T> constexpr T Vector4<T>::Dot(const Vector4<T>& other) const
+	template<typename T> void Vector4<T>::NormalizeFast()
 	{
-		return this->x * other.x + this->y * other.y + this->z * other.z;
+#ifdef TUPLE_USE_SSE
+		if constexpr (std::is_same_v<T, float>)
+		{
+			//the whole tuple stays in one register; w is 0 and adds nothing to the sum
+			float* values = reinterpret_cast<float*>(this);
+			__m128 vector = _mm_loadu_ps(values);
+			__m128 squares = _mm_mul_ps(vector, vector);
+			__m128 sums = _mm_add_ps(squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(2, 3, 0, 1)));
+			__m128 magnitudesSquared = _mm_add_ps(sums, _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2)));
+			_mm_storeu_ps(values, _mm_mul_ps(vector, GetReciprocalSqrt(magnitudesSquared)));
+			return;
+		}
+#endif
+		*this *= T(1) / GetMagnitude();
 	}
 
-	template<typename T> constexpr Vector4<T> Vector4<T>::Cross(const Vector4<T>& other) const
-	{
-		return Helpers::MakeVector(
-			this->y * other.z - this->z * other.y,
-			this->z * other.x - this->x * other.z,
-			this->x * other.y - this->y * other.x);
-	}
 #pragma endregion
 
-#pragma region Color
-
-	template<typename T>
-	Math::Color4<T>::Color4(T r, T g, T b, T a) : Tuple4{ r, g, b, a } {};
-
-	template<typename T> constexpr void Math::Color4<T>::Hadamard(const Color4<T>& other)
-	{
-		this->x *= H::Get(other, CI::R);
-		this->y *= H::Get(other, CI::G);
-		this->z *= H::Get(other, CI::B);
-		this->w *= H::Get(other, CI::A);
-	}
-
-
+#pragma region explicit instantiations
+#define MATH_INSTANTIATE_TUPLES(T) \
+	template class Tuple4<T>; \
+	template class Point4<T>; \
+	template class Vector4<T>; \
+	template class Color4<T>; \
+	template Vector4<T> operator*(const Vector4<T>&, const SquareMatrix<T, 4>&); \
+	template Vector4<T> operator*(const SquareMatrix<T, 4>&, const Vector4<T>&); \
+	template Point4<T> operator*(const Point4<T>&, const SquareMatrix<T, 4>&); \
+	template Point4<T> operator*(const SquareMatrix<T, 4>&, const Point4<T>&); \
+	template void MultiplyPoints(const SquareMatrix<T, 4>&, const Point4<T>*, Point4<T>*, size_t); \
+	template void MultiplyVectors(const SquareMatrix<T, 4>&, const Vector4<T>*, Vector4<T>*, size_t); \
+	template void NormalizeVectorsFast(Vector4<T>*, size_t);
+
+	MATH_INSTANTIATE_TUPLES(float)
+	MATH_INSTANTIATE_TUPLES(double)
+
+#undef MATH_INSTANTIATE_TUPLES
 #pragma endregion
-
 }
 
 #pragma region Math Tests
@@ -674,6 +626,96 @@ namespace Math
 
 			Assert::IsTrue(expectedResult == multiplicationResult);
 		}
+
+		TEST_METHOD(BatchByMatrixMultiplication)
+		{
+			auto matrix = SquareMatrix<float, 4>({
+				1.0f, 2.0f, 3.0f, 4.0f,
+				5.0f, 6.0f, 7.0f, 8.0f,
+				9.0f, 10.0f, 11.0f, 12.0f,
+				0.0f, 0.0f, 0.0f, 1.0f });
+
+			//an odd count, so the wide path and its remainder both run
+			std::vector<Point4f> points;
+			std::vector<Vector4f> vectors;
+			for (size_t i = 0; i < 5; ++i)
+			{
+				points.push_back(H::MakePoint(float(i), 1.0f - float(i), 0.5f * float(i)));
+				vectors.push_back(H::MakeVector(0.5f, float(i), -float(i)));
+			}
+
+			for (bool transposed : { false, true })
+			{
+				matrix.SetTransposed(transposed);
+
+				std::vector<Point4f> transformedPoints(points.size());
+				MultiplyPoints(matrix, points.data(), transformedPoints.data(), points.size());
+
+				std::vector<Vector4f> transformedVectors = vectors;
+				MultiplyVectors(matrix, transformedVectors.data(), transformedVectors.data(), vectors.size());
+
+				for (size_t i = 0; i < points.size(); ++i)
+				{
+					Assert::IsTrue(transformedPoints[i] == points[i] * matrix);
+					Assert::IsTrue(transformedVectors[i] == vectors[i] * matrix);
+				}
+			}
+		}
+
+		TEST_METHOD(VectorNormalizeFast)
+		{
+			//29 vectors: every scale goes through the eight or four wide path, and the scalar path runs.
+			//The scales reach past FLT_MIN and FLT_MAX of the squared magnitude, where the estimate gives out
+			const float scales[] = { 1e-3f, 1e-2f, 1e-1f, 1.0f, 1e1f, 1e2f, 1e3f, 1e-18f, 1e-19f, 1e-20f, 1e-22f, 1e18f, 1e20f };
+			std::vector<Vector4f> vectors;
+			for (size_t i = 0; i < 29; ++i)
+			{
+				float scale = scales[i % std::size(scales)];
+				vectors.push_back(H::MakeVector(scale * (float(i) - 6.0f), scale * (1.0f + 0.25f * float(i)), -scale * float(i % 3)));
+			}
+
+			std::vector<Vector4f> normalized = vectors;
+			NormalizeVectorsFast(normalized.data(), normalized.size());
+
+			float largestError = 0.0f;
+			for (size_t i = 0; i < vectors.size(); ++i)
+			{
+				auto expected = vectors[i].GetNormalized();
+				auto single = vectors[i].GetNormalizedFast();
+				for (C coordinate : { C::X, C::Y, C::Z })
+				{
+					Assert::IsTrue(std::isfinite(H::Get(normalized[i], coordinate)) && std::isfinite(H::Get(single, coordinate)));
+					largestError = std::max(largestError, std::abs(H::Get(normalized[i], coordinate) - H::Get(expected, coordinate)));
+					largestError = std::max(largestError, std::abs(H::Get(single, coordinate) - H::Get(expected, coordinate)));
+				}
+
+				Assert::IsTrue(H::Get(normalized[i], C::W) == 0.0f);
+			}
+
+			Assert::IsTrue(largestError < FastNormalizeRelativeError<float>);
+
+			auto vector = H::MakeVector(3.0, 4.0, 12.0);
+			vector.NormalizeFast();
+			Assert::IsTrue(vector == H::MakeVector(3.0 / 13.0, 4.0 / 13.0, 12.0 / 13.0));
+		}
+
+		TEST_METHOD(FusedMultiplyAdd)
+		{
+			auto point = H::MakePoint(1.0f, 2.0f, 3.0f);
+			auto vector = H::MakeVector(0.5f, -1.0f, 2.0f);
+			Assert::IsTrue(MultiplyAdd(point, vector, 2.0f) == point + vector * 2.0f);
+			Assert::IsTrue(MultiplyAdd(vector, vector, -1.0f) == H::MakeVector(0.0f, 0.0f, 0.0f));
+
+			//light adds up, the alpha of the accumulated colour is kept
+			auto color = H::MakeColor(0.1f, 0.2f, 0.3f, 0.5f);
+			auto light = H::MakeColor(1.0f, 0.5f, 0.25f, 1.0f);
+			Assert::IsTrue(MultiplyAdd(color, light, 0.5f) == H::MakeColor(0.6f, 0.45f, 0.425f, 0.5f));
+			Assert::IsTrue(MultiplyColors(color, light, 2.0f) == H::MakeColor(0.2f, 0.2f, 0.15f, 0.5f));
+
+			constexpr auto position = MultiplyAdd(H::MakePoint(0.0, 0.0, 0.0), H::MakeVector(1.0, 2.0, 3.0), 2.0);
+			static_assert(H::Get(position, C::Z) == 6.0 && H::Get(position, C::W) == 1.0);
+			static_assert(H::Get(H::MakeVector(1.0, 2.0, 3.0) * 2.0 - H::MakeVector(2.0, 4.0, 6.0), C::Y) == 0.0);
+		}
 	};
 }
 
@@ -18,7 +18,7 @@ namespace
 	void ASSERT(bool condition, std::string message = DEFAULT_ASSERT_MESSAGE)
 	{
 		if (!condition)
-			throw std::exception(ConstructAssertMessage(message).c_str());
+			throw std::runtime_error(ConstructAssertMessage(message));
 	}
 }
 
@@ -44,32 +44,26 @@ namespace Math
 		};
 	private:
 		template <typename T>
-		struct HasValidInput { constexpr static bool value = false; };
-
-		template <>
-		struct HasValidInput<ColorInput> { constexpr static bool value = true; };
-
-		template <>
-		struct HasValidInput<Coordinate> { constexpr static bool value = true; };
+		struct HasValidInput { constexpr static bool value = std::is_same_v<T, ColorInput> || std::is_same_v<T, Coordinate>; };
 
 	public:
 
 		template<typename N, template<typename> typename U, typename T>
-		static auto Get(const U<T>& tupleInput, const N value)
+		static constexpr auto Get(const U<T>& tupleInput, const N value)
 			->std::enable_if_t<HasValidInput<N>::value, T>
 		{
 			switch (value)
 			{
-			case 0:
+			case N(0):
 				return tupleInput.x;
 
-			case 1:
+			case N(1):
 				return tupleInput.y;
 
-			case 2:
+			case N(2):
 				return tupleInput.z;
 
-			case 3:
+			case N(3):
 				return tupleInput.w;
 
 			default:
@@ -78,24 +72,24 @@ namespace Math
 		}
 
 		template<typename N, template<typename> typename U, typename T>
-		static auto Set(U<T>& tupleInput, const N member, const T value)
+		static constexpr auto Set(U<T>& tupleInput, const N member, const T value)
 			->std::enable_if_t<HasValidInput<N>::value, void>
 		{
 			switch (member)
 			{
-			case 0:
+			case N(0):
 				tupleInput.x = value;
 				break;
 
-			case 1:
+			case N(1):
 				tupleInput.y = value;
 				break;
 
-			case 2:
+			case N(2):
 				tupleInput.z = value;
 				break;
 
-			case 3:
+			case N(3):
 				tupleInput.w = value;
 
 			default:
@@ -103,44 +97,66 @@ namespace Math
 			}
 		}
 		
-		template<typename T> static Point4<T> MakePoint(const T& x, const T& y, const T& z);
-		template<typename T> static Vector4<T> MakeVector(const T& x, const T& y, const T& z);
-		template<typename T> static Color4<T> MakeColor(const T& r, const T& g, const T& b, const T& a);
-		template<typename T> static Color4<T> MakeColor(const T& r, const T& g, const T& b);
-
-		template<typename T> static Point4<T> MakePoint(const Tuple4<T>& tuple);
-		template<typename T> static Vector4<T> MakeVector(const Tuple4<T>& tuple);
-		template<typename T> static Color4<T> MakeColor(const Tuple4<T>& tuple);
+		/* constexpr, so tuples can be scene constants evaluated at compile time */
+		template<typename T> static constexpr Point4<T> MakePoint(const T& x, const T& y, const T& z);
+		template<typename T> static constexpr Vector4<T> MakeVector(const T& x, const T& y, const T& z);
+		template<typename T> static constexpr Color4<T> MakeColor(const T& r, const T& g, const T& b, const T& a);
+		template<typename T> static constexpr Color4<T> MakeColor(const T& r, const T& g, const T& b);
+
+		template<typename T> static constexpr Point4<T> MakePoint(const Tuple4<T>& tuple);
+		template<typename T> static constexpr Vector4<T> MakeVector(const Tuple4<T>& tuple);
+		template<typename T> static constexpr Color4<T> MakeColor(const Tuple4<T>& tuple);
 	};
 
-	template<typename T> Math::Vector4<T>	operator*(const Math::Vector4<T>& vector, const T scalar);
-	template<typename T> Math::Color4<T>	operator*(const Math::Color4<T>& color, const T scalar);
-	template<typename T> Math::Color4<T>	operator*(const Math::Color4<T>& color1, const Math::Color4<T>& color2);
+	template<typename T> constexpr Math::Vector4<T>	operator*(const Math::Vector4<T>& vector, const T scalar);
+	template<typename T> constexpr Math::Color4<T>	operator*(const Math::Color4<T>& color, const T scalar);
+	template<typename T> constexpr Math::Color4<T>	operator*(const Math::Color4<T>& color1, const Math::Color4<T>& color2);
 	
-	template<typename T> Math::Vector4<T>	operator*(const Math::Vector4<T>& vector, Math::SquareMatrix<T, 4>& matrix);
-	template<typename T> Math::Vector4<T>	operator*(Math::SquareMatrix<T, 4>& matrix, const Math::Vector4<T>& vector);
+	template<typename T> Math::Vector4<T>	operator*(const Math::Vector4<T>& vector, const Math::SquareMatrix<T, 4>& matrix);
+	template<typename T> Math::Vector4<T>	operator*(const Math::SquareMatrix<T, 4>& matrix, const Math::Vector4<T>& vector);
 	
-	template<typename T> Math::Point4<T>	operator*(const Math::Point4<T>& point, Math::SquareMatrix<T, 4>& matrix);
-	template<typename T> Math::Point4<T>	operator*(Math::SquareMatrix<T, 4>& matrix, const Math::Point4<T>& point);
+	template<typename T> Math::Point4<T>	operator*(const Math::Point4<T>& point, const Math::SquareMatrix<T, 4>& matrix);
+	template<typename T> Math::Point4<T>	operator*(const Math::SquareMatrix<T, 4>& matrix, const Math::Point4<T>& point);
+
+	/* output[i] = input[i] * matrix for whole arrays, with the matrix loaded once; output may be input */
+	template<typename T> void				MultiplyPoints(const Math::SquareMatrix<T, 4>& matrix, const Math::Point4<T>* input, Math::Point4<T>* output, size_t count);
+	template<typename T> void				MultiplyVectors(const Math::SquareMatrix<T, 4>& matrix, const Math::Vector4<T>* input, Math::Vector4<T>* output, size_t count);
+
+	/* Vector4::NormalizeFast over a whole array, four vectors per step (eight with AVX) */
+	template<typename T> void				NormalizeVectorsFast(Math::Vector4<T>* vectors, size_t count);
+
+	/* Bound on |NormalizeFast - Normalize| per component of a unit result: the estimate is within
+	1.5 * 2^-12, one Newton step squares that to about 2^-22, plus the rounding of the step itself */
+	template<typename T> constexpr T		FastNormalizeRelativeError = std::is_same_v<T, float> ? T(5e-7) : T(1e-15);
+
+	template<typename T> constexpr void				operator*= (Math::Vector4<T>& vector, const T scalar);
+	template<typename T> constexpr void				operator*= (Math::Color4<T>& color, const T scalar);
+	template<typename T> constexpr void				operator*= (Math::Color4<T>& color, const Math::Color4<T>& colorOther);
 
-	template<typename T> void				operator*= (Math::Vector4<T>& vector, const T scalar);
-	template<typename T> void				operator*= (Math::Color4<T>& color, const T scalar);
-	template<typename T> void				operator*= (Math::Color4<T>& color, const Math::Color4<T>& colorOther);
+	template<typename T> constexpr Math::Vector4<T>	operator/(const Math::Vector4<T>& vector, const T scalar);
+	template<typename T> constexpr Math::Color4<T>	operator/(const Math::Color4<T>& color, const T scalar);
 
-	template<typename T> Math::Vector4<T>	operator/(const Math::Vector4<T>& vector, const T scalar);
-	template<typename T> Math::Color4<T>	operator/(const Math::Color4<T>& color, const T scalar);
+	template<typename T> constexpr void				operator/= (Math::Vector4<T>& vector, const T scalar);
+	template<typename T> constexpr void				operator/= (Math::Color4<T>& color, const T scalar);
 
-	template<typename T> void				operator/= (Math::Vector4<T>& vector, const T scalar);
-	template<typename T> void				operator/= (Math::Color4<T>& color, const T scalar);
+	template<typename T> constexpr Math::Point4<T>	operator+ (const Math::Point4<T>& first, const Math::Vector4<T>& second);
+	template<typename T> constexpr Math::Vector4<T>	operator+ (const Math::Vector4<T>& first, const Math::Vector4<T>& second);
+	template<typename T> constexpr Math::Color4<T>	operator+ (const Math::Color4<T>& first, const Math::Color4<T>& second);
 
-	template<typename T> Math::Point4<T>	operator+ (const Math::Point4<T>& first, const Math::Vector4<T>& second);
-	template<typename T> Math::Vector4<T>	operator+ (const Math::Vector4<T>& first, const Math::Vector4<T>& second);
-	template<typename T> Math::Color4<T>	operator+ (const Math::Color4<T>& first, const Math::Color4<T>& second);
+	template<typename T> constexpr Math::Point4<T>	operator- (const Math::Point4<T>& first, const Math::Vector4<T>& second);
+	template<typename T> constexpr Math::Vector4<T>	operator- (const Math::Point4<T>& first, const Math::Point4<T>& second);
+	template<typename T> constexpr Math::Vector4<T>	operator- (const Math::Vector4<T>& first, const Math::Vector4<T>& second);
+	template<typename T> constexpr Math::Color4<T>	operator- (const Math::Color4<T>& first, const Math::Color4<T>& second);
 
-	template<typename T> Math::Point4<T>	operator- (const Math::Point4<T>& first, const Math::Vector4<T>& second);
-	template<typename T> Math::Vector4<T>	operator- (const Math::Point4<T>& first, const Math::Point4<T>& second);
-	template<typename T> Math::Vector4<T>	operator- (const Math::Vector4<T>& first, const Math::Vector4<T>& second);
-	template<typename T> Math::Color4<T>	operator- (const Math::Color4<T>& first, const Math::Color4<T>& second);
+	/* Fused forms of the chains that shading and ray stepping are made of: one pass over the components
+	and no intermediate tuple, whatever the optimiser makes of the operator chains. A colour
+	accumulation keeps the alpha of the accumulated colour: light adds up, coverage does not. */
+	template<typename T> constexpr Math::Point4<T>	MultiplyAdd(const Math::Point4<T>& point, const Math::Vector4<T>& vector, const T scale);
+	template<typename T> constexpr Math::Vector4<T>	MultiplyAdd(const Math::Vector4<T>& accumulated, const Math::Vector4<T>& vector, const T scale);
+	template<typename T> constexpr Math::Color4<T>	MultiplyAdd(const Math::Color4<T>& accumulated, const Math::Color4<T>& color, const T scale);
+
+	/* first * second * scale, with the alpha of first * second */
+	template<typename T> constexpr Math::Color4<T>	MultiplyColors(const Math::Color4<T>& first, const Math::Color4<T>& second, const T scale);
 	
 	/* Y is up, Z points away from the camera */
 	template<typename T>
@@ -154,7 +170,7 @@ namespace Math
 		T x, y, z, w;
 
 	public:
-		Tuple4(T x, T y, T z, T w);
+		constexpr Tuple4(T setX, T setY, T setZ, T setW) : x{ setX }, y{ setY }, z{ setZ }, w{ setW } { }
 		Tuple4          GetNegated();
 		void            Negate();
 	};
@@ -164,15 +180,15 @@ namespace Math
 	{
 	private:
 		friend class Helpers;
-		using Tuple4::Tuple4;
+		using Tuple4<T>::Tuple4;
 
-		Point4(T x, T y, T z);
-		Point4(const Tuple4<T>& input) : Point4{
+		constexpr Point4(T x, T y, T z) : Tuple4<T>{ x, y, z, T(1) } { }
+		constexpr Point4(const Tuple4<T>& input) : Point4{
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::X),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Y),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Z) } { }
 	public:
-		Point4() : Point4(T{ 0 }, T{ 0 }, T{ 0 }) {};
+		constexpr Point4() : Point4(T{ 0 }, T{ 0 }, T{ 0 }) {};
 	};
 
 	template<typename T>
@@ -180,10 +196,10 @@ namespace Math
 	{
 	private:
 		friend class Helpers;
-		using Tuple4::Tuple4;
+		using Tuple4<T>::Tuple4;
 
-		Vector4(T x, T y, T z);
-		Vector4(const Tuple4<T>& input) : Vector4{
+		constexpr Vector4(T x, T y, T z) : Tuple4<T>{ x, y, z, T(0) } { }
+		constexpr Vector4(const Tuple4<T>& input) : Vector4{
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::X),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Y),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Z) } { }
@@ -196,8 +212,16 @@ namespace Math
 		Vector4         GetNormalized() const;
 		void            Normalize();
 
+		/* Opt-in fast forms for float: the hardware reciprocal square root estimate refined by one
+		Newton step, within FastNormalizeRelativeError of GetNormalized per component. double has no
+		hardware estimate and multiplies by one reciprocal instead of dividing three times. Squared
+		magnitudes outside the normal floats, below FLT_MIN or overflowing, take the exact reciprocal
+		instead, so the bound holds there too. As with Normalize, a zero vector gives NaN. */
+		Vector4         GetNormalizedFast() const;
+		void            NormalizeFast();
+
 	public:
-		Vector4() : Vector4(T{ 0 }, T{ 0 }, T{ 0 }) {};
+		constexpr Vector4() : Vector4(T{ 0 }, T{ 0 }, T{ 0 }) {};
 	};
 
 	template<typename T>
@@ -205,17 +229,17 @@ namespace Math
 	{
 	private:
 		friend class Helpers;
-		using Tuple4::Tuple4;
+		using Tuple4<T>::Tuple4;
 
-		Color4(T r, T g, T b, T a);
-		Color4(const Tuple4<T>& input) : Color4{
+		constexpr Color4(T r, T g, T b, T a) : Tuple4<T>{ r, g, b, a } { }
+		constexpr Color4(const Tuple4<T>& input) : Color4{
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::X),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Y),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::Z),
 			Math::Helpers::Get(input, Math::Helpers::Coordinate::W) } { }
 
 	public:
-		Color4() : Color4(T{ 0 }, T{ 0 }, T{ 0 }, T{ 0.5 }) {};
+		constexpr Color4() : Color4(T{ 0 }, T{ 0 }, T{ 0 }, T{ 0.5 }) {};
 		inline constexpr void Hadamard(const Color4<T>& other); /*Color * Color multiplication*/
 	};
 	
@@ -223,5 +247,213 @@ namespace Math
 	using Vector4f = Math::Vector4<float>;
 	using Tuple4f = Math::Tuple4<float>;
 
+#pragma region inline members
+	template<typename T> constexpr Point4<T> Helpers::MakePoint(const T& x, const T& y, const T& z)
+	{
+		return Point4<T>{ x, y, z, T(1) };
+	}
+
+	template<typename T> constexpr Vector4<T> Helpers::MakeVector(const T& x, const T& y, const T& z)
+	{
+		return Vector4<T>{ x, y, z, T(0) };
+	}
+
+	template<typename T> constexpr Color4<T> Helpers::MakeColor(const T& r, const T& g, const T& b, const T& a)
+	{
+		return Color4<T>{ r, g, b, a };
+	}
+
+	template<typename T> constexpr Color4<T> Helpers::MakeColor(const T& r, const T& g, const T& b)
+	{
+		return Color4<T>{ r, g, b, T(0.5) };
+	}
+
+	template<typename T> constexpr Point4<T> Helpers::MakePoint(const Tuple4<T>& tuple)
+	{
+		return Point4<T>(tuple);
+	}
+
+	template<typename T> constexpr Vector4<T> Helpers::MakeVector(const Tuple4<T>& tuple)
+	{
+		return Vector4<T>(tuple);
+	}
+
+	template<typename T> constexpr Color4<T> Helpers::MakeColor(const Tuple4<T>& tuple)
+	{
+		return Color4<T>(tuple);
+	}
+
+	template<typename T> constexpr T Vector4<T>::GetMagnitudeSquared() const
+	{
+		return this->x * this->x + this->y * this->y + this->z * this->z;
+	}
+
+	template<typename T> constexpr T Vector4<T>::GetMagnitude() const
+	{
+		return std::sqrt(GetMagnitudeSquared());
+	}
+
+	template<typename T> constexpr T Vector4<T>::Dot(const Vector4<T>& other) const
+	{
+		return this->x * other.x + this->y * other.y + this->z * other.z;
+	}
+
+	template<typename T> constexpr Vector4<T> Vector4<T>::Cross(const Vector4<T>& other) const
+	{
+		return Helpers::MakeVector(
+			this->y * other.z - this->z * other.y,
+			this->z * other.x - this->x * other.z,
+			this->x * other.y - this->y * other.x);
+	}
+
+	template<typename T> constexpr void Color4<T>::Hadamard(const Color4<T>& other)
+	{
+		this->x *= Helpers::Get(other, Helpers::ColorInput::R);
+		this->y *= Helpers::Get(other, Helpers::ColorInput::G);
+		this->z *= Helpers::Get(other, Helpers::ColorInput::B);
+		this->w *= Helpers::Get(other, Helpers::ColorInput::A);
+	}
+#pragma endregion
+
+#pragma region inline operators
+	template<typename T> constexpr Vector4<T> operator*(const Vector4<T>& vector, const T scalar)
+	{
+		return Helpers::MakeVector(
+			Helpers::Get(vector, Helpers::Coordinate::X) * scalar,
+			Helpers::Get(vector, Helpers::Coordinate::Y) * scalar,
+			Helpers::Get(vector, Helpers::Coordinate::Z) * scalar);
+	}
+
+	template<typename T> constexpr Color4<T> operator*(const Color4<T>& color, const T scalar)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(color, Helpers::ColorInput::R) * scalar,
+			Helpers::Get(color, Helpers::ColorInput::G) * scalar,
+			Helpers::Get(color, Helpers::ColorInput::B) * scalar,
+			Helpers::Get(color, Helpers::ColorInput::A));
+	}
+
+	template<typename T> constexpr Color4<T> operator*(const Color4<T>& color1, const Color4<T>& color2)
+	{
+		Color4<T> retVal = color1;
+		retVal.Hadamard(color2);
+		return retVal;
+	}
+
+	template<typename T> constexpr Vector4<T> operator/(const Vector4<T>& vector, const T scalar)
+	{
+		return Helpers::MakeVector(
+			Helpers::Get(vector, Helpers::Coordinate::X) / scalar,
+			Helpers::Get(vector, Helpers::Coordinate::Y) / scalar,
+			Helpers::Get(vector, Helpers::Coordinate::Z) / scalar);
+	}
+
+	template<typename T> constexpr Color4<T> operator/(const Color4<T>& color, const T scalar)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(color, Helpers::ColorInput::R) / scalar,
+			Helpers::Get(color, Helpers::ColorInput::G) / scalar,
+			Helpers::Get(color, Helpers::ColorInput::B) / scalar,
+			Helpers::Get(color, Helpers::ColorInput::A));
+	}
+
+	template<typename T> constexpr void operator*=(Vector4<T>& vector, const T scalar) { vector = vector * scalar; }
+	template<typename T> constexpr void operator*=(Color4<T>& color, const T scalar) { color = color * scalar; }
+	template<typename T> constexpr void operator*=(Color4<T>& color, const Color4<T>& colorOther) { color.Hadamard(colorOther); }
+	template<typename T> constexpr void operator/=(Vector4<T>& vector, const T scalar) { vector = vector / scalar; }
+	template<typename T> constexpr void operator/=(Color4<T>& color, const T scalar) { color = color / scalar; }
+
+	template<typename T> constexpr Point4<T> operator+(const Point4<T>& first, const Vector4<T>& second)
+	{
+		return MultiplyAdd(first, second, T(1));
+	}
+
+	template<typename T> constexpr Vector4<T> operator+(const Vector4<T>& first, const Vector4<T>& second)
+	{
+		return MultiplyAdd(first, second, T(1));
+	}
+
+	template<typename T> constexpr Color4<T> operator+(const Color4<T>& first, const Color4<T>& second)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(first, Helpers::ColorInput::R) + Helpers::Get(second, Helpers::ColorInput::R),
+			Helpers::Get(first, Helpers::ColorInput::G) + Helpers::Get(second, Helpers::ColorInput::G),
+			Helpers::Get(first, Helpers::ColorInput::B) + Helpers::Get(second, Helpers::ColorInput::B),
+			Helpers::Get(first, Helpers::ColorInput::A) + Helpers::Get(second, Helpers::ColorInput::A));
+	}
+
+	template<typename T> constexpr Point4<T> operator-(const Point4<T>& first, const Vector4<T>& second)
+	{
+		return MultiplyAdd(first, second, T(-1));
+	}
+
+	template<typename T> constexpr Vector4<T> operator-(const Point4<T>& first, const Point4<T>& second)
+	{
+		return Helpers::MakeVector(
+			Helpers::Get(first, Helpers::Coordinate::X) - Helpers::Get(second, Helpers::Coordinate::X),
+			Helpers::Get(first, Helpers::Coordinate::Y) - Helpers::Get(second, Helpers::Coordinate::Y),
+			Helpers::Get(first, Helpers::Coordinate::Z) - Helpers::Get(second, Helpers::Coordinate::Z));
+	}
+
+	template<typename T> constexpr Vector4<T> operator-(const Vector4<T>& first, const Vector4<T>& second)
+	{
+		return Helpers::MakeVector(
+			Helpers::Get(first, Helpers::Coordinate::X) - Helpers::Get(second, Helpers::Coordinate::X),
+			Helpers::Get(first, Helpers::Coordinate::Y) - Helpers::Get(second, Helpers::Coordinate::Y),
+			Helpers::Get(first, Helpers::Coordinate::Z) - Helpers::Get(second, Helpers::Coordinate::Z));
+	}
+
+	template<typename T> constexpr Color4<T> operator-(const Color4<T>& first, const Color4<T>& second)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(first, Helpers::ColorInput::R) - Helpers::Get(second, Helpers::ColorInput::R),
+			Helpers::Get(first, Helpers::ColorInput::G) - Helpers::Get(second, Helpers::ColorInput::G),
+			Helpers::Get(first, Helpers::ColorInput::B) - Helpers::Get(second, Helpers::ColorInput::B),
+			Helpers::Get(first, Helpers::ColorInput::A) - Helpers::Get(second, Helpers::ColorInput::A));
+	}
+
+	template<typename T> constexpr Point4<T> MultiplyAdd(const Point4<T>& point, const Vector4<T>& vector, const T scale)
+	{
+		return Helpers::MakePoint(
+			Helpers::Get(point, Helpers::Coordinate::X) + Helpers::Get(vector, Helpers::Coordinate::X) * scale,
+			Helpers::Get(point, Helpers::Coordinate::Y) + Helpers::Get(vector, Helpers::Coordinate::Y) * scale,
+			Helpers::Get(point, Helpers::Coordinate::Z) + Helpers::Get(vector, Helpers::Coordinate::Z) * scale);
+	}
+
+	template<typename T> constexpr Vector4<T> MultiplyAdd(const Vector4<T>& accumulated, const Vector4<T>& vector, const T scale)
+	{
+		return Helpers::MakeVector(
+			Helpers::Get(accumulated, Helpers::Coordinate::X) + Helpers::Get(vector, Helpers::Coordinate::X) * scale,
+			Helpers::Get(accumulated, Helpers::Coordinate::Y) + Helpers::Get(vector, Helpers::Coordinate::Y) * scale,
+			Helpers::Get(accumulated, Helpers::Coordinate::Z) + Helpers::Get(vector, Helpers::Coordinate::Z) * scale);
+	}
+
+	template<typename T> constexpr Color4<T> MultiplyAdd(const Color4<T>& accumulated, const Color4<T>& color, const T scale)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(accumulated, Helpers::ColorInput::R) + Helpers::Get(color, Helpers::ColorInput::R) * scale,
+			Helpers::Get(accumulated, Helpers::ColorInput::G) + Helpers::Get(color, Helpers::ColorInput::G) * scale,
+			Helpers::Get(accumulated, Helpers::ColorInput::B) + Helpers::Get(color, Helpers::ColorInput::B) * scale,
+			Helpers::Get(accumulated, Helpers::ColorInput::A));
+	}
+
+	template<typename T> constexpr Color4<T> MultiplyColors(const Color4<T>& first, const Color4<T>& second, const T scale)
+	{
+		return Helpers::MakeColor(
+			Helpers::Get(first, Helpers::ColorInput::R) * Helpers::Get(second, Helpers::ColorInput::R) * scale,
+			Helpers::Get(first, Helpers::ColorInput::G) * Helpers::Get(second, Helpers::ColorInput::G) * scale,
+			Helpers::Get(first, Helpers::ColorInput::B) * Helpers::Get(second, Helpers::ColorInput::B) * scale,
+			Helpers::Get(first, Helpers::ColorInput::A) * Helpers::Get(second, Helpers::ColorInput::A));
+	}
+#pragma endregion
+
+	template<template<typename> typename T, typename U> constexpr auto operator== (const T<U>& first, const T<U>& second)
+		->std::enable_if_t<IsComparable<T<U>>::value, bool>
+	{
+		return
+			Equals<U>(Helpers::Get(first, Helpers::Coordinate::X), Helpers::Get(second, Helpers::Coordinate::X)) &&
+			Equals<U>(Helpers::Get(first, Helpers::Coordinate::Y), Helpers::Get(second, Helpers::Coordinate::Y)) &&
+			Equals<U>(Helpers::Get(first, Helpers::Coordinate::Z), Helpers::Get(second, Helpers::Coordinate::Z));
+	}
 }
 
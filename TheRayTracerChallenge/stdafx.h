@@ -8,6 +8,8 @@
 #include "targetver.h"
 
 // Headers for CppUnitTest
+#ifdef _MSC_VER
 #include "CppUnitTest.h"
+#endif
 
 // TODO: reference additional headers your program requires here